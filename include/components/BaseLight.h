@@ -3,31 +3,21 @@
 #include <math/Vector3f.h>
 
 #include <graphics/Shader.h>
-#include <graphics/Attenuation.h>
 
 #include <components/GameComponent.h>
-#include <components/SharedGlobals.h>
 
 #include <string>
 #include <sstream>
 #include <iomanip>
 #include <exception>
 
+// Subclasses register themselves with LightStorage, which is what the
+// light passes read
 struct BaseLight : public GameComponent {
-	// Point Light
-	Attenuation attenuation;
-	Vector3f position;
-	float range;
-
-	// Spot Light
-	float cutoff;
-
 	Vector3f color;
 
 	float intensity;
 
-	Shader *shader;
-
 	BaseLight(const Vector3f &color, const float &intensity)
 		: intensity(intensity)
 	{
@@ -79,12 +69,6 @@ struct BaseLight : public GameComponent {
 	{
 	}
 
-	void add_to_rendering_engine(bool id) override
-	{
-		SharedGlobals::get_instance().add_to_lights(
-			static_cast<void *>(this));
-	}
-
     private:
 	void input(float delta) override {};
 	void update(float delta) override {};
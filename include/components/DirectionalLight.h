@@ -2,10 +2,9 @@
 
 #include <math/Vector3f.h>
 
-#include <graphics/ForwardDirectional.h>
+#include <graphics/LightStorage.h>
 
 #include <components/BaseLight.h>
-#include <components/SharedGlobals.h>
 
 #include <string>
 
@@ -13,14 +12,17 @@ struct DirectionalLight : public BaseLight {
 	DirectionalLight(const Vector3f &color, const float &intensity)
 		: BaseLight(color, intensity)
 	{
-		shader = &ForwardDirectional::get_instance();
 	}
 
 	DirectionalLight(const std::string &hex, const float &intensity)
 		: BaseLight(hex, intensity)
 	{
-		shader = &ForwardDirectional::get_instance();
 	}
 
 	DirectionalLight() = default;
+
+	void add_to_rendering_engine(bool id) override
+	{
+		LightStorage::get_instance().add(this);
+	}
 };
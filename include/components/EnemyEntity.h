@@ -192,11 +192,18 @@ class EnemyEntity : public Entity {
 		new_stage =
 			4 - (hp <= 75) - (hp <= 50) - (hp <= 25) - (hp <= 0);
 
+		// The current diffuse stays until the next one is uploaded,
+		// unless the stage changes again in the meantime
 		if (new_stage != old_stage) {
 			old_stage = new_stage;
-			mat.add_property(
-				"diffuse",
-				Texture::load_texture(diffuses[new_stage]));
+			int stage = new_stage;
+			Texture::load_texture_async(
+				diffuses[stage],
+				[stage](std::shared_ptr<void> texture) {
+					if (stage == old_stage) {
+						mat.set_diffuse(texture);
+					}
+				});
 		}
 	}
 
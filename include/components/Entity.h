@@ -46,12 +46,8 @@ class Entity : public GameObject {
 					    Mesh::MeshPhysicsType::ENTITY);
 		Material material;
 
-		material.add_property("diffuse",
-				      Texture::load_texture(diffuse_path));
-
-		material.add_property(
-			"specular", std::shared_ptr<void>(new Specular{ 0, 0 },
-							  Specular::deleter));
+		material.set_diffuse(Texture::load_texture(diffuse_path));
+		material.set_specular({ 0, 0 });
 
 		this->add_component(this->mesh =
 					    new MeshRenderer(mesh, material));
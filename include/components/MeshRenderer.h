@@ -8,12 +8,24 @@
 
 #include <components/GameComponent.h>
 
+#include <array>
+
 class MeshRenderer : public GameComponent {
     private:
 	Mesh mesh;
 
 	Material material;
 
+	// Projected bounding sphere radius, in half viewport heights, below
+	// which each successive LOD takes over
+	static const std::array<float, 3> LOD_SCREEN_SIZE;
+
+	// Fraction a threshold must be crossed by before switching back,
+	// so meshes near a boundary don't pop between LODs every frame
+	static const float LOD_HYSTERESIS;
+
+	void select_lod();
+
     public:
 	MeshRenderer() = delete;
 
@@ -2,10 +2,10 @@
 
 #include <math/Vector3f.h>
 
-#include <graphics/ForwardPoint.h>
+#include <graphics/Attenuation.h>
+#include <graphics/LightStorage.h>
 
 #include <components/BaseLight.h>
-#include <components/SharedGlobals.h>
 
 #include <cmath>
 #include <string>
@@ -14,6 +14,9 @@
 struct PointLight : public BaseLight {
 	const int COLOR_DEPTH = 1 << 16;
 
+	Attenuation attenuation;
+	float range;
+
 	PointLight() = default;
 
 	PointLight(const Vector3f &color, const float &intensity,
@@ -27,8 +30,6 @@ struct PointLight : public BaseLight {
 		c -= COLOR_DEPTH * intensity * std::max(d, std::max(e, f));
 
 		this->range = (-b + std::sqrt(b * b - 4 * a * c)) / (2 * a);
-
-		this->shader = &ForwardPoint::get_instance();
 	}
 
 	PointLight(const std::string &color, const float &intensity,
@@ -42,7 +43,10 @@ struct PointLight : public BaseLight {
 		c -= COLOR_DEPTH * intensity * std::max(d, std::max(e, f));
 
 		this->range = (-b + std::sqrt(b * b - 4 * a * c)) / (2 * a);
+	}
 
-		this->shader = &ForwardPoint::get_instance();
+	void add_to_rendering_engine(bool id) override
+	{
+		LightStorage::get_instance().add(this);
 	}
 };
@@ -4,7 +4,7 @@
 
 #include <btBulletDynamicsCommon.h>
 
-#include <unordered_set>
+#include <vector>
 
 class SharedGlobals {
     public:
@@ -15,7 +15,6 @@ class SharedGlobals {
 
     private:
 	SharedGlobals();
-	std::unordered_set<void *> lights;
 
     public:
 	btDiscreteDynamicsWorld *dynamics_world;
@@ -25,14 +24,10 @@ class SharedGlobals {
 	const int GRAVITY = 1.0f;
 
 	Vector3f active_ambient_light;
-	void *active_light = nullptr;
 	void *main_camera = nullptr;
+	void *skybox = nullptr;
 	int w_width = 1, w_height = 1;
 	bool resized = false;
 	void *window = nullptr;
 	static void *player_entity, *enemy_entity;
-
-	void add_to_lights(void *light) noexcept;
-	std::unordered_set<void *> &get_lights();
-	void clear_lights();
 };
\ No newline at end of file
@@ -5,63 +5,48 @@
 #include <core/Input.h>
 
 #include <graphics/Mesh.h>
+#include <graphics/Vertex.h>
 #include <graphics/Shader.h>
 #include <graphics/Texture.h>
-#include <graphics/Specular.h>
+#include <graphics/Material.h>
+#include <graphics/ForwardSkybox.h>
 
 #include <components/SharedGlobals.h>
-#include <components/MeshRenderer.h>
 #include <components/GameObject.h>
 #include <components/GameComponent.h>
 
 #include <string>
+#include <vector>
 
+// Drawn by RenderingEngine after the opaque passes, not by a MeshRenderer
 class Skybox : public GameObject {
 	Vector3f rotate_sens;
+	Mesh cube;
+	Material material;
 
-    public:
-	Skybox(const std::string &mesh_path, const std::string &texture_path,
-	       const Vector3f &rotate_sens = { 1, 1, 1 })
-		: rotate_sens(rotate_sens)
+	static Mesh create_cube()
 	{
-		Mesh skbox = Mesh::load_mesh(mesh_path);
-		Material skmaterial;
-
-		skmaterial.add_property("diffuse",
-					Texture::load_texture(texture_path));
-
-		skmaterial.add_property(
-			"specular", std::shared_ptr<void>(new Specular{ 0, 0 },
-							  Specular::deleter));
-
-		this->add_component(new MeshRenderer(skbox, skmaterial));
-		this->transform.set_scale(5);
+		std::vector<Vertex> vertices;
+		for (int i = 0; i < 8; i++) {
+			vertices.push_back(Vertex({ i & 1 ? 1.0f : -1.0f,
+						    i & 2 ? 1.0f : -1.0f,
+						    i & 4 ? 1.0f : -1.0f }));
+		}
+		std::vector<int> indices = { 0, 2, 3, 0, 3, 1, 4, 5, 7,
+					     4, 7, 6, 0, 1, 5, 0, 5, 4,
+					     2, 6, 7, 2, 7, 3, 0, 4, 6,
+					     0, 6, 2, 1, 3, 7, 1, 7, 5 };
+		return Mesh(vertices, indices);
 	}
 
-	void render(Shader &shader) override
+    public:
+	Skybox(const std::string &texture_path,
+	       const Vector3f &rotate_sens = { 1, 1, 1 })
+		: rotate_sens(rotate_sens)
+		, cube(create_cube())
 	{
-		Vector3f previous_ambient_light =
-			SharedGlobals::get_instance().active_ambient_light;
-
-		float intensity = 0;
-		BaseLight *tmp = static_cast<BaseLight *>(
-			SharedGlobals::get_instance().active_light);
-
-		if (tmp != nullptr) {
-			intensity = tmp->intensity;
-		}
-
-		SharedGlobals::get_instance().active_ambient_light = { 1, 1,
-								       1 };
-
-		GameObject::render(shader);
-
-		if (tmp != nullptr) {
-			tmp->intensity = intensity;
-		}
-
-		SharedGlobals::get_instance().active_ambient_light =
-			previous_ambient_light;
+		material.set_cubemap(Texture::load_cubemap(texture_path));
+		SharedGlobals::get_instance().skybox = this;
 	}
 
 	void update(float delta) override
@@ -74,12 +59,14 @@ class Skybox : public GameObject {
 			.rotate({ 0, 0, 1 },
 				to_radians(delta * rotate_sens.getZ()));
 
-		Transform *camera_transform =
-			static_cast<Camera *>(
-				SharedGlobals::get_instance().main_camera)
-				->get_parent_transform();
-
-		transform.set_translation(camera_transform->get_translation());
 		GameObject::update(delta);
 	}
-};
\ No newline at end of file
+
+	void render_sky()
+	{
+		ForwardSkybox &shader = ForwardSkybox::get_instance();
+		shader.use_program();
+		shader.update_uniforms(material.get_data());
+		cube.draw();
+	}
+};
@@ -3,13 +3,15 @@
 #include <math/Vector3f.h>
 
 #include <graphics/Attenuation.h>
-#include <graphics/ForwardSpot.h>
+#include <graphics/LightStorage.h>
 
 #include <components/PointLight.h>
 
 #include <string>
 
 struct SpotLight : public PointLight {
+	float cutoff;
+
 	SpotLight() = default;
 
 	SpotLight(const Vector3f &color, const float &intensity,
@@ -17,7 +19,6 @@ struct SpotLight : public PointLight {
 		: PointLight(color, intensity, attenuation)
 	{
 		this->cutoff = cutoff;
-		this->shader = &ForwardSpot::get_instance();
 	}
 
 	SpotLight(const std::string &hex, const float &intensity,
@@ -25,6 +26,10 @@ struct SpotLight : public PointLight {
 		: PointLight(hex, intensity, attenuation)
 	{
 		this->cutoff = cutoff;
-		this->shader = &ForwardSpot::get_instance();
+	}
+
+	void add_to_rendering_engine(bool id) override
+	{
+		LightStorage::get_instance().add(this);
 	}
 };
@@ -26,13 +26,17 @@ class Terrain : public GameObject {
 		Material material;
 
 		for (auto &[tex_type, tex_path] : texture_paths) {
-			material.add_property(tex_type,
-					      Texture::load_texture(tex_path));
+			if (tex_type == "diffuse") {
+				material.set_diffuse(
+					Texture::load_texture(tex_path));
+			} else {
+				material.add_property(
+					Material::intern(tex_type),
+					Texture::load_texture(tex_path));
+			}
 		}
 
-		material.add_property(
-			"specular", std::shared_ptr<void>(new Specular{ 0, 0 },
-							  Specular::deleter));
+		material.set_specular({ 0, 0 });
 
 		this->add_component(new MeshRenderer(mesh, material));
 
@@ -49,6 +49,10 @@ class Window {
 
 	int get_window_width() const noexcept;
 
+	int get_framebuffer_height() const noexcept;
+
+	int get_framebuffer_width() const noexcept;
+
 	Vector2f get_window_center() const noexcept;
 
 	void set_mouse_position(double x, double y);
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <misc/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+// Loads assets without stalling the render thread. Files are decoded on
+// worker threads, then a ready step on the render thread hands the data
+// to staged uploads. Those go through a small ring of pixel buffer objects
+// with at most the upload budget copied per frame, so a large texture is
+// spread over a few frames instead of one long hitch.
+class AssetLoader {
+    public:
+	AssetLoader(const AssetLoader &) = delete;
+
+	AssetLoader &operator=(const AssetLoader &) = delete;
+
+	static AssetLoader &get_instance();
+
+    private:
+	// A staging buffer is only refilled once the GPU has read it, with
+	// three of them that is almost never waited for
+	static constexpr int RING_SIZE = 3;
+	static constexpr std::size_t DEFAULT_UPLOAD_BUDGET = 4 << 20;
+	static constexpr int DEFAULT_THREAD_COUNT = 2;
+
+	struct Job {
+		std::function<void()> work;
+		std::function<void()> ready;
+		std::function<void()> failed;
+		std::exception_ptr error;
+	};
+
+	struct Upload {
+		GLuint texture; // 0 for buffer uploads
+		GLuint buffer;
+		int level;
+		int width;
+		int height;
+		GLenum format; // The internal format when compressed
+		GLenum type;
+		bool compressed; // Rows are of 4x4 blocks rather than texels
+		bool mipmaps; // Generated once complete
+		std::size_t row_size; // Bytes per row of texels or blocks
+		std::vector<unsigned char> data;
+		std::size_t uploaded; // Bytes
+		std::function<void()> done;
+	};
+
+	struct Slot {
+		GLuint buffer;
+		std::size_t capacity;
+		GLsync fence; // Set while the GPU may still read the buffer
+	};
+
+	std::deque<Job> queued; // Waiting for a worker
+	std::deque<Job> finished; // Waiting for update()
+	int decoding;
+
+	std::deque<Upload> uploads;
+	Slot ring[RING_SIZE];
+	int next_slot;
+	std::size_t upload_budget;
+	std::size_t uploaded_bytes;
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool stopping;
+
+	AssetLoader();
+
+	void work();
+
+	void stage();
+
+    public:
+	~AssetLoader();
+
+	// 0 decodes on the render thread during update()
+	void set_thread_count(int count);
+
+	int get_thread_count() const noexcept;
+
+	// work runs on a worker thread, ready on the render thread during a
+	// later update(). Anything work throws is rethrown from update(),
+	// after failed has run in place of ready to undo the load's setup
+	void load(std::function<void()> work, std::function<void()> ready,
+		  std::function<void()> failed = {});
+
+	// Allocates level 0 of a texture created by the caller, fills it a
+	// few rows per frame and generates its mipmaps once complete
+	void upload_texture(GLuint texture, int width, int height,
+			    GLenum internal_format, GLenum format, GLenum type,
+			    std::vector<unsigned char> pixels,
+			    std::function<void()> done);
+
+	// Fills one level of a texture whose storage the caller allocated,
+	// for mip chains that were generated offline
+	void upload_texture_level(GLuint texture, int level, int width,
+				  int height, GLenum format, GLenum type,
+				  std::vector<unsigned char> pixels,
+				  std::function<void()> done);
+
+	// The same for a block compressed level, a row of blocks at a time
+	void upload_compressed_level(GLuint texture, int level, int width,
+				     int height, GLenum internal_format,
+				     std::vector<unsigned char> blocks,
+				     std::function<void()> done);
+
+	// Allocates the buffer and fills it over as many frames as needed
+	void upload_buffer(GLuint buffer, std::vector<unsigned char> data,
+			   std::function<void()> done);
+
+	// Runs the ready steps and stages this frame's uploads, once per
+	// frame on the render thread
+	void update();
+
+	void set_upload_budget(std::size_t bytes) noexcept;
+
+	std::size_t get_upload_budget() const noexcept;
+
+	// Bytes staged by the last update()
+	std::size_t get_uploaded_bytes() const noexcept;
+
+	// Loads and uploads that haven't finished yet
+	int get_pending_count();
+};
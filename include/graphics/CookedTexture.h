@@ -0,0 +1,78 @@
+#pragma once
+
+#include <misc/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// A texture prepared offline: the full mip chain, filtered down from level
+// 0 and block compressed, so loading is a read and one upload per level.
+// Colour is filtered in linear light and stored in BC1 (opaque) or BC3,
+// single and two channel data in BC4 and BC5, HDR images as RGBA16F.
+class CookedTexture {
+    public:
+	enum class Format : std::uint32_t {
+		BC1,
+		BC3,
+		BC4,
+		BC5,
+		RGBA16F,
+	};
+
+    private:
+	Format format;
+	int width;
+	int height;
+	std::vector<std::vector<unsigned char> > levels; // Largest first
+
+    public:
+	CookedTexture();
+
+	// pixels holds 8-bit texels of 1 to 4 channels, rows tightly packed
+	static CookedTexture cook(const unsigned char *pixels, int width,
+				  int height, int channels);
+
+	// pixels holds RGBA half floats, as read from an EXR
+	static CookedTexture cook_hdr(const std::uint16_t *pixels, int width,
+				      int height);
+
+	// Where the cooked version of a source texture is kept
+	static std::string get_path(const std::string &source_path);
+
+	bool save(const std::string &path) const;
+
+	// Leaves the texture untouched and returns false if the file is
+	// missing, truncated or not a cooked texture of this version
+	bool load(const std::string &path);
+
+	Format get_format() const noexcept;
+
+	int get_width() const noexcept;
+
+	int get_height() const noexcept;
+
+	int get_level_count() const noexcept;
+
+	// Dimensions of a level, never below one texel
+	int get_level_width(int level) const noexcept;
+
+	int get_level_height(int level) const noexcept;
+
+	const std::vector<unsigned char> &get_level(int level) const;
+
+	// Moves a level's data out, once it is handed over to an upload
+	std::vector<unsigned char> take_level(int level);
+
+	bool is_compressed() const noexcept;
+
+	// For glTexStorage2D and glCompressedTexSubImage2D
+	GLenum get_internal_format() const noexcept;
+
+	// Bytes of one level and of one of its rows, a row of 4x4 blocks
+	// when compressed
+	std::size_t get_level_size(int level) const noexcept;
+
+	std::size_t get_row_size(int level) const noexcept;
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <misc/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <array>
+
+// Picks the offscreen scene resolution from the measured frame time, the
+// scene targets themselves live in the RenderingEngine frame graph
+class DynamicResolution {
+    public:
+	DynamicResolution(const DynamicResolution &) = delete;
+
+	DynamicResolution &operator=(const DynamicResolution &) = delete;
+
+	static DynamicResolution &get_instance();
+
+	static constexpr int QUERY_COUNT = 3;
+
+    private:
+	int window_width;
+	int window_height;
+
+	// Timer queries are read QUERY_COUNT frames late to avoid stalls
+	std::array<GLuint, QUERY_COUNT> queries;
+	std::array<bool, QUERY_COUNT> query_pending;
+	int query_index;
+	bool queries_created;
+	bool use_queries;
+	double frame_start;
+
+	bool enabled;
+	float min_scale;
+	float max_scale;
+	float scale;
+	double target_frame_time;
+	double smoothed_frame_time;
+	int cooldown;
+
+	DynamicResolution();
+
+	void read_queries();
+
+    public:
+	~DynamicResolution();
+
+	// Starts timing a frame presented at width x height
+	void begin_frame(int width, int height);
+
+	void end_frame();
+
+	// Feeds one frame time (seconds) to the scale controller
+	void report_frame_time(double frame_time) noexcept;
+
+	void set_enabled(bool enable) noexcept;
+
+	bool is_enabled() const noexcept;
+
+	void set_bounds(float min_scale, float max_scale) noexcept;
+
+	void set_target_frame_time(double frame_time) noexcept;
+
+	float get_scale() const noexcept;
+
+	int get_render_width() const noexcept;
+
+	int get_render_height() const noexcept;
+
+	// Scene targets are sized for max_scale, smaller scales render
+	// into a sub-rectangle so resizes never reallocate them
+	int get_storage_width() const noexcept;
+
+	int get_storage_height() const noexcept;
+};
@@ -9,8 +9,16 @@
 #include <graphics/Material.h>
 
 class ForwardAmbient : public Shader {
+	Uniform view_projection;
+	Uniform ambient_intensity;
+
+	// Per program, whether the last material replaced the scene ambient
+	bool ambient_overridden[2];
+
 	ForwardAmbient();
 
+	void set_pass_uniforms();
+
     public:
 	ForwardAmbient(const ForwardAmbient &) = delete;
 	ForwardAmbient &operator=(const ForwardAmbient &) = delete;
@@ -19,6 +27,11 @@ class ForwardAmbient : public Shader {
 
 	void load_shader();
 
-	void update_uniforms(Transform *transform,
-			     const Material &material) override;
+	// Uploads the camera and the scene ambient light to both programs,
+	// once per frame before the queue is flushed
+	void begin_pass();
+
+	// Only materials overriding the ambient light upload anything
+	// besides their texture
+	void update_uniforms(const MaterialData &material) override;
 };
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <math/Matrix4f.h>
+#include <math/Transform.h>
+
+#include <components/BaseCamera.h>
+
+#include <graphics/Shader.h>
+#include <graphics/Material.h>
+
+#include <graphics/LightStorage.h>
+
+// Shades up to LIGHTS_PER_PASS lights of every type in one additive pass,
+// the active light index of LightStorage selects the group of lights
+class ForwardMultiLight : public Shader {
+	Uniform view_projection;
+	Uniform eye_position;
+	Uniform specular_intensity;
+	Uniform specular_exponent;
+
+	ForwardMultiLight();
+
+	void set_pass_uniforms();
+
+    public:
+	static constexpr int LIGHTS_PER_PASS = 4;
+
+	ForwardMultiLight(const ForwardMultiLight &) = delete;
+	ForwardMultiLight &operator=(const ForwardMultiLight &) = delete;
+
+	static ForwardMultiLight &get_instance();
+
+	// Number of passes needed to shade every light in the storage
+	static int get_pass_count(const LightStorage &lights) noexcept;
+
+	void load_shader();
+
+	using Shader::set_uniform;
+
+	void set_uniform(const std::string &uniform,
+			 const LightStorage::DirectionalLights &lights,
+			 int index) noexcept;
+
+	void set_uniform(const std::string &uniform,
+			 const LightStorage::PointLights &lights,
+			 int index) noexcept;
+
+	void set_uniform(const std::string &uniform,
+			 const LightStorage::SpotLights &lights,
+			 int index) noexcept;
+
+	// Uploads the camera and the active group of lights to both programs,
+	// once per pass before the queue is flushed
+	void begin_pass();
+
+	// Only the material changes between the draws of a pass
+	void update_uniforms(const MaterialData &material) override;
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <math/Matrix4f.h>
+#include <math/Transform.h>
+
+#include <components/BaseCamera.h>
+
+#include <graphics/Shader.h>
+#include <graphics/Material.h>
+
+class ForwardSkybox : public Shader {
+	ForwardSkybox();
+
+    public:
+	ForwardSkybox(const ForwardSkybox &) = delete;
+	ForwardSkybox &operator=(const ForwardSkybox &) = delete;
+
+	static ForwardSkybox &get_instance();
+
+	void load_shader();
+
+	void update_uniforms(const MaterialData &material) override;
+};
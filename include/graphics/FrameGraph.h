@@ -0,0 +1,137 @@
+#pragma once
+
+#include <misc/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <map>
+#include <string>
+#include <vector>
+#include <functional>
+
+// Passes are declared every frame in execution order with the attachments
+// they write and the textures they sample. compile() culls passes whose
+// results never reach an imported target and packs transient resources
+// with disjoint lifetimes into shared slots, execute() backs the slots
+// with pooled GL objects and runs the surviving passes.
+class FrameGraph {
+    public:
+	using Handle = int;
+
+	struct TextureDesc {
+		GLenum internal_format;
+		int width;
+		int height;
+
+		bool operator==(const TextureDesc &other) const noexcept;
+	};
+
+    private:
+	struct Resource {
+		std::string name;
+		TextureDesc desc;
+		bool imported;
+		GLuint framebuffer; // Imported targets only
+		bool sampled;
+		int first_use;
+		int last_use;
+		int slot;
+	};
+
+	struct Pass {
+		std::string name;
+		std::function<void()> execute;
+		std::vector<Handle> reads;
+		std::vector<Handle> writes;
+		bool clear;
+		int viewport_width;
+		int viewport_height;
+		bool live;
+	};
+
+	// Transient storage shared by resources with disjoint lifetimes,
+	// never-sampled resources become renderbuffers
+	struct Slot {
+		TextureDesc desc;
+		bool renderbuffer;
+	};
+
+	struct PhysicalResource {
+		TextureDesc desc;
+		bool renderbuffer;
+		GLuint id;
+		int serial;
+		bool used;
+	};
+
+	std::vector<Resource> resources;
+	std::vector<Pass> passes;
+	std::vector<int> order;
+	std::vector<Slot> slots;
+	bool compiled;
+
+	std::vector<PhysicalResource> pool;
+	std::vector<int> slot_physical;
+	std::map<std::vector<int>, GLuint> framebuffers;
+	int next_serial;
+	int framebuffer_binds;
+
+	void realize();
+
+	GLuint framebuffer_for(const std::vector<Handle> &attachments);
+
+    public:
+	class PassBuilder {
+		FrameGraph &graph;
+		int pass;
+
+	    public:
+		PassBuilder(FrameGraph &graph, int pass);
+
+		// Sampled as a texture
+		PassBuilder &read(Handle resource);
+
+		// Bound as an attachment, keeping earlier contents
+		PassBuilder &write(Handle resource);
+
+		// Contents of the attachments are discarded and cleared
+		PassBuilder &clear();
+
+		PassBuilder &viewport(int width, int height);
+	};
+
+	FrameGraph();
+
+	FrameGraph(const FrameGraph &) = delete;
+
+	FrameGraph &operator=(const FrameGraph &) = delete;
+
+	~FrameGraph();
+
+	void reset();
+
+	Handle create_texture(const std::string &name, const TextureDesc &desc);
+
+	// Existing framebuffer, e.g. 0 for the window, always kept alive
+	Handle import_target(const std::string &name, GLuint framebuffer,
+			     int width, int height);
+
+	PassBuilder add_pass(const std::string &name,
+			     std::function<void()> execute);
+
+	void compile();
+
+	void execute();
+
+	// Valid during execute()
+	GLuint get_texture(Handle resource) const;
+
+	GLuint get_framebuffer(Handle resource);
+
+	bool is_culled(const std::string &pass_name) const;
+
+	int get_live_pass_count() const noexcept;
+
+	int get_slot_count() const noexcept;
+
+	int get_framebuffer_binds() const noexcept;
+};
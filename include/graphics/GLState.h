@@ -0,0 +1,91 @@
+#pragma once
+
+#include <misc/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <array>
+
+class GLState {
+    public:
+	GLState(const GLState &) = delete;
+
+	GLState &operator=(const GLState &) = delete;
+
+	static GLState &get_instance();
+
+	static constexpr int MAX_TEXTURE_UNITS = 16;
+
+    private:
+	// Capabilities shadowed by set_capability, anything else passes through
+	static constexpr std::array<GLenum, 6> CAPABILITIES{
+		GL_BLEND,	GL_DEPTH_TEST,	 GL_CULL_FACE,
+		GL_DEPTH_CLAMP, GL_STENCIL_TEST, GL_SCISSOR_TEST
+	};
+
+	// Texture targets shadowed per unit
+	static constexpr std::array<GLenum, 2> TEXTURE_TARGETS{
+		GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP
+	};
+
+	GLuint program;
+	GLuint vertex_array;
+	int active_unit;
+	std::array<std::array<GLuint, MAX_TEXTURE_UNITS>,
+		   TEXTURE_TARGETS.size()>
+		textures;
+
+	std::array<bool, CAPABILITIES.size()> capabilities;
+	GLenum blend_source;
+	GLenum blend_destination;
+	GLenum depth_function;
+	GLboolean depth_write;
+	GLenum cull_mode;
+	std::array<int, 4> scissor_box; // Unknown until first set
+	std::array<float, 2> depth_bounds_range;
+
+	int issued_calls;
+	int saved_calls;
+	int last_issued_calls;
+	int last_saved_calls;
+
+	GLState();
+
+	bool skip(bool unchanged) noexcept;
+
+    public:
+	void use_program(GLuint shader_program) noexcept;
+
+	void bind_vertex_array(GLuint vao) noexcept;
+
+	void bind_texture(GLenum target, GLuint texture, int unit = 0) noexcept;
+
+	void set_capability(GLenum capability, bool enable) noexcept;
+
+	void blend_func(GLenum source, GLenum destination) noexcept;
+
+	void depth_func(GLenum function) noexcept;
+
+	void depth_mask(GLboolean enable) noexcept;
+
+	void cull_face(GLenum mode) noexcept;
+
+	void scissor(int x, int y, int width, int height) noexcept;
+
+	// GL_EXT_depth_bounds_test, enabled through GL_DEPTH_BOUNDS_TEST_EXT
+	void depth_bounds(float min_depth, float max_depth) noexcept;
+
+	// Called when objects are deleted. The cache drops its record of the
+	// name, so a new object reusing it isn't taken as already bound
+	void forget_program(GLuint shader_program) noexcept;
+
+	void forget_vertex_array(GLuint vao) noexcept;
+
+	void forget_texture(GLuint texture) noexcept;
+
+	void begin_frame() noexcept;
+
+	// Counters for the last completed frame
+	int get_issued_calls() const noexcept;
+
+	int get_saved_calls() const noexcept;
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <misc/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <graphics/Shader.h>
+#include <graphics/Material.h>
+#include <graphics/RenderQueue.h>
+#include <graphics/resource_management/MeshResource.h>
+
+#include <vector>
+
+class IndirectRenderer {
+    public:
+	IndirectRenderer(const IndirectRenderer &) = delete;
+
+	IndirectRenderer &operator=(const IndirectRenderer &) = delete;
+
+	static IndirectRenderer &get_instance();
+
+    private:
+	// Layout mandated by glMultiDrawElementsIndirect
+	struct DrawCommand {
+		GLuint count;
+		GLuint instance_count;
+		GLuint first_index;
+		GLint base_vertex;
+		GLuint base_instance;
+	};
+
+	// std430 layout of ObjectData in shaders/indirect*.vert
+	struct ObjectData {
+		float model[16];
+		GLuint material_index;
+		GLuint padding[3];
+	};
+
+	// Range of commands sharing a diffuse texture
+	struct Batch {
+		int material;
+		int first;
+		int count;
+	};
+
+	std::vector<unsigned char> pool_vertices; // VertexLayout::STATIC
+	std::vector<int> pool_indices;
+	bool pool_dirty;
+
+	GLuint vao;
+	GLuint vbo;
+	GLuint ebo;
+	GLuint object_index_vbo;
+	GLuint object_ssbo;
+	GLuint material_ssbo;
+	GLuint command_buffer;
+	int object_index_capacity;
+
+	std::vector<DrawCommand> commands;
+	std::vector<ObjectData> objects;
+	std::vector<float> materials;
+	std::vector<Batch> batches;
+
+	bool enabled;
+
+	IndirectRenderer();
+
+	void init();
+
+	void upload_pool();
+
+    public:
+	~IndirectRenderer();
+
+	static bool is_supported();
+
+	// Drawn from the shared pool; skinned meshes use their skinned output
+	static bool is_pooled(const DrawGroup &group);
+
+	bool is_enabled() const noexcept;
+
+	void set_enabled(bool enable) noexcept;
+
+	void add_geometry(MeshResource &resource,
+			  const std::vector<unsigned char> &vertices,
+			  const std::vector<int> &indices);
+
+	void build(const std::vector<DrawPacket> &packets,
+		   const std::vector<DrawGroup> &groups);
+
+	void draw(Shader &shader);
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <math/Vector3f.h>
+#include <math/Matrix4f.h>
+
+#include <graphics/LightStorage.h>
+
+// Screen-space extent of the lights' influence, used to scissor and depth
+// bound the additive passes. Bounds are conservative: a light whose volume
+// crosses the camera plane covers the whole screen.
+class LightBounds {
+    public:
+	struct Rect {
+		int x;
+		int y;
+		int width;
+		int height;
+
+		// Window space depth range, [0, 1]
+		float min_depth;
+		float max_depth;
+
+		// Nothing on screen is lit
+		bool empty;
+
+		// Scissor and depth bounds can't reject anything
+		bool full;
+	};
+
+	static Rect empty_rect() noexcept;
+
+	static Rect full_rect(int width, int height) noexcept;
+
+	// Bounding sphere of the part of the range sphere inside the cone,
+	// cutoff being the cosine of the half angle
+	static void spot_sphere(const Vector3f &position,
+				const Vector3f &direction, float range,
+				float cutoff, Vector3f &center, float &radius);
+
+	static Rect project_sphere(const Vector3f &center, float radius,
+				   const Matrix4f &view_projection, int width,
+				   int height);
+
+	static Rect merge(const Rect &a, const Rect &b) noexcept;
+
+	// Union of lights [first, first + count) of every type, directional
+	// lights cover the whole screen
+	static Rect group_bounds(const LightStorage &lights, int first,
+				 int count, const Matrix4f &view_projection,
+				 int width, int height);
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <math/Vector3f.h>
+
+#include <graphics/Attenuation.h>
+
+#include <vector>
+
+struct DirectionalLight;
+struct PointLight;
+struct SpotLight;
+
+// Lights split by type into parallel arrays, in registration order. World
+// positions and directions are refreshed once per frame by update().
+class LightStorage {
+    public:
+	LightStorage(const LightStorage &) = delete;
+
+	LightStorage &operator=(const LightStorage &) = delete;
+
+	static LightStorage &get_instance();
+
+	struct DirectionalLights {
+		std::vector<DirectionalLight *> sources;
+		std::vector<Vector3f> color;
+		std::vector<float> intensity;
+		std::vector<Vector3f> direction;
+	};
+
+	struct PointLights {
+		std::vector<PointLight *> sources;
+		std::vector<Vector3f> color;
+		std::vector<float> intensity;
+		std::vector<Attenuation> attenuation;
+		std::vector<float> range;
+		std::vector<Vector3f> position;
+	};
+
+	// Mirrors the shaders' SpotLight { PointLight point_light; ... }
+	struct SpotLights {
+		PointLights point;
+		std::vector<SpotLight *> sources;
+		std::vector<Vector3f> direction;
+		std::vector<float> cutoff;
+	};
+
+    private:
+	DirectionalLights directional;
+	PointLights point;
+	SpotLights spot;
+
+	int active;
+
+	LightStorage();
+
+    public:
+	void add(DirectionalLight *light);
+
+	void add(PointLight *light);
+
+	void add(SpotLight *light);
+
+	void clear() noexcept;
+
+	void update();
+
+	const DirectionalLights &get_directional() const noexcept;
+
+	const PointLights &get_point() const noexcept;
+
+	const SpotLights &get_spot() const noexcept;
+
+	// Index of the light being drawn within its type's arrays, or of the
+	// group of lights for ForwardMultiLight
+	void set_active(int index) noexcept;
+
+	int get_active() const noexcept;
+
+	int size() const noexcept;
+};
@@ -1,22 +1,79 @@
 #pragma once
 
+#include <math/Vector3f.h>
+
+#include <graphics/Specular.h>
+
 #include <string>
 #include <memory>
-#include <unordered_map>
+#include <vector>
+#include <utility>
+#include <functional>
+
+class Texture;
+class Skeleton;
+
+// Fixed layout read by the shaders every draw, no lookups by name
+struct MaterialData {
+	enum Flags : unsigned {
+		HAS_DIFFUSE = 1 << 0,
+		HAS_CUBEMAP = 1 << 1,
+		HAS_AMBIENT = 1 << 2, // Overrides the scene ambient light
+		SKINNED = 1 << 3
+	};
+
+	Texture *diffuse = nullptr;
+	Texture *cubemap = nullptr;
+	Specular specular;
+	Vector3f ambient;
+	Skeleton *skeleton = nullptr;
+	unsigned flags = 0;
+
+	// Owners of the textures above
+	std::shared_ptr<void> diffuse_owner;
+	std::shared_ptr<void> cubemap_owner;
+
+	// Anything else, keyed by Material::intern ids and sorted by id
+	std::vector<std::pair<int, std::shared_ptr<void> > > extras;
+
+	bool operator==(const MaterialData &other) const noexcept;
+};
 
+// Handle to a MaterialData slot in the MaterialTable; copies get their
+// own slot, so changing one copy never affects another
 class Material {
-	std::unordered_map<std::string, std::shared_ptr<void> > property;
+	int index;
 
     public:
-	static const Material None;
+	using PropertyID = int;
+
+	static PropertyID intern(const std::string &name);
 
 	Material();
+	Material(const Material &other);
+	Material &operator=(const Material &other);
 	~Material();
 
-	Material &add_property(const std::string &name,
-			       std::shared_ptr<void> texture);
+	Material &set_diffuse(std::shared_ptr<void> texture);
+
+	Material &set_cubemap(std::shared_ptr<void> texture);
+
+	Material &set_specular(const Specular &specular);
+
+	Material &set_ambient(const Vector3f &ambient);
+
+	Material &set_skeleton(Skeleton *skeleton);
+
+	Material &add_property(PropertyID id, std::shared_ptr<void> property);
+
+	// nullptr when the material has no such property
+	void *get_property(PropertyID id) const noexcept;
+
+	void delete_property(PropertyID id) noexcept;
+
+	int get_index() const noexcept;
 
-	void *get_property(const std::string &name) const noexcept;
+	const MaterialData &get_data() const noexcept;
 
-	void delete_property(const std::string &name) noexcept;
+	bool operator==(const Material &other) const noexcept;
 };
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <graphics/Material.h>
+
+#include <vector>
+
+// Contiguous storage for every live material, draw packets refer to
+// materials by their index in here
+class MaterialTable {
+    public:
+	MaterialTable(const MaterialTable &) = delete;
+
+	MaterialTable &operator=(const MaterialTable &) = delete;
+
+	static MaterialTable &get_instance();
+
+    private:
+	std::vector<MaterialData> materials;
+	std::vector<int> free_slots;
+
+	MaterialTable();
+
+    public:
+	int allocate();
+
+	void release(int index);
+
+	MaterialData &get(int index) noexcept;
+
+	const MaterialData &get(int index) const noexcept;
+
+	int size() const noexcept;
+};
@@ -16,9 +16,29 @@ class Mesh {
     private:
 	std::shared_ptr<MeshResource> buffers;
 
+	int lod = 0;
+
+	// Buffer contents ready for GL, built without touching it
+	struct Staging {
+		std::vector<unsigned char> vertices;
+		std::vector<unsigned char> indices;
+		std::vector<unsigned char> pool_vertices; // Empty if STATIC
+		std::vector<int> pool_indices;
+	};
+
 	void calculate_normals(std::vector<Vertex> &vertices,
 			       std::vector<int> &indices);
 
+	// Fills in everything but the GL objects
+	Staging prepare(const std::vector<Vertex> &vertices,
+			std::vector<int> indices,
+			const std::vector<std::vector<int> > &lod_indices);
+
+	// Over the vbo and ebo, once they hold the data
+	void create_vertex_array();
+
+	void add_geometry(const Staging &staging);
+
     public:
 	enum class MeshPhysicsType {
 		NO_PHYSICS,
@@ -33,14 +53,29 @@ class Mesh {
 
 	void draw() const;
 
+	// A non-zero vao replaces the mesh's own, it has to index through
+	// the mesh's element buffer (e.g. skinned output)
+	void draw_instanced(GLuint instance_buffer, std::size_t offset,
+			    int count, GLuint vao = 0) const;
+
+	MeshResource *get_resource() const noexcept;
+
+	int get_lod() const noexcept;
+
+	void set_lod(int lod) noexcept;
+
+	int get_lod_count() const noexcept;
+
 	void reset_mesh();
 
 	void update_physics(int id);
 
+	// lod_indices are simplified index lists over the same vertices
 	void add_vertices(std::vector<Vertex> vertices,
 			  std::vector<int> indices, bool normals = false,
 			  MeshPhysicsType mesh_physics_type =
-				  MeshPhysicsType::NO_PHYSICS);
+				  MeshPhysicsType::NO_PHYSICS,
+			  const std::vector<std::vector<int> > &lod_indices = {});
 
 	static Mesh load_mesh(const std::string &file_path,
 			      MeshPhysicsType mesh_physics_type =
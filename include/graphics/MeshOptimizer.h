@@ -0,0 +1,50 @@
+#pragma once
+
+#include <graphics/Vertex.h>
+
+#include <vector>
+
+class MeshOptimizer {
+    public:
+	// Size of the simulated post-transform vertex cache
+	static const int CACHE_SIZE = 32;
+
+	// Forsyth's linear-speed vertex cache optimization
+	static void optimize_vertex_cache(std::vector<int> &indices,
+					  int vertex_count);
+
+	// Splits the cache-ordered triangles into clusters and sorts them
+	// front-to-back from the outside in (Sander et al., Tipsify), so
+	// early depth rejection hides more fragments. A cluster is only
+	// split where the cache ratio degrades by less than threshold
+	static void optimize_overdraw(std::vector<int> &indices,
+				      const std::vector<Vertex> &vertices,
+				      float threshold = 1.05f);
+
+	// Reorders vertices by first use and drops unreferenced ones
+	static void optimize_vertex_fetch(std::vector<Vertex> &vertices,
+					  std::vector<int> &indices);
+
+	// Quadric-error edge collapse down to target_index_count, without
+	// exceeding target_error (relative to the mesh radius). Vertices
+	// sharing a position collapse together. Open borders and junctions
+	// of UV or bone-weight seams never move, other seam vertices only
+	// slide along the seam. The result indexes into the same vertices,
+	// so LODs can share one vertex buffer
+	static std::vector<int> simplify(const std::vector<int> &indices,
+					 const std::vector<Vertex> &vertices,
+					 int target_index_count,
+					 float target_error,
+					 float *result_error = nullptr);
+
+	// Chain of successively halved index lists, excluding the base mesh.
+	// Stops early once a level no longer shrinks meaningfully
+	static std::vector<std::vector<int> >
+	generate_lods(const std::vector<int> &indices,
+		      const std::vector<Vertex> &vertices, int max_lods = 3);
+
+	// Average cache miss ratio: transformed vertices per triangle
+	static float compute_acmr(const std::vector<int> &indices,
+				  int vertex_count,
+				  int cache_size = CACHE_SIZE);
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <misc/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <math/Matrix4f.h>
+#include <math/Transform.h>
+
+#include <graphics/Mesh.h>
+#include <graphics/Shader.h>
+#include <graphics/Material.h>
+
+#include <vector>
+
+// Materials are referenced by their MaterialTable index
+struct DrawPacket {
+	const Mesh *mesh;
+	int material;
+	Matrix4f model;
+};
+
+struct DrawGroup {
+	const Mesh *mesh;
+	int material;
+	int first;
+	int count;
+};
+
+class RenderQueue {
+    public:
+	RenderQueue(const RenderQueue &) = delete;
+
+	RenderQueue &operator=(const RenderQueue &) = delete;
+
+	static RenderQueue &get_instance();
+
+    private:
+	std::vector<DrawPacket> packets;
+	std::vector<DrawGroup> groups;
+	std::vector<float> instance_data;
+
+	GLuint instance_vbo;
+	bool uploaded;
+
+	RenderQueue();
+
+	void build_groups();
+
+    public:
+	~RenderQueue();
+
+	void submit(const Mesh &mesh, const Material &material,
+		    Transform *transform);
+
+	// Runs the SkinningPass over the skinned groups, once per frame
+	// before the first flush
+	void skin();
+
+	void flush(Shader &shader);
+
+	void clear() noexcept;
+
+	int get_group_count() const noexcept;
+
+	int get_packet_count() const noexcept;
+};
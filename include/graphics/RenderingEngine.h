@@ -2,6 +2,8 @@
 
 #include <math/Vector3f.h>
 
+#include <graphics/FrameGraph.h>
+
 #include <components/BaseCamera.h>
 
 #include <components/GameObject.h>
@@ -25,6 +27,8 @@ class RenderingEngine {
 
 	static void clear_screen();
 
+	FrameGraph frame_graph;
+
 	RenderingEngine();
 
     public:
@@ -11,41 +11,76 @@
 
 #include <graphics/Material.h>
 #include <graphics/Specular.h>
+#include <graphics/ShaderPreprocessor.h>
 #include <graphics/resource_management/ShaderResource.h>
 
 #include <string>
+#include <vector>
 #include <memory>
 #include <utility>
 #include <unordered_map>
 
 class Shader {
+    public:
+	// A uniform's location in the direct and the indirect program, looked
+	// up once at load so per-draw updates skip the name
+	struct Uniform {
+		GLint direct;
+		GLint indirect;
+	};
+
     protected:
 	Transform const *transform;
 
     private:
-	struct __pair_hash {
-		template <class T1, class T2>
-		std::size_t operator()(const std::pair<T1, T2> &pair) const
-		{
-			std::size_t hash1 = std::hash<T1>{}(pair.first);
-			std::size_t hash2 = std::hash<T2>{}(pair.second);
-			// Combine the two hash values
-			return hash1 ^ (hash2 << 1);
-		}
+	struct VariantKey {
+		std::string vertex_filepath;
+		std::string fragment_filepath;
+		ShaderPreprocessor::Defines defines;
+		std::vector<std::string> feedback_varyings;
+
+		bool operator==(const VariantKey &) const = default;
+	};
+
+	struct __variant_hash {
+		std::size_t operator()(const VariantKey &key) const noexcept;
 	};
 	std::shared_ptr<ShaderResource> shader_resource;
-	static std::unordered_map<std::pair<std::string, std::string>,
-				  std::weak_ptr<ShaderResource>, __pair_hash>
-		shader_cache;
+	std::shared_ptr<ShaderResource> indirect_resource;
+	bool indirect;
+	std::vector<std::string> feedback_varyings;
 
-	std::string read_shader(const std::string &filepath) const;
+	static std::unordered_map<VariantKey, std::weak_ptr<ShaderResource>,
+				  __variant_hash>
+		shader_cache;
 
 	GLuint create_shader_module(const std::string &shader_source,
 				    GLuint module_type) const;
 
+	void load_program(const std::string &vertex_filepath,
+			  const std::string &fragment_filepath,
+			  std::shared_ptr<ShaderResource> &resource,
+			  const ShaderPreprocessor::Defines &defines);
+
+	ShaderResource *active_resource() const noexcept;
+
+	GLint active_location(const Uniform &uniform) const noexcept;
+
     protected:
+	// Both stages go through the ShaderPreprocessor with the defines, an
+	// empty fragment_filepath links a vertex-only program
 	void load(const std::string &vertex_filepath,
-		  const std::string &fragment_filepath);
+		  const std::string &fragment_filepath,
+		  const ShaderPreprocessor::Defines &defines = {});
+
+	// Captured by transform feedback, interleaved in this order. Must be
+	// set before load()
+	void set_feedback_varyings(std::vector<std::string> varyings);
+
+	// Same sources with INDIRECT defined
+	void load_indirect(const std::string &vertex_filepath,
+			   const std::string &fragment_filepath,
+			   ShaderPreprocessor::Defines defines = {});
 
     public:
 	Shader();
@@ -54,10 +89,19 @@ class Shader {
 
 	void use_program() const noexcept;
 
+	bool has_indirect() const noexcept;
+
+	void set_indirect(bool enable) noexcept;
+
+	bool is_indirect() const noexcept;
+
 	void add_uniform(const std::string &uniform);
 
 	GLuint get_uniform(const std::string &uniform) const;
 
+	// For a uniform already added
+	Uniform find_uniform(const std::string &uniform) const;
+
 	void set_uniform(const std::string &uniform, int value);
 
 	void set_uniform(const std::string &uniform, float value);
@@ -71,6 +115,15 @@ class Shader {
 	void set_uniform(const std::string &uniform, const Matrix4f &matrix,
 			 int count);
 
-	virtual void update_uniforms(Transform *transform,
-				     const Material &material) = 0;
+	void set_uniform(const Uniform &uniform, int value) noexcept;
+
+	void set_uniform(const Uniform &uniform, float value) noexcept;
+
+	void set_uniform(const Uniform &uniform,
+			 const Vector3f &value) noexcept;
+
+	void set_uniform(const Uniform &uniform,
+			 const Matrix4f &matrix) noexcept;
+
+	virtual void update_uniforms(const MaterialData &material) = 0;
 };
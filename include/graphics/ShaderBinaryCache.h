@@ -0,0 +1,38 @@
+#pragma once
+
+#include <misc/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <string>
+#include <cstdint>
+
+class ShaderBinaryCache {
+    public:
+	ShaderBinaryCache(const ShaderBinaryCache &) = delete;
+
+	ShaderBinaryCache &operator=(const ShaderBinaryCache &) = delete;
+
+	static ShaderBinaryCache &get_instance();
+
+    private:
+	std::string directory;
+	std::string driver;
+	bool supported;
+
+	ShaderBinaryCache();
+
+	std::string get_path(const std::string &sources) const;
+
+	static std::uint64_t hash(const std::string &data) noexcept;
+
+    public:
+	bool is_supported() const noexcept;
+
+	void set_directory(const std::string &directory);
+
+	// Linked program for these sources, or 0 when nothing usable is
+	// cached (missing, other driver, or rejected by glProgramBinary)
+	GLuint load(const std::string &sources);
+
+	void store(const std::string &sources, GLuint program);
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+
+// Expands #include "path" directives, resolved relative to the including
+// file and each pulled in at most once, and injects variant defines right
+// after the root file's #version line. #version lines of included files
+// are dropped, so every stage compiles against the root's version.
+class ShaderPreprocessor {
+    public:
+	// Ordered so equal sets compare and hash equal; an empty value
+	// defines a bare flag
+	using Defines = std::map<std::string, std::string>;
+
+	static std::string process(const std::string &filepath,
+				   const Defines &defines = {});
+
+	static std::size_t hash(const Defines &defines) noexcept;
+
+    private:
+	static void expand(const std::string &filepath,
+			   std::set<std::string> &included,
+			   const std::string &define_block, bool root,
+			   std::string &output);
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <misc/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <graphics/Mesh.h>
+#include <graphics/Material.h>
+#include <graphics/SkinningShader.h>
+#include <graphics/resource_management/MeshResource.h>
+
+#include <map>
+#include <vector>
+#include <utility>
+
+class Skeleton;
+
+// Skins every animated mesh once per frame with transform feedback. The
+// output is drawn through a STATIC-style vertex array by every pass, so
+// skinning cost doesn't grow with the number of lights. The bone palettes
+// of all skeletons go up in a single texture buffer upload, each mesh
+// only sets its palette offset
+class SkinningPass {
+    public:
+	SkinningPass(const SkinningPass &) = delete;
+
+	SkinningPass &operator=(const SkinningPass &) = delete;
+
+	static SkinningPass &get_instance();
+
+    private:
+	// Skinned position and normal, 3 x float each
+	static constexpr GLsizei OUTPUT_STRIDE = 6 * sizeof(float);
+
+	struct Output {
+		GLuint vbo;
+		GLuint vao;
+		int capacity; // Vertices
+		bool used;
+	};
+
+	struct Job {
+		const MeshResource *resource;
+		Output *output;
+		int palette_offset; // Texels
+	};
+
+	std::map<std::pair<const MeshResource *, const Skeleton *>, Output>
+		outputs;
+	std::vector<Job> jobs;
+
+	std::vector<float> palette;
+	std::map<const Skeleton *, int> palette_offsets;
+	GLuint palette_buffer;
+	GLuint palette_texture;
+
+	SkinningShader::Mode mode;
+	SkinningShader::Mode next_mode;
+
+	int skinned_vertices;
+	int last_skinned_vertices;
+
+	SkinningPass();
+
+	void init_output(Output &output, const MeshResource &resource);
+
+	void release(Output &output);
+
+    public:
+	~SkinningPass();
+
+	// Takes effect from the next begin_frame()
+	void set_mode(SkinningShader::Mode mode) noexcept;
+
+	SkinningShader::Mode get_mode() const noexcept;
+
+	void begin_frame() noexcept;
+
+	// Queues the mesh to be posed by the material's skeleton
+	void add(const Mesh &mesh, const MaterialData &material);
+
+	// Uploads the palettes, skins every queued mesh into its own buffer
+	// and releases the buffers of meshes that weren't queued
+	void execute();
+
+	// Draws the skinned output with the mesh's index buffer, 0 if the
+	// mesh wasn't skinned this frame
+	GLuint get_vertex_array(const Mesh &mesh,
+				const Skeleton *skeleton) const;
+
+	// Counter for the last completed frame
+	int get_skinned_vertices() const noexcept;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <math/Matrix4f.h>
+
+#include <graphics/Shader.h>
+#include <graphics/Material.h>
+
+#include <array>
+#include <vector>
+
+// Vertex-only transform feedback program writing skinned positions and
+// normals, used by the SkinningPass. Poses are read from a texture buffer
+// holding the bone palettes of every skinned mesh in the frame
+class SkinningShader : public Shader {
+    public:
+	enum class Mode {
+		// Skinning matrix rows and normal matrix rows, 6 texels
+		LINEAR,
+		// Rigid part of the bone as a dual quaternion, 2 texels.
+		// Bone scale is dropped
+		DUAL_QUATERNION
+	};
+
+    private:
+	Mode mode;
+
+	SkinningShader(Mode mode);
+
+    public:
+	SkinningShader(const SkinningShader &) = delete;
+	SkinningShader &operator=(const SkinningShader &) = delete;
+
+	static SkinningShader &get_instance(Mode mode = Mode::LINEAR);
+
+	// RGBA32F texels per bone in the palette
+	static int get_bone_texels(Mode mode) noexcept;
+
+	// Inverse transpose of the upper 3x3, up to scale, row-major
+	static std::array<float, 9> normal_matrix(const Matrix4f &bone);
+
+	// Real part (x, y, z, w) followed by the dual part
+	static std::array<float, 8> dual_quaternion(const Matrix4f &bone);
+
+	// Writes get_bone_texels(mode) * 4 floats for the bone
+	static void pack_bone(Mode mode, const Matrix4f &bone, float *texels);
+
+	// Appends get_bone_texels(mode) * 4 floats for the bone
+	static void pack_bone(Mode mode, const Matrix4f &bone,
+			      std::vector<float> &palette);
+
+	void load_shader();
+
+	void set_palette(GLuint texture, int offset);
+
+	// Poses come from the palette, nothing is taken from the material
+	void update_uniforms(const MaterialData &material) override;
+};
@@ -26,7 +26,25 @@ class Texture {
 
 	void bind() const;
 
+	// Prefers the cooked version of the texture when there is a current
+	// one, uploading its mip chain as is
 	static std::shared_ptr<void> load_texture(const std::string &file_path);
 
+	// Returns at once with a placeholder that becomes the texture when
+	// the AssetLoader has decoded and uploaded it, loaded is then called
+	// with the same handle. Safe to call mid-game
+	static std::shared_ptr<void> load_texture_async(
+		const std::string &file_path,
+		std::function<void(std::shared_ptr<void>)> loaded = {});
+
+	// Writes the cooked version of a texture next to it, offline. Throws
+	// if the texture can't be decoded, false if it can't be written
+	static bool cook_texture(const std::string &file_path);
+
+	// Converts an equirectangular image into a cubemap at load time,
+	// face_size defaults to a quarter of the image width
+	static std::shared_ptr<void> load_cubemap(const std::string &file_path,
+						  int face_size = 0);
+
 	bool operator==(const Texture &other) const noexcept;
 };
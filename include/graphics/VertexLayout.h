@@ -0,0 +1,46 @@
+#pragma once
+
+#include <misc/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <math/Vector3f.h>
+
+#include <graphics/Vertex.h>
+
+#include <vector>
+#include <cstdint>
+
+class VertexLayout {
+    public:
+	enum class Type { STATIC, SKINNED };
+
+    private:
+	Type type;
+	GLsizei stride;
+
+	VertexLayout(Type type, GLsizei stride);
+
+    public:
+	// Position (3 x float), normal (2_10_10_10_REV), UV (2 x half)
+	static const VertexLayout STATIC;
+	// STATIC followed by bone indices (4 x uint8) and weights (4 x unorm16)
+	static const VertexLayout SKINNED;
+
+	static const VertexLayout &get(Type type) noexcept;
+
+	// SKINNED if any vertex carries a bone weight, STATIC otherwise
+	static const VertexLayout &select(const std::vector<Vertex> &vertices);
+
+	Type get_type() const noexcept;
+
+	GLsizei get_stride() const noexcept;
+
+	std::vector<unsigned char> pack(const std::vector<Vertex> &vertices) const;
+
+	// Describe the layout on the bound VAO and GL_ARRAY_BUFFER
+	void apply() const;
+
+	static std::uint16_t to_half(float value) noexcept;
+
+	static std::uint32_t pack_normal(const Vector3f &normal) noexcept;
+};
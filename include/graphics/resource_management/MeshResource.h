@@ -3,6 +3,12 @@
 #include <misc/glad.h>
 #include <GLFW/glfw3.h>
 
+#include <math/Vector3f.h>
+
+#include <graphics/VertexLayout.h>
+
+#include <vector>
+
 class MeshResource {
     public:
 	GLuint vao;
@@ -11,6 +17,24 @@ class MeshResource {
 
 	int size;
 	int isize;
+	GLenum index_type; // GL_UNSIGNED_SHORT when the vertices allow
+
+	VertexLayout::Type layout;
+
+	// Index ranges inside ebo, lods[0] is the full mesh
+	struct LOD {
+		int first;
+		int count;
+	};
+	std::vector<LOD> lods;
+
+	// Local space bounding sphere, used for LOD selection
+	Vector3f center;
+	float radius;
+
+	// Offsets into the shared IndirectRenderer geometry pool, -1 if absent
+	int base_vertex;
+	int first_index;
 
 	MeshResource();
 	~MeshResource();
@@ -3,9 +3,18 @@
 #include <misc/glad.h>
 #include <GLFW/glfw3.h>
 
+#include <vector>
+#include <functional>
+
 class TextureResource {
     public:
 	GLuint id;
+	GLenum target;
+
+	// Set while an asynchronous load shows a placeholder, on_load runs
+	// once the real image replaces it
+	bool loading;
+	std::vector<std::function<void()> > on_load;
 
 	TextureResource();
 	~TextureResource();
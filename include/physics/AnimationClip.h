@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+struct aiAnimation;
+
+// Animation owned by the engine, resampled at a fixed rate so sampling is
+// index arithmetic. Keys are stored frame after frame with every channel's
+// components next to each other: translations and scales as 16-bit fixed
+// point inside each channel's range, rotations as the three smallest
+// quaternion components in 15 bits each with the index of the dropped one
+// spread over their low bits.
+class AnimationClip {
+    public:
+	static constexpr float SAMPLE_RATE = 30.0f;
+
+    private:
+	std::vector<std::string> channel_names;
+	float sample_rate;
+	float duration; // Seconds
+	int frame_count;
+
+	// Per channel and axis, value = min + key * step
+	std::vector<float> translation_min;
+	std::vector<float> translation_step;
+	std::vector<float> scale_min;
+	std::vector<float> scale_step;
+
+	std::vector<std::uint16_t> translation_keys;
+	std::vector<std::uint16_t> rotation_keys;
+	std::vector<std::uint16_t> scale_keys;
+
+    public:
+	AnimationClip();
+
+	// Compresses frames sampled every 1 / sample_rate seconds.
+	// translations and scales hold 3 floats per channel, rotations 4
+	// (x, y, z, w), one frame after the other
+	AnimationClip(const std::vector<std::string> &channel_names,
+		      float sample_rate, const std::vector<float> &translations,
+		      const std::vector<float> &rotations,
+		      const std::vector<float> &scales);
+
+	// Resamples every channel of an Assimp animation
+	static AnimationClip bake(const aiAnimation *animation,
+				  float sample_rate = SAMPLE_RATE);
+
+	bool save(const std::string &path) const;
+
+	// Leaves the clip untouched and returns false if the file is missing,
+	// truncated or not a clip of this version
+	bool load(const std::string &path);
+
+	// Local transforms of every channel at time seconds, wrapping around
+	// the clip, in the same layout as a single constructor frame
+	void sample(float time, std::vector<float> &translations,
+		    std::vector<float> &rotations,
+		    std::vector<float> &scales) const;
+
+	// -1 if no channel animates this node
+	int find_channel(const std::string &name) const;
+
+	int get_channel_count() const noexcept;
+
+	int get_frame_count() const noexcept;
+
+	float get_sample_rate() const noexcept;
+
+	float get_duration() const noexcept;
+};
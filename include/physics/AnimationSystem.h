@@ -0,0 +1,150 @@
+#pragma once
+
+#include <math/Vector3f.h>
+#include <math/Matrix4f.h>
+
+#include <graphics/SkinningShader.h>
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+
+class Skeleton;
+class Transform;
+
+// Advances every registered skeleton once per frame and evaluates the
+// poses in batches spread over a pool of worker threads and the calling
+// thread. Each batch packs its bones straight into a shared palette at
+// offsets fixed before the batches start, so the result is one contiguous
+// buffer that SkinningPass uploads as is.
+//
+// Skeletons far from the camera are evaluated every 2nd, 4th or 8th frame,
+// one interval ahead, and the packed poses blended in between. Skeletons
+// outside the view only advance their time.
+class AnimationSystem {
+    public:
+	AnimationSystem(const AnimationSystem &) = delete;
+
+	AnimationSystem &operator=(const AnimationSystem &) = delete;
+
+	static AnimationSystem &get_instance();
+
+	enum LOD { FULL, HALF, QUARTER, EIGHTH, HIDDEN, LOD_COUNT };
+
+    private:
+	// Skeletons per batch claimed by a thread at a time
+	static constexpr int BATCH_SIZE = 4;
+
+	struct Instance {
+		Skeleton *skeleton;
+		Transform *transform; // Always full rate without one
+		float radius; // Bounding sphere around the transform
+		float time; // Seconds into the clip
+		float speed;
+		int palette_offset; // Floats
+		int palette_size; // Floats
+
+		LOD lod;
+		int interval; // Frames between the last two evaluations
+		int frame; // Frames shown since the last evaluation
+		bool evaluate; // During this update
+		float evaluate_time;
+
+		// Packed poses of the last two evaluations
+		std::vector<float> previous;
+		std::vector<float> next;
+	};
+
+	std::vector<Instance> instances;
+
+	// Camera distances where HALF, QUARTER and EIGHTH start
+	float lod_distances[3];
+	bool has_view;
+	Vector3f view_position;
+	Matrix4f view_projection;
+	int lod_counts[LOD_COUNT];
+	int evaluated_count;
+
+	std::vector<float> palette;
+	std::map<const Skeleton *, int> palette_offsets; // Texels
+	SkinningShader::Mode palette_mode;
+	bool palette_ready;
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable start;
+	std::condition_variable done;
+	int generation;
+	int active_workers;
+	bool stopping;
+	std::atomic<int> next_batch;
+
+	bool benchmark;
+	double update_time; // Microseconds
+	int bone_count;
+
+	AnimationSystem();
+
+	void work(int seen);
+
+	void run_batches();
+
+	void schedule(Instance &instance, float delta);
+
+	void pose(Instance &instance);
+
+    public:
+	~AnimationSystem();
+
+	// Worker threads besides the caller of update(), 0 runs serially
+	void set_thread_count(int count);
+
+	int get_thread_count() const noexcept;
+
+	// The transform places the skeleton for LOD selection, the radius
+	// bounds it for the visibility test
+	void add(Skeleton *skeleton, float speed = 1.0f,
+		 Transform *transform = nullptr, float radius = 1.0f);
+
+	void remove(Skeleton *skeleton);
+
+	void set_lod_distances(float half, float quarter,
+			       float eighth) noexcept;
+
+	// Camera used for the next update()'s LOD selection
+	void set_view(const Vector3f &position,
+		      const Matrix4f &view_projection) noexcept;
+
+	// Advances every skeleton by delta seconds and packs its bones in
+	// the current SkinningPass mode
+	void update(float delta);
+
+	// Swaps out the palette packed by the last update() if it was
+	// packed in this mode. Offsets are in texels per skeleton
+	bool take_palette(SkinningShader::Mode mode,
+			  std::vector<float> &palette,
+			  std::map<const Skeleton *, int> &offsets);
+
+	// Prints the cost of every update() when enabled
+	void set_benchmark(bool enable) noexcept;
+
+	// Wall time of the last update()
+	double get_update_time() const noexcept;
+
+	double get_time_per_skeleton() const noexcept;
+
+	double get_time_per_bone() const noexcept;
+
+	int get_skeleton_count() const noexcept;
+
+	int get_bone_count() const noexcept;
+
+	// Skeletons in the bucket during the last update()
+	int get_lod_count(LOD lod) const noexcept;
+
+	// Skeletons whose pose was evaluated during the last update()
+	int get_evaluated_count() const noexcept;
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <math/Matrix4f.h>
+
+#include <vector>
+
+// Local transforms of every skeleton node, stored component by component
+// (all translation x, then all translation y, ...) so blends run over four
+// nodes at a time. Each component is padded to a multiple of LANES, masks
+// passed to the blends are padded the same way.
+class Pose {
+    public:
+	static constexpr int LANES = 4;
+
+	enum Component { TX, TY, TZ, RX, RY, RZ, RW, SX, SY, SZ, COMPONENTS };
+
+    private:
+	std::vector<float> data;
+	int count;
+	int stride;
+
+    public:
+	Pose();
+
+	explicit Pose(int count);
+
+	// Floats per component for count nodes
+	static int get_stride(int count) noexcept;
+
+	// New nodes are identity transforms
+	void resize(int count);
+
+	int get_count() const noexcept;
+
+	float *get(Component component) noexcept;
+
+	const float *get(Component component) const noexcept;
+
+	// Splits an affine transform into translation, rotation and scale
+	void set(int index, const Matrix4f &transform);
+
+	// Translation * rotation * scale
+	Matrix4f get_transform(int index) const;
+
+	// Crossfades towards other, by weight or by weight * mask[node]
+	void blend(const Pose &other, float weight,
+		   const std::vector<float> *mask = nullptr);
+
+	// Applies how far other is from reference on top of this pose,
+	// scaled like blend()
+	void add(const Pose &other, const Pose &reference, float weight,
+		 const std::vector<float> *mask = nullptr);
+};
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <math/Matrix4f.h>
+#include <physics/Pose.h>
+#include <physics/AnimationClip.h>
 
 #include <assimp/scene.h>
 
@@ -14,6 +16,23 @@ struct Bone {
 	Matrix4f finalTransformation;
 };
 
+// Node of the flattened hierarchy, parents always come before their children
+struct SkeletonNode {
+	int parent; // -1 for the root
+	int bone; // -1 if no bone is attached
+	Matrix4f transformation; // Bind pose, used when not animated
+};
+
+// Clip blended over the base clip, sampled at the same time
+struct AnimationLayer {
+	AnimationClip clip;
+	std::vector<int> channels; // Per node, -1 if not animated
+	float weight;
+	bool additive;
+	std::vector<float> mask; // Per node, empty for the whole skeleton
+	Pose reference; // Additive layers add how far they are from it
+};
+
 class Skeleton {
     public:
 	Skeleton(const aiScene *scene);
@@ -23,14 +42,60 @@ class Skeleton {
 	Matrix4f globalInverseTransform;
 
 	void read_bones(const aiMesh *mesh);
-	void update_bone_transform(float time, const aiNode *node,
-				   const Matrix4f &parentTransform);
+
+	// Replaces the clip baked from the scene, e.g. with one loaded from
+	// the asset cache, and rebinds the nodes to its channels by name
+	void set_clip(const AnimationClip &clip);
+
+	const AnimationClip &get_clip() const noexcept;
+
+	// Crossfades towards the clip by weight, or adds its difference from
+	// its first frame when additive. Layers apply in the order they were
+	// added, masked to the nodes where the mask is non-zero
+	int add_layer(const AnimationClip &clip, float weight,
+		      bool additive = false, std::vector<float> mask = {});
+
+	void set_layer_weight(int layer, float weight);
+
+	void clear_layers();
+
+	// 1 for the node and everything below it, 0 elsewhere
+	std::vector<float> make_mask(const std::string &node_name) const;
+
+	// Samples the clip and its layers at time seconds, blends them and
+	// updates every bone's finalTransformation in one pass over the
+	// flattened hierarchy
+	void update_bone_transforms(float time);
+
+	const std::vector<SkeletonNode> &get_nodes() const noexcept;
 
     private:
 	const aiScene *scene;
+	AnimationClip clip;
+
+	std::vector<SkeletonNode> nodes;
+	std::vector<std::string> node_names; // Only used while binding
+	std::vector<int> channels; // The clip's channel per node
+	std::vector<bool> animated; // By the clip or any layer
+	std::vector<Matrix4f> global_transforms;
+	std::vector<AnimationLayer> layers;
+	Pose bind_pose;
+
+	// Reused every frame
+	std::vector<float> translations;
+	std::vector<float> rotations;
+	std::vector<float> scales;
+	Pose pose;
+	Pose layer_pose;
+
+	void flatten();
+
+	std::vector<int> bind(const AnimationClip &clip) const;
+
+	void find_animated();
 
-	aiVector3D InterpolatePosition(float time, const aiNodeAnim *nodeAnim);
-	aiQuaternion InterpolateRotation(float time,
-					 const aiNodeAnim *nodeAnim);
-	aiVector3D InterpolateScaling(float time, const aiNodeAnim *nodeAnim);
+	// Local transforms of the clip at time seconds, nodes it doesn't
+	// animate keep the bind pose
+	void sample(const AnimationClip &clip, const std::vector<int> &channels,
+		    float time, Pose &pose);
 };
@@ -3,9 +3,59 @@
 
 #include <core/Engine.h>
 #include <graphics/Shader.h>
+#include <graphics/Texture.h>
+
+#include <string>
+#include <cstring>
+#include <iostream>
+#include <exception>
+#include <filesystem>
+
+static bool is_texture(const std::filesystem::path &path)
+{
+	std::string extension = path.extension().string();
+	return extension == ".png" || extension == ".jpg" ||
+	       extension == ".jpeg" || extension == ".exr";
+}
+
+static bool cook(const std::filesystem::path &path)
+{
+	try {
+		if (!Texture::cook_texture(path.string()))
+			return false;
+	} catch (const std::exception &) {
+		return false;
+	}
+	std::cout << "Cooked " << path.string() << '\n';
+	return true;
+}
+
+// Offline step, run as GameEngine --cook-textures <files or directories>
+static int cook_textures(int count, char const *paths[])
+{
+	int failed = 0;
+	for (int i = 0; i < count; i++) {
+		std::filesystem::path path(paths[i]);
+		if (!std::filesystem::is_directory(path)) {
+			failed += !cook(path);
+			continue;
+		}
+		for (const auto &entry :
+		     std::filesystem::recursive_directory_iterator(path)) {
+			const std::filesystem::path &file = entry.path();
+			if (entry.is_regular_file() && is_texture(file)) {
+				failed += !cook(file);
+			}
+		}
+	}
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
 
 int main(int argc, char const *argv[])
 {
+	if (argc > 1 && std::strcmp(argv[1], "--cook-textures") == 0)
+		return cook_textures(argc - 2, argv + 2);
+
 	glfwInit();
 
 	Engine engine;
@@ -14,4 +64,4 @@ int main(int argc, char const *argv[])
 	glfwTerminate();
 
 	return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
@@ -2,12 +2,14 @@
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec2 texCoord;
 
+#include "include/object.glsl"
+
 out vec2 texCoord0;
 
-uniform mat4 MVP; // Model View Projection
+uniform mat4 view_projection;
 
 void main()
 {
-	gl_Position = MVP * vec4(position, 1.0);
+	gl_Position = view_projection * object_model() * vec4(position, 1.0);
 	texCoord0 = texCoord;
 }
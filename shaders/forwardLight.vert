@@ -0,0 +1,25 @@
+#version 460 core
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec2 texCoord;
+layout(location = 2) in vec3 normal;
+
+#include "include/object.glsl"
+
+out vec2 texCoord0;
+out vec3 normal0;
+out vec3 worldPos0;
+flat out vec2 specular0;
+
+uniform mat4 view_projection;
+
+void main()
+{
+	mat4 model = object_model();
+	vec4 world_position = model * vec4(position, 1.0);
+
+	gl_Position = view_projection * world_position;
+	texCoord0 = texCoord;
+	normal0 = (model * vec4(normal, 0.0)).xyz;
+	worldPos0 = world_position.xyz;
+	specular0 = object_specular();
+}
@@ -0,0 +1,40 @@
+#version 460 core
+// MAX_LIGHTS is defined by ForwardMultiLight when the shader is loaded
+
+in vec2 texCoord0;
+in vec3 normal0;
+in vec3 worldPos0;
+flat in vec2 specular0; // x = intensity, y = exponent
+
+out vec4 finalColor;
+
+uniform vec3 eyePos;
+uniform sampler2D diffuse;
+
+#include "include/lighting.glsl"
+
+uniform DirectionalLight directional_lights[MAX_LIGHTS];
+uniform PointLight point_lights[MAX_LIGHTS];
+uniform SpotLight spot_lights[MAX_LIGHTS];
+
+uniform int directional_light_count;
+uniform int point_light_count;
+uniform int spot_light_count;
+
+void main()
+{
+	vec3 normal = normalize(normal0);
+	vec4 light = vec4(0);
+
+	for (int i = 0; i < directional_light_count; i++) {
+		light += calc_directional_light(directional_lights[i], normal);
+	}
+	for (int i = 0; i < point_light_count; i++) {
+		light += calc_point_light(point_lights[i], normal);
+	}
+	for (int i = 0; i < spot_light_count; i++) {
+		light += calc_spot_light(spot_lights[i], normal);
+	}
+
+	finalColor = texture(diffuse, texCoord0.xy) * light;
+}
@@ -1,27 +1,22 @@
-#version 460 core
-
-in vec2 texCoord0;
-in vec3 normal0;
-in vec3 worldPos0;
-
-out vec4 finalColor;
+// Light structs and the Phong terms shared by the light shaders. Expects
+// eyePos, worldPos0 and specular0 to be declared by the includer
 
 struct BaseLight {
 	vec3 color;
 	float intensity;
 };
 
-struct Specular {
-	float intensity;
-	float exponent;
-};
-
 struct Attenuation { // Quadratic formula
 	float linear;
 	float exponent;
 	float constant;
 };
 
+struct DirectionalLight {
+	BaseLight base_light;
+	vec3 direction;
+};
+
 struct PointLight {
 	BaseLight base_light;
 	Attenuation attenuation;
@@ -35,12 +30,6 @@ struct SpotLight {
 	float cutoff;
 };
 
-uniform vec3 eyePos;
-uniform sampler2D diffuse;
-
-uniform Specular specular;
-uniform SpotLight spot_light;
-
 vec4 calc_light(BaseLight base_color, vec3 direction, vec3 normal)
 {
 	float diffuse_factor = dot(normal, -direction);
@@ -56,11 +45,11 @@ vec4 calc_light(BaseLight base_color, vec3 direction, vec3 normal)
 		vec3 reflectDirection = normalize(reflect(direction, normal));
 
 		float specularFactor = dot(directionToEye, reflectDirection);
-		specularFactor = pow(specularFactor, specular.exponent);
+		specularFactor = pow(specularFactor, specular0.y);
 
 		if (specularFactor > 0) {
 			specular_color = vec4(base_color.color, 1.0) *
-					 specular.intensity * specularFactor;
+					 specular0.x * specularFactor;
 		}
 	}
 
@@ -106,8 +95,8 @@ vec4 calc_spot_light(SpotLight spot_light, vec3 normal)
 	return color;
 }
 
-void main()
+vec4 calc_directional_light(DirectionalLight directional_light, vec3 normal)
 {
-	finalColor = texture(diffuse, texCoord0.xy) *
-		     calc_spot_light(spot_light, normalize(normal0));
+	return calc_light(directional_light.base_light,
+			  -directional_light.direction, normal);
 }
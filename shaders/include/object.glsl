@@ -0,0 +1,52 @@
+// Per-object data, from the per-instance model matrix or, with INDIRECT,
+// from the object and material buffers built by the IndirectRenderer
+
+#ifdef INDIRECT
+
+layout(location = 5) in uint object_index; // Per-instance, offset by base instance
+
+struct ObjectData {
+	mat4 model;
+	uvec4 info; // x = material index
+};
+
+layout(std430, binding = 0) readonly buffer Objects {
+	ObjectData objects[];
+};
+
+layout(std430, binding = 1) readonly buffer Materials {
+	vec4 materials[]; // x = specular intensity, y = specular exponent
+};
+
+mat4 object_model()
+{
+	return objects[object_index].model;
+}
+
+vec2 object_specular()
+{
+	return materials[objects[object_index].info.x].xy;
+}
+
+#else
+
+layout(location = 5) in mat4 model; // Per-instance model matrix
+
+struct Specular {
+	float intensity;
+	float exponent;
+};
+
+uniform Specular specular;
+
+mat4 object_model()
+{
+	return model;
+}
+
+vec2 object_specular()
+{
+	return vec2(specular.intensity, specular.exponent);
+}
+
+#endif
@@ -0,0 +1,80 @@
+#version 330 core
+layout(location = 0) in vec3 position;
+layout(location = 2) in vec3 normal;
+layout(location = 3) in uvec4 bone_indices;
+layout(location = 4) in vec4 bone_weights;
+
+// Bone palettes of every skinned mesh this frame, BONE_TEXELS texels per
+// bone. With DUAL_QUATERNION the bone is its real and dual quaternion,
+// otherwise the top three rows of the skinning matrix followed by the rows
+// of its normal matrix
+uniform samplerBuffer palette;
+uniform int palette_offset; // First texel of this mesh's palette
+
+// Captured by transform feedback, interleaved
+out vec3 skinned_position;
+out vec3 skinned_normal;
+
+void main()
+{
+	// Vertices without weights keep their bind pose
+	if (dot(bone_weights, vec4(1.0)) == 0.0) {
+		skinned_position = position;
+		skinned_normal = normal;
+		return;
+	}
+
+#ifdef DUAL_QUATERNION
+	// Blend in the hemisphere of the first bone, then normalize
+	vec4 first_real = texelFetch(palette, palette_offset +
+						   int(bone_indices[0]) *
+							   BONE_TEXELS);
+	vec4 real = vec4(0.0);
+	vec4 dual = vec4(0.0);
+	for (int i = 0; i < 4; i++) {
+		int base = palette_offset + int(bone_indices[i]) * BONE_TEXELS;
+		vec4 bone_real = texelFetch(palette, base);
+		float weight = bone_weights[i];
+		if (dot(bone_real, first_real) < 0.0)
+			weight = -weight;
+
+		real += bone_real * weight;
+		dual += texelFetch(palette, base + 1) * weight;
+	}
+	float magnitude = length(real);
+	real /= magnitude;
+	dual /= magnitude;
+
+	vec3 translation = 2.0 * (real.w * dual.xyz - dual.w * real.xyz +
+				  cross(real.xyz, dual.xyz));
+	skinned_position =
+		position +
+		2.0 * cross(real.xyz, cross(real.xyz, position) +
+					      real.w * position) +
+		translation;
+	skinned_normal = normal + 2.0 * cross(real.xyz,
+					      cross(real.xyz, normal) +
+						      real.w * normal);
+#else
+	vec4 bind_position = vec4(position, 1.0);
+	vec3 position_sum = vec3(0.0);
+	vec3 normal_sum = vec3(0.0);
+	for (int i = 0; i < 4; i++) {
+		int base = palette_offset + int(bone_indices[i]) * BONE_TEXELS;
+		vec3 bone_position =
+			vec3(dot(texelFetch(palette, base), bind_position),
+			     dot(texelFetch(palette, base + 1), bind_position),
+			     dot(texelFetch(palette, base + 2), bind_position));
+		vec3 bone_normal =
+			vec3(dot(texelFetch(palette, base + 3).xyz, normal),
+			     dot(texelFetch(palette, base + 4).xyz, normal),
+			     dot(texelFetch(palette, base + 5).xyz, normal));
+
+		position_sum += bone_position * bone_weights[i];
+		normal_sum += bone_normal * bone_weights[i];
+	}
+
+	skinned_position = position_sum;
+	skinned_normal = normal_sum;
+#endif
+}
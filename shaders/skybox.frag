@@ -0,0 +1,12 @@
+#version 460 core
+
+in vec3 direction0;
+
+uniform samplerCube sampler;
+
+out vec4 finalColor;
+
+void main()
+{
+	finalColor = texture(sampler, direction0);
+}
@@ -0,0 +1,13 @@
+#version 460 core
+layout(location = 0) in vec3 position;
+
+out vec3 direction0;
+
+uniform mat4 view_projection;
+
+void main()
+{
+	// z = w puts the sky on the far plane after the perspective divide
+	gl_Position = (view_projection * vec4(position, 1.0)).xyww;
+	direction0 = position;
+}
@@ -7,19 +7,85 @@
 #include <graphics/Mesh.h>
 #include <graphics/Shader.h>
 #include <graphics/Material.h>
+#include <graphics/RenderQueue.h>
 
 #include <components/SharedGlobals.h>
 #include <components/GameComponent.h>
 
+#include <cmath>
+#include <array>
+#include <algorithm>
+
+const std::array<float, 3> MeshRenderer::LOD_SCREEN_SIZE{ 0.25f, 0.12f,
+							  0.06f };
+
+const float MeshRenderer::LOD_HYSTERESIS = 0.15f;
+
 MeshRenderer::MeshRenderer(const Mesh &mesh, const Material &material)
 	: mesh(mesh)
 	, material(material) {};
 
+void MeshRenderer::select_lod()
+{
+	BaseCamera *camera = static_cast<BaseCamera *>(
+		SharedGlobals::get_instance().main_camera);
+	if (mesh.get_lod_count() == 1 || camera == nullptr)
+		return;
+
+	const MeshResource *resource = mesh.get_resource();
+	Matrix4f model = get_parent_transform()->get_transformation();
+	Matrix4f view_projection = camera->get_view_projection();
+
+	// World space bounding sphere
+	std::array<float, 3> center = resource->center.get();
+	float world[4] = { 0, 0, 0, 1 };
+	float scale = 0;
+	for (int i = 0; i < 3; i++) {
+		world[i] = model.get(i, 3);
+		float column = 0;
+		for (int j = 0; j < 3; j++) {
+			world[i] += model.get(i, j) * center[j];
+			column += model.get(j, i) * model.get(j, i);
+		}
+		scale = std::max(scale, std::sqrt(column));
+	}
+	float radius = resource->radius * scale;
+
+	// Clip w is the view depth and the length of the y row is the
+	// projection's y scale, as the view matrix is a rigid transform
+	float depth = 0;
+	float projection_scale = 0;
+	for (int j = 0; j < 4; j++) {
+		depth += view_projection.get(3, j) * world[j];
+	}
+	for (int j = 0; j < 3; j++) {
+		projection_scale +=
+			view_projection.get(1, j) * view_projection.get(1, j);
+	}
+
+	if (depth <= radius) {
+		mesh.set_lod(0);
+		return;
+	}
+	float screen_size = radius * std::sqrt(projection_scale) / depth;
+
+	int lod = mesh.get_lod();
+	while (lod + 1 < mesh.get_lod_count() &&
+	       screen_size < LOD_SCREEN_SIZE[lod] * (1 - LOD_HYSTERESIS)) {
+		lod++;
+	}
+	while (lod > 0 &&
+	       screen_size > LOD_SCREEN_SIZE[lod - 1] * (1 + LOD_HYSTERESIS)) {
+		lod--;
+	}
+	mesh.set_lod(lod);
+}
+
 void MeshRenderer::render(Shader &shader)
 {
-	shader.use_program();
-	shader.update_uniforms(get_parent_transform(), material);
-	mesh.draw();
+	select_lod();
+	RenderQueue::get_instance().submit(mesh, material,
+					   get_parent_transform());
 }
 
 Material &MeshRenderer::get_material()
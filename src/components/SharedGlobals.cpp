@@ -2,7 +2,6 @@
 
 #include <physics/Collision.h>
 
-#include <unordered_set>
 
 void *SharedGlobals::player_entity = nullptr;
 void *SharedGlobals::enemy_entity = nullptr;
@@ -13,22 +12,6 @@ SharedGlobals &SharedGlobals::get_instance()
 	return instance;
 }
 
-void SharedGlobals::add_to_lights(void *light) noexcept
-{
-	lights.insert(light);
-}
-
-std::unordered_set<void *> &SharedGlobals::get_lights()
-{
-	return lights;
-}
-
-void SharedGlobals::clear_lights()
-{
-	lights.clear();
-	active_light = nullptr;
-}
-
 void collision_near_callback(btBroadphasePair &collisionPair,
 			     btCollisionDispatcher &dispatcher,
 			     const btDispatcherInfo &dispatchInfo)
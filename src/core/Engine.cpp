@@ -4,14 +4,20 @@
 #include <GLFW/glfw3.h>
 
 #include <graphics/Shader.h>
+#include <graphics/GLState.h>
+#include <graphics/AssetLoader.h>
+#include <graphics/DynamicResolution.h>
 #include <graphics/RenderingEngine.h>
 
 #include <core/Input.h>
 #include <core/Timer.h>
 
 #include <components/BaseCamera.h>
+#include <components/Camera.h>
 #include <components/SharedGlobals.h>
 
+#include <physics/AnimationSystem.h>
+
 #include <game/TestGame.h>
 
 #include <iostream>
@@ -20,6 +26,7 @@
 #include <string>
 
 #define _DEBUG_FPS_ON 0
+#define _DEBUG_ANIMATION_BENCHMARK 0
 
 Input &input_handler = Input::get_instance();
 bool paused = false;
@@ -81,10 +88,15 @@ void Engine::run()
 	Timer &timer = Timer::get_instance();
 	game->init();
 	RenderingEngine &rendering_engine = RenderingEngine::get_instance();
+	AnimationSystem &animation_system = AnimationSystem::get_instance();
+	AssetLoader &asset_loader = AssetLoader::get_instance();
+	animation_system.set_benchmark(_DEBUG_ANIMATION_BENCHMARK);
 
 	int frames = 0;
 	double frame_counter = 0;
+	double animation_time = 0;
 	double frame_time = 1.0f / this->FRAME_CAP;
+	DynamicResolution::get_instance().set_target_frame_time(frame_time);
 	// glfwSwapInterval(0); // Disable Vsync
 
 	timer.reset();
@@ -104,6 +116,7 @@ void Engine::run()
 
 			game->input(frame_time);
 			game->update(frame_time);
+			animation_time += frame_time;
 
 			frame_counter += timer.get_delta_time();
 
@@ -111,6 +124,17 @@ void Engine::run()
 #if _DEBUG_FPS_ON
 				std::cout << "FPS: " << frames << ' '
 					  << frame_counter << '\n';
+				std::cout << "GL calls saved: "
+					  << GLState::get_instance()
+						     .get_saved_calls()
+					  << " / issued: "
+					  << GLState::get_instance()
+						     .get_issued_calls()
+					  << '\n';
+				std::cout << "Resolution scale: "
+					  << DynamicResolution::get_instance()
+						     .get_scale()
+					  << '\n';
 #endif
 				frames = 0;
 				frame_counter = 0;
@@ -118,6 +142,20 @@ void Engine::run()
 		}
 
 		if (render_frame) {
+			// Finished loads swap in before anything is drawn
+			asset_loader.update();
+
+			// Poses are only evaluated for frames that get drawn
+			Camera *camera = static_cast<Camera *>(
+				SharedGlobals::get_instance().main_camera);
+			if (camera) {
+				animation_system.set_view(
+					camera->get_position(),
+					camera->get_view_projection());
+			}
+			animation_system.update(animation_time);
+			animation_time = 0;
+
 			rendering_engine.render(game->get_root_object());
 			window.swap_buffers();
 			frames++;
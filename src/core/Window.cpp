@@ -126,6 +126,20 @@ int Window::get_window_width() const noexcept
 	return width;
 }
 
+int Window::get_framebuffer_height() const noexcept
+{
+	int width, height;
+	glfwGetFramebufferSize(window, &width, &height);
+	return height;
+}
+
+int Window::get_framebuffer_width() const noexcept
+{
+	int width, height;
+	glfwGetFramebufferSize(window, &width, &height);
+	return width;
+}
+
 Vector2f Window::get_window_center() const noexcept
 {
 	int width, height;
@@ -27,7 +27,6 @@
 #include <cmath>
 
 const std::unordered_map<std::string, std::string> mesh_assets = {
-	{ "skybox", "./assets/Skybox/fskybg/source/skybox.fbx" },
 	{ "terrain_test", "./assets/terrain/test_floor.fbx" },
 	{ "arena", "./assets/terrain/arena.fbx" },
 	{ "player", "./assets/Player E04.fbx" },
@@ -50,7 +49,6 @@ void TestGame::init()
 	auto &transform = get_root_object()->transform;
 
 	GameObject *skybox = new Skybox(
-		mesh_assets.at("skybox"),
 		"./assets/Skybox/fskybg/textures/background.jpg", { .5 });
 
 	std::map<std::string, std::string> tex_paths;
@@ -0,0 +1,389 @@
+#include <graphics/AssetLoader.h>
+
+#include <misc/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <graphics/GLState.h>
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <utility>
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+
+// Offsets inside a staging buffer, enough for any pixel or vertex type
+static constexpr std::size_t CHUNK_ALIGNMENT = 16;
+
+AssetLoader &AssetLoader::get_instance()
+{
+	static AssetLoader instance;
+	return instance;
+}
+
+AssetLoader::AssetLoader()
+	: decoding(0)
+	, ring{}
+	, next_slot(0)
+	, upload_budget(DEFAULT_UPLOAD_BUDGET)
+	, uploaded_bytes(0)
+	, stopping(false)
+{
+	set_thread_count(DEFAULT_THREAD_COUNT);
+}
+
+AssetLoader::~AssetLoader()
+{
+	set_thread_count(0);
+
+	for (Slot &slot : ring) {
+		if (slot.fence) {
+			glDeleteSync(slot.fence);
+		}
+		if (slot.buffer) {
+			glDeleteBuffers(1, &slot.buffer);
+		}
+	}
+}
+
+void AssetLoader::set_thread_count(int count)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (std::thread &worker : workers) {
+		worker.join();
+	}
+	workers.clear();
+
+	stopping = false;
+	for (int i = 0; i < count; i++) {
+		workers.emplace_back(&AssetLoader::work, this);
+	}
+}
+
+int AssetLoader::get_thread_count() const noexcept
+{
+	return workers.size();
+}
+
+void AssetLoader::work()
+{
+	for (;;) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock,
+				  [&] { return stopping || !queued.empty(); });
+			if (stopping)
+				return;
+			job = std::move(queued.front());
+			queued.pop_front();
+			decoding++;
+		}
+
+		try {
+			job.work();
+		} catch (...) {
+			job.error = std::current_exception();
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		decoding--;
+		finished.push_back(std::move(job));
+	}
+}
+
+void AssetLoader::load(std::function<void()> work, std::function<void()> ready,
+		       std::function<void()> failed)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queued.push_back({ std::move(work), std::move(ready),
+				   std::move(failed), nullptr });
+	}
+	wake.notify_one();
+}
+
+void AssetLoader::upload_texture(GLuint texture, int width, int height,
+				 GLenum internal_format, GLenum format,
+				 GLenum type, std::vector<unsigned char> pixels,
+				 std::function<void()> done)
+{
+	// Storage is allocated now, the rows follow as the budget allows
+	GLState::get_instance().bind_texture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0,
+		     format, type, nullptr);
+
+	upload_texture_level(texture, 0, width, height, format, type,
+			     std::move(pixels), std::move(done));
+	uploads.back().mipmaps = true;
+}
+
+void AssetLoader::upload_texture_level(GLuint texture, int level, int width,
+				       int height, GLenum format, GLenum type,
+				       std::vector<unsigned char> pixels,
+				       std::function<void()> done)
+{
+	Upload upload{};
+	upload.texture = texture;
+	upload.level = level;
+	upload.width = width;
+	upload.height = height;
+	upload.format = format;
+	upload.type = type;
+	upload.row_size = height > 0 ? pixels.size() / height : 0;
+	upload.data = std::move(pixels);
+	upload.done = std::move(done);
+	uploads.push_back(std::move(upload));
+}
+
+void AssetLoader::upload_compressed_level(GLuint texture, int level, int width,
+					  int height, GLenum internal_format,
+					  std::vector<unsigned char> blocks,
+					  std::function<void()> done)
+{
+	int rows = (height + 3) / 4;
+	Upload upload{};
+	upload.texture = texture;
+	upload.level = level;
+	upload.width = width;
+	upload.height = height;
+	upload.format = internal_format;
+	upload.compressed = true;
+	upload.row_size = rows > 0 ? blocks.size() / rows : 0;
+	upload.data = std::move(blocks);
+	upload.done = std::move(done);
+	uploads.push_back(std::move(upload));
+}
+
+void AssetLoader::upload_buffer(GLuint buffer, std::vector<unsigned char> data,
+				std::function<void()> done)
+{
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, data.size(), nullptr,
+		     GL_STATIC_DRAW);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	Upload upload{};
+	upload.buffer = buffer;
+	upload.data = std::move(data);
+	upload.done = std::move(done);
+	uploads.push_back(std::move(upload));
+}
+
+void AssetLoader::update()
+{
+	// Without workers the decoding happens here, one job per frame
+	if (workers.empty()) {
+		Job job;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!queued.empty()) {
+				job = std::move(queued.front());
+				queued.pop_front();
+			}
+		}
+		if (job.work) {
+			try {
+				job.work();
+			} catch (...) {
+				job.error = std::current_exception();
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+			finished.push_back(std::move(job));
+		}
+	}
+
+	std::deque<Job> ready;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		std::swap(ready, finished);
+	}
+
+	// A failed load doesn't hold back the ones that finished with it
+	std::exception_ptr error;
+	for (Job &job : ready) {
+		if (job.error) {
+			if (job.failed) {
+				job.failed();
+			}
+			error = error ? error : job.error;
+		} else if (job.ready) {
+			job.ready();
+		}
+	}
+
+	stage();
+
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
+
+void AssetLoader::stage()
+{
+	uploaded_bytes = 0;
+	if (uploads.empty())
+		return;
+
+	Slot &slot = ring[next_slot];
+	if (slot.fence) {
+		// Rather than stall, the uploads wait for the next frame
+		if (glClientWaitSync(slot.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+			return;
+		glDeleteSync(slot.fence);
+		slot.fence = nullptr;
+	}
+
+	struct Chunk {
+		Upload *upload;
+		std::size_t offset; // In the staging buffer
+		std::size_t size;
+	};
+	std::vector<Chunk> chunks;
+	std::size_t used = 0;
+	for (Upload &upload : uploads) {
+		std::size_t offset = (used + CHUNK_ALIGNMENT - 1) /
+				     CHUNK_ALIGNMENT * CHUNK_ALIGNMENT;
+		std::size_t room = upload_budget > offset ?
+					   upload_budget - offset :
+					   0;
+		std::size_t remaining = upload.data.size() - upload.uploaded;
+		std::size_t size = std::min(remaining, room);
+		if (upload.texture && upload.row_size) {
+			size -= size % upload.row_size;
+		}
+
+		// The first chunk always goes, however small the budget
+		if (size == 0 && remaining > 0) {
+			if (!chunks.empty())
+				break;
+			size = upload.texture && upload.row_size ?
+				       upload.row_size :
+				       remaining;
+		}
+
+		chunks.push_back({ &upload, offset, size });
+		used = offset + size;
+		if (size < remaining)
+			break;
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+	if (slot.buffer == 0 || slot.capacity < used) {
+		if (slot.buffer == 0) {
+			glGenBuffers(1, &slot.buffer);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+		}
+		slot.capacity = std::max(used, upload_budget);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, slot.capacity, nullptr,
+			     GL_STREAM_DRAW);
+	}
+
+	if (used > 0) {
+		auto *mapped = static_cast<unsigned char *>(glMapBufferRange(
+			GL_PIXEL_UNPACK_BUFFER, 0, used,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+		if (!mapped) {
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			std::cerr << "Error: Failed to map upload buffer\n";
+			throw std::runtime_error("Failed to map upload buffer");
+		}
+		for (const Chunk &chunk : chunks) {
+			if (chunk.size == 0)
+				continue;
+			std::memcpy(mapped + chunk.offset,
+				    chunk.upload->data.data() +
+					    chunk.upload->uploaded,
+				    chunk.size);
+		}
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	}
+
+	// Rows are tightly packed whatever their width
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (const Chunk &chunk : chunks) {
+		Upload &upload = *chunk.upload;
+		if (chunk.size == 0) {
+			continue;
+		} else if (upload.texture) {
+			int first_row = upload.uploaded / upload.row_size;
+			int rows = chunk.size / upload.row_size;
+			GLState::get_instance().bind_texture(GL_TEXTURE_2D,
+							     upload.texture);
+			if (upload.compressed) {
+				// The last row of blocks may cover fewer texels
+				int y = first_row * 4;
+				int height = std::min(rows * 4,
+						      upload.height - y);
+				glCompressedTexSubImage2D(
+					GL_TEXTURE_2D, upload.level, 0, y,
+					upload.width, height, upload.format,
+					chunk.size, (void *)chunk.offset);
+			} else {
+				glTexSubImage2D(GL_TEXTURE_2D, upload.level, 0,
+						first_row, upload.width, rows,
+						upload.format, upload.type,
+						(void *)chunk.offset);
+			}
+		} else {
+			glBindBuffer(GL_COPY_READ_BUFFER, slot.buffer);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, upload.buffer);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER,
+					    GL_COPY_WRITE_BUFFER, chunk.offset,
+					    upload.uploaded, chunk.size);
+		}
+		upload.uploaded += chunk.size;
+		uploaded_bytes += chunk.size;
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	next_slot = (next_slot + 1) % RING_SIZE;
+
+	// Uploads finish in order, done may queue further uploads
+	while (!uploads.empty() &&
+	       uploads.front().uploaded == uploads.front().data.size()) {
+		Upload upload = std::move(uploads.front());
+		uploads.pop_front();
+
+		if (upload.mipmaps) {
+			GLState::get_instance().bind_texture(GL_TEXTURE_2D,
+							     upload.texture);
+			glGenerateMipmap(GL_TEXTURE_2D);
+		}
+		if (upload.done) {
+			upload.done();
+		}
+	}
+}
+
+void AssetLoader::set_upload_budget(std::size_t bytes) noexcept
+{
+	upload_budget = bytes;
+}
+
+std::size_t AssetLoader::get_upload_budget() const noexcept
+{
+	return upload_budget;
+}
+
+std::size_t AssetLoader::get_uploaded_bytes() const noexcept
+{
+	return uploaded_bytes;
+}
+
+int AssetLoader::get_pending_count()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return queued.size() + decoding + finished.size() + uploads.size();
+}
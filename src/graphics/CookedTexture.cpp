@@ -0,0 +1,617 @@
+#include <graphics/CookedTexture.h>
+
+#include <graphics/VertexLayout.h>
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+
+static const char MAGIC[4] = { 'G', 'E', 'T', 'C' };
+static const std::uint32_t VERSION = 1;
+
+static constexpr int BLOCK_SIZE = 4;
+
+// Colour channels are averaged in linear light, a plain average of sRGB
+// values darkens every mip of a high contrast texture
+static float srgb_to_linear(float value)
+{
+	if (value <= 0.04045f)
+		return value / 12.92f;
+	return std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+static float linear_to_srgb(float value)
+{
+	if (value <= 0.0031308f)
+		return value * 12.92f;
+	return 1.055f * std::pow(value, 1 / 2.4f) - 0.055f;
+}
+
+static float half_to_float(std::uint16_t half)
+{
+	std::uint32_t sign = (half & 0x8000) << 16;
+	int exponent = (half >> 10) & 0x1F;
+	std::uint32_t mantissa = half & 0x3FF;
+
+	std::uint32_t bits;
+	if (exponent == 0) {
+		// Zero or subnormal, exact as a float
+		float value = std::ldexp(static_cast<float>(mantissa), -24);
+		return sign ? -value : value;
+	} else if (exponent == 31) {
+		bits = sign | 0x7F800000 | (mantissa << 13);
+	} else {
+		bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+	}
+
+	float value;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+// A mip level being filtered, channels interleaved
+struct Level {
+	int width;
+	int height;
+	std::vector<float> texels;
+};
+
+struct Tap {
+	int index;
+	float weight;
+};
+
+// Source texels covering each texel of a halved axis, weighted by overlap
+// so odd sizes lose nothing at the edge
+static std::vector<std::vector<Tap> > box_taps(int source, int size)
+{
+	std::vector<std::vector<Tap> > taps(size);
+	float scale = static_cast<float>(source) / size;
+	for (int i = 0; i < size; i++) {
+		float begin = i * scale;
+		float end = (i + 1) * scale;
+		for (int k = begin; k < end && k < source; k++) {
+			float overlap = std::min(end, k + 1.0f) -
+					std::max(begin, static_cast<float>(k));
+			if (overlap > 0) {
+				taps[i].push_back({ k, overlap / scale });
+			}
+		}
+	}
+	return taps;
+}
+
+static Level downsample(const Level &source, int channels)
+{
+	Level level{ std::max(source.width / 2, 1),
+		     std::max(source.height / 2, 1),
+		     {} };
+	auto columns = box_taps(source.width, level.width);
+	auto rows = box_taps(source.height, level.height);
+
+	// Horizontal then vertical
+	std::vector<float> narrow(level.width * source.height * channels, 0.0f);
+	for (int y = 0; y < source.height; y++) {
+		for (int x = 0; x < level.width; x++) {
+			float *out = &narrow[(y * level.width + x) * channels];
+			for (const Tap &tap : columns[x]) {
+				const float *in =
+					&source.texels[(y * source.width +
+							tap.index) *
+						       channels];
+				for (int c = 0; c < channels; c++) {
+					out[c] += in[c] * tap.weight;
+				}
+			}
+		}
+	}
+
+	level.texels.assign(level.width * level.height * channels, 0.0f);
+	int row_size = level.width * channels;
+	for (int y = 0; y < level.height; y++) {
+		for (const Tap &tap : rows[y]) {
+			const float *in = &narrow[tap.index * row_size];
+			float *out = &level.texels[y * row_size];
+			for (int i = 0; i < row_size; i++) {
+				out[i] += in[i] * tap.weight;
+			}
+		}
+	}
+	return level;
+}
+
+static std::uint16_t pack_565(const float color[3])
+{
+	auto quantize = [](float value, int max) {
+		return static_cast<int>(
+			std::clamp(value, 0.0f, 255.0f) * max / 255 + 0.5f);
+	};
+	return quantize(color[0], 31) << 11 | quantize(color[1], 63) << 5 |
+	       quantize(color[2], 31);
+}
+
+static void unpack_565(std::uint16_t packed, int color[3])
+{
+	int r = packed >> 11;
+	int g = (packed >> 5) & 0x3F;
+	int b = packed & 0x1F;
+	color[0] = r << 3 | r >> 2;
+	color[1] = g << 2 | g >> 4;
+	color[2] = b << 3 | b >> 2;
+}
+
+// Levels in a full chain down to 1x1, the most glTexStorage2D accepts
+static std::uint32_t full_level_count(std::uint32_t width,
+				      std::uint32_t height)
+{
+	std::uint32_t count = 1;
+	for (std::uint32_t size = std::max(width, height); size > 1;
+	     size /= 2) {
+		count++;
+	}
+	return count;
+}
+
+static void write_le(unsigned char *out, std::uint64_t value, int bytes)
+{
+	for (int i = 0; i < bytes; i++) {
+		out[i] = value >> (8 * i);
+	}
+}
+
+// Endpoints along the principal axis of the block's colours, pulled in
+// slightly since the extremes are rarely worth an exact match
+static void encode_bc1(const unsigned char texels[16][4], unsigned char *out)
+{
+	float mean[3] = {};
+	for (int i = 0; i < 16; i++) {
+		for (int c = 0; c < 3; c++) {
+			mean[c] += texels[i][c] / 16.0f;
+		}
+	}
+
+	float covariance[3][3] = {};
+	for (int i = 0; i < 16; i++) {
+		float d[3];
+		for (int c = 0; c < 3; c++) {
+			d[c] = texels[i][c] - mean[c];
+		}
+		for (int r = 0; r < 3; r++) {
+			for (int c = 0; c < 3; c++) {
+				covariance[r][c] += d[r] * d[c];
+			}
+		}
+	}
+
+	// Power iteration, a few steps are plenty for a 3x3 matrix
+	float axis[3] = { 1, 1, 1 };
+	for (int step = 0; step < 8; step++) {
+		float next[3];
+		for (int r = 0; r < 3; r++) {
+			next[r] = covariance[r][0] * axis[0] +
+				  covariance[r][1] * axis[1] +
+				  covariance[r][2] * axis[2];
+		}
+		float length = std::sqrt(next[0] * next[0] + next[1] * next[1] +
+					 next[2] * next[2]);
+		if (length < 1e-6f)
+			break;
+		for (int c = 0; c < 3; c++) {
+			axis[c] = next[c] / length;
+		}
+	}
+
+	float low = 0, high = 0;
+	for (int i = 0; i < 16; i++) {
+		float t = 0;
+		for (int c = 0; c < 3; c++) {
+			t += (texels[i][c] - mean[c]) * axis[c];
+		}
+		low = std::min(low, t);
+		high = std::max(high, t);
+	}
+	float inset = (high - low) / 16;
+	low += inset;
+	high -= inset;
+
+	float start[3], end[3];
+	for (int c = 0; c < 3; c++) {
+		start[c] = mean[c] + axis[c] * high;
+		end[c] = mean[c] + axis[c] * low;
+	}
+
+	// color0 > color1 selects the four colour mode
+	std::uint16_t color0 = pack_565(start);
+	std::uint16_t color1 = pack_565(end);
+	if (color0 < color1) {
+		std::swap(color0, color1);
+	}
+
+	int palette[4][3];
+	unpack_565(color0, palette[0]);
+	unpack_565(color1, palette[1]);
+	for (int c = 0; c < 3; c++) {
+		palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+		palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+	}
+
+	// Equal endpoints are the three colour mode, where index 3 is black
+	int choices = color0 == color1 ? 1 : 4;
+	std::uint32_t indices = 0;
+	for (int i = 0; i < 16; i++) {
+		int best = 0;
+		int best_error = -1;
+		for (int p = 0; p < choices; p++) {
+			int error = 0;
+			for (int c = 0; c < 3; c++) {
+				int d = texels[i][c] - palette[p][c];
+				error += d * d;
+			}
+			if (best_error < 0 || error < best_error) {
+				best = p;
+				best_error = error;
+			}
+		}
+		indices |= static_cast<std::uint32_t>(best) << (2 * i);
+	}
+
+	write_le(out, color0, 2);
+	write_le(out + 2, color1, 2);
+	write_le(out + 4, indices, 4);
+}
+
+// The block's range in the eight value mode, max before min
+static void encode_bc4(const unsigned char values[16], unsigned char *out)
+{
+	int high = *std::max_element(values, values + 16);
+	int low = *std::min_element(values, values + 16);
+
+	int palette[8] = { high, low };
+	for (int i = 2; i < 8; i++) {
+		palette[i] = ((8 - i) * high + (i - 1) * low) / 7;
+	}
+
+	std::uint64_t indices = 0;
+	for (int i = 0; i < 16 && high != low; i++) {
+		int best = 0;
+		for (int p = 1; p < 8; p++) {
+			if (std::abs(values[i] - palette[p]) <
+			    std::abs(values[i] - palette[best])) {
+				best = p;
+			}
+		}
+		indices |= static_cast<std::uint64_t>(best) << (3 * i);
+	}
+
+	out[0] = high;
+	out[1] = low;
+	write_le(out + 2, indices, 6);
+}
+
+static std::size_t block_bytes(CookedTexture::Format format)
+{
+	switch (format) {
+	case CookedTexture::Format::BC1:
+	case CookedTexture::Format::BC4:
+		return 8;
+	case CookedTexture::Format::BC3:
+	case CookedTexture::Format::BC5:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+// Quantizes a level and compresses it block by block, edge texels are
+// repeated to fill the blocks of sizes that aren't a multiple of four
+static std::vector<unsigned char> encode_level(const Level &level,
+					       int channels, bool srgb,
+					       CookedTexture::Format format)
+{
+	std::vector<unsigned char> texels(level.texels.size());
+	for (std::size_t i = 0; i < texels.size(); i++) {
+		float value = std::clamp(level.texels[i], 0.0f, 1.0f);
+		if (srgb && i % channels < 3) {
+			value = linear_to_srgb(value);
+		}
+		texels[i] = value * 255 + 0.5f;
+	}
+
+	int blocks_x = (level.width + BLOCK_SIZE - 1) / BLOCK_SIZE;
+	int blocks_y = (level.height + BLOCK_SIZE - 1) / BLOCK_SIZE;
+	std::size_t size = block_bytes(format);
+	std::vector<unsigned char> data(blocks_x * blocks_y * size);
+
+	for (int by = 0; by < blocks_y; by++) {
+		for (int bx = 0; bx < blocks_x; bx++) {
+			unsigned char block[16][4];
+			for (int i = 0; i < 16; i++) {
+				int x = std::min(bx * BLOCK_SIZE + i % 4,
+						 level.width - 1);
+				int y = std::min(by * BLOCK_SIZE + i / 4,
+						 level.height - 1);
+				const unsigned char *texel =
+					&texels[(y * level.width + x) *
+						channels];
+				for (int c = 0; c < 4; c++) {
+					block[i][c] = c < channels ? texel[c] :
+								     255;
+				}
+			}
+
+			unsigned char *out =
+				&data[(by * blocks_x + bx) * size];
+			unsigned char values[16];
+			auto channel = [&](int c) {
+				for (int i = 0; i < 16; i++) {
+					values[i] = block[i][c];
+				}
+				return values;
+			};
+			switch (format) {
+			case CookedTexture::Format::BC1:
+				encode_bc1(block, out);
+				break;
+			case CookedTexture::Format::BC3:
+				encode_bc4(channel(3), out);
+				encode_bc1(block, out + 8);
+				break;
+			case CookedTexture::Format::BC4:
+				encode_bc4(channel(0), out);
+				break;
+			default:
+				encode_bc4(channel(0), out);
+				encode_bc4(channel(1), out + 8);
+			}
+		}
+	}
+	return data;
+}
+
+static std::vector<unsigned char> encode_half_level(const Level &level)
+{
+	std::vector<unsigned char> data(level.texels.size() *
+					sizeof(std::uint16_t));
+	for (std::size_t i = 0; i < level.texels.size(); i++) {
+		std::uint16_t half = VertexLayout::to_half(level.texels[i]);
+		std::memcpy(&data[i * sizeof(half)], &half, sizeof(half));
+	}
+	return data;
+}
+
+CookedTexture::CookedTexture()
+	: format(Format::BC1)
+	, width(0)
+	, height(0)
+{
+}
+
+CookedTexture CookedTexture::cook(const unsigned char *pixels, int width,
+				  int height, int channels)
+{
+	if (width <= 0 || height <= 0 || channels < 1 || channels > 4) {
+		std::cerr << "Error: Can't cook a " << width << "x" << height
+			  << " texture with " << channels << " channels\n";
+		throw std::runtime_error("Invalid texture to cook");
+	}
+
+	CookedTexture texture;
+	texture.width = width;
+	texture.height = height;
+
+	std::size_t count = static_cast<std::size_t>(width) * height;
+	bool opaque = true;
+	for (std::size_t i = 0; channels == 4 && i < count; i++) {
+		opaque = opaque && pixels[i * 4 + 3] == 255;
+	}
+	switch (channels) {
+	case 1:
+		texture.format = Format::BC4;
+		break;
+	case 2:
+		texture.format = Format::BC5;
+		break;
+	default:
+		texture.format = opaque ? Format::BC1 : Format::BC3;
+	}
+
+	// One and two channel textures hold data rather than colour
+	bool srgb = channels >= 3;
+	Level level{ width, height, std::vector<float>(count * channels) };
+	for (std::size_t i = 0; i < level.texels.size(); i++) {
+		float value = pixels[i] / 255.0f;
+		level.texels[i] = srgb && i % channels < 3 ?
+					  srgb_to_linear(value) :
+					  value;
+	}
+
+	for (;;) {
+		texture.levels.push_back(
+			encode_level(level, channels, srgb, texture.format));
+		if (level.width == 1 && level.height == 1)
+			break;
+		level = downsample(level, channels);
+	}
+	return texture;
+}
+
+CookedTexture CookedTexture::cook_hdr(const std::uint16_t *pixels, int width,
+				      int height)
+{
+	if (width <= 0 || height <= 0) {
+		std::cerr << "Error: Can't cook a " << width << "x" << height
+			  << " texture\n";
+		throw std::runtime_error("Invalid texture to cook");
+	}
+
+	CookedTexture texture;
+	texture.format = Format::RGBA16F;
+	texture.width = width;
+	texture.height = height;
+
+	Level level{ width, height,
+		     std::vector<float>(static_cast<std::size_t>(width) *
+					height * 4) };
+	for (std::size_t i = 0; i < level.texels.size(); i++) {
+		level.texels[i] = half_to_float(pixels[i]);
+	}
+
+	for (;;) {
+		texture.levels.push_back(encode_half_level(level));
+		if (level.width == 1 && level.height == 1)
+			break;
+		level = downsample(level, 4);
+	}
+	return texture;
+}
+
+std::string CookedTexture::get_path(const std::string &source_path)
+{
+	return source_path + ".getc";
+}
+
+bool CookedTexture::save(const std::string &path) const
+{
+	std::ofstream file(path, std::ios::binary);
+	std::uint32_t header[4] = { static_cast<std::uint32_t>(format),
+				    static_cast<std::uint32_t>(width),
+				    static_cast<std::uint32_t>(height),
+				    static_cast<std::uint32_t>(levels.size()) };
+	file.write(MAGIC, sizeof(MAGIC));
+	file.write(reinterpret_cast<const char *>(&VERSION), sizeof(VERSION));
+	file.write(reinterpret_cast<const char *>(header), sizeof(header));
+	for (const std::vector<unsigned char> &level : levels) {
+		file.write(reinterpret_cast<const char *>(level.data()),
+			   level.size());
+	}
+
+	if (!file) {
+		std::cerr << "Warning: Failed to write cooked texture " << path
+			  << '\n';
+		return false;
+	}
+	return true;
+}
+
+bool CookedTexture::load(const std::string &path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.good())
+		return false;
+
+	char magic[4];
+	std::uint32_t version = 0;
+	std::uint32_t header[4] = {};
+	file.read(magic, sizeof(magic));
+	file.read(reinterpret_cast<char *>(&version), sizeof(version));
+	file.read(reinterpret_cast<char *>(header), sizeof(header));
+	if (!file ||
+	    std::string(magic, sizeof(magic)) !=
+		    std::string(MAGIC, sizeof(MAGIC)) ||
+	    version != VERSION)
+		return false;
+
+	// Sizes are checked before anything is allocated for them
+	CookedTexture texture;
+	if (header[0] > static_cast<std::uint32_t>(Format::RGBA16F) ||
+	    header[1] == 0 || header[1] > 1 << 16 || header[2] == 0 ||
+	    header[2] > 1 << 16 || header[3] == 0 ||
+	    header[3] > full_level_count(header[1], header[2]))
+		return false;
+	texture.format = static_cast<Format>(header[0]);
+	texture.width = header[1];
+	texture.height = header[2];
+
+	texture.levels.resize(header[3]);
+	for (int i = 0; i < texture.get_level_count(); i++) {
+		texture.levels[i].resize(texture.get_level_size(i));
+		file.read(reinterpret_cast<char *>(texture.levels[i].data()),
+			  texture.levels[i].size());
+		if (!file)
+			return false;
+	}
+
+	*this = std::move(texture);
+	return true;
+}
+
+CookedTexture::Format CookedTexture::get_format() const noexcept
+{
+	return format;
+}
+
+int CookedTexture::get_width() const noexcept
+{
+	return width;
+}
+
+int CookedTexture::get_height() const noexcept
+{
+	return height;
+}
+
+int CookedTexture::get_level_count() const noexcept
+{
+	return levels.size();
+}
+
+int CookedTexture::get_level_width(int level) const noexcept
+{
+	return std::max(width >> level, 1);
+}
+
+int CookedTexture::get_level_height(int level) const noexcept
+{
+	return std::max(height >> level, 1);
+}
+
+const std::vector<unsigned char> &CookedTexture::get_level(int level) const
+{
+	return levels.at(level);
+}
+
+std::vector<unsigned char> CookedTexture::take_level(int level)
+{
+	return std::move(levels.at(level));
+}
+
+bool CookedTexture::is_compressed() const noexcept
+{
+	return format != Format::RGBA16F;
+}
+
+GLenum CookedTexture::get_internal_format() const noexcept
+{
+	switch (format) {
+	case Format::BC1:
+		return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	case Format::BC3:
+		return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	case Format::BC4:
+		return GL_COMPRESSED_RED_RGTC1;
+	case Format::BC5:
+		return GL_COMPRESSED_RG_RGTC2;
+	default:
+		return GL_RGBA16F;
+	}
+}
+
+std::size_t CookedTexture::get_level_size(int level) const noexcept
+{
+	int rows = get_level_height(level);
+	if (is_compressed()) {
+		rows = (rows + BLOCK_SIZE - 1) / BLOCK_SIZE;
+	}
+	return get_row_size(level) * rows;
+}
+
+std::size_t CookedTexture::get_row_size(int level) const noexcept
+{
+	int columns = get_level_width(level);
+	if (!is_compressed())
+		return columns * 4 * sizeof(std::uint16_t);
+	return (columns + BLOCK_SIZE - 1) / BLOCK_SIZE * block_bytes(format);
+}
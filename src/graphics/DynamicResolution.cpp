@@ -0,0 +1,180 @@
+#include <graphics/DynamicResolution.h>
+
+#include <misc/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <cmath>
+#include <algorithm>
+
+// Frames to wait after a scale change so the average reflects the new size
+static constexpr int COOLDOWN_FRAMES = 15;
+static constexpr double SMOOTHING = 0.1;
+static constexpr double OVER_BUDGET = 1.05;
+static constexpr double UNDER_BUDGET = 0.85;
+static constexpr float MAX_STEP_DOWN = 0.1f;
+static constexpr float STEP_UP = 0.02f;
+
+DynamicResolution &DynamicResolution::get_instance()
+{
+	static DynamicResolution instance;
+	return instance;
+}
+
+DynamicResolution::DynamicResolution()
+	: window_width(0)
+	, window_height(0)
+	, queries{}
+	, query_pending{}
+	, query_index(0)
+	, queries_created(false)
+	, use_queries(false)
+	, frame_start(0)
+	, enabled(true)
+	, min_scale(0.5f)
+	, max_scale(1.0f)
+	, scale(1.0f)
+	, target_frame_time(1.0 / 60.0)
+	, smoothed_frame_time(0)
+	, cooldown(0)
+{
+}
+
+DynamicResolution::~DynamicResolution()
+{
+	if (use_queries) {
+		glDeleteQueries(QUERY_COUNT, queries.data());
+	}
+}
+
+void DynamicResolution::read_queries()
+{
+	// The query about to be reused is the oldest one in flight
+	if (!query_pending[query_index])
+		return;
+
+	GLuint64 elapsed = 0;
+	glGetQueryObjectui64v(queries[query_index], GL_QUERY_RESULT, &elapsed);
+	query_pending[query_index] = false;
+	report_frame_time(elapsed * 1e-9);
+}
+
+void DynamicResolution::begin_frame(int width, int height)
+{
+	window_width = width;
+	window_height = height;
+	if (!enabled)
+		return;
+
+	if (!queries_created) {
+		use_queries = GLVersion.major > 3 ||
+			      (GLVersion.major == 3 && GLVersion.minor >= 3) ||
+			      GLAD_GL_ARB_timer_query;
+		if (use_queries) {
+			glGenQueries(QUERY_COUNT, queries.data());
+		}
+		queries_created = true;
+	}
+
+	if (use_queries) {
+		read_queries();
+		glBeginQuery(GL_TIME_ELAPSED, queries[query_index]);
+	} else {
+		frame_start = glfwGetTime();
+	}
+}
+
+void DynamicResolution::end_frame()
+{
+	if (!enabled)
+		return;
+
+	if (use_queries) {
+		glEndQuery(GL_TIME_ELAPSED);
+		query_pending[query_index] = true;
+		query_index = (query_index + 1) % QUERY_COUNT;
+	} else {
+		// Without timer queries the frame has to complete to be timed
+		glFinish();
+		report_frame_time(glfwGetTime() - frame_start);
+	}
+}
+
+void DynamicResolution::report_frame_time(double frame_time) noexcept
+{
+	if (smoothed_frame_time == 0) {
+		smoothed_frame_time = frame_time;
+	} else {
+		smoothed_frame_time +=
+			SMOOTHING * (frame_time - smoothed_frame_time);
+	}
+
+	if (cooldown > 0) {
+		cooldown--;
+		return;
+	}
+
+	// Fill cost goes with the pixel count, i.e. the square of the scale
+	float new_scale = scale;
+	if (smoothed_frame_time > target_frame_time * OVER_BUDGET) {
+		new_scale *= std::sqrt(target_frame_time / smoothed_frame_time);
+		new_scale = std::max(new_scale, scale - MAX_STEP_DOWN);
+	} else if (smoothed_frame_time < target_frame_time * UNDER_BUDGET) {
+		new_scale += STEP_UP;
+	}
+	new_scale = std::clamp(new_scale, min_scale, max_scale);
+
+	if (new_scale != scale) {
+		// Predict the new cost instead of waiting for the average
+		smoothed_frame_time *=
+			(new_scale * new_scale) / (scale * scale);
+		scale = new_scale;
+		cooldown = COOLDOWN_FRAMES;
+	}
+}
+
+void DynamicResolution::set_enabled(bool enable) noexcept
+{
+	enabled = enable;
+}
+
+bool DynamicResolution::is_enabled() const noexcept
+{
+	return enabled;
+}
+
+void DynamicResolution::set_bounds(float min_scale, float max_scale) noexcept
+{
+	this->max_scale = std::clamp(max_scale, 0.1f, 1.0f);
+	this->min_scale = std::clamp(min_scale, 0.1f, this->max_scale);
+	scale = std::clamp(scale, this->min_scale, this->max_scale);
+}
+
+void DynamicResolution::set_target_frame_time(double frame_time) noexcept
+{
+	target_frame_time = frame_time;
+}
+
+float DynamicResolution::get_scale() const noexcept
+{
+	return scale;
+}
+
+int DynamicResolution::get_render_width() const noexcept
+{
+	return std::max(1, static_cast<int>(window_width * scale));
+}
+
+int DynamicResolution::get_render_height() const noexcept
+{
+	return std::max(1, static_cast<int>(window_height * scale));
+}
+
+int DynamicResolution::get_storage_width() const noexcept
+{
+	return std::max(1, static_cast<int>(window_width * max_scale));
+}
+
+int DynamicResolution::get_storage_height() const noexcept
+{
+	return std::max(1, static_cast<int>(window_height * max_scale));
+}
@@ -3,6 +3,7 @@
 #include <graphics/Shader.h>
 #include <graphics/Texture.h>
 #include <graphics/Material.h>
+#include <graphics/IndirectRenderer.h>
 
 #include <components/SharedGlobals.h>
 
@@ -10,6 +11,7 @@
 
 ForwardAmbient::ForwardAmbient()
 	: Shader()
+	, ambient_overridden{ false, false }
 {
 	this->load_shader();
 }
@@ -24,23 +26,58 @@ void ForwardAmbient::load_shader()
 {
 	this->load("shaders/forwardAmbient.vert",
 		   "shaders/forwardAmbient.frag");
+	if (IndirectRenderer::is_supported()) {
+		this->load_indirect("shaders/forwardAmbient.vert",
+				    "shaders/forwardAmbient.frag");
+	}
 	this->add_uniform("ambient_intensity");
-	this->add_uniform("MVP");
+	this->add_uniform("view_projection");
+
+	ambient_intensity = find_uniform("ambient_intensity");
+	view_projection = find_uniform("view_projection");
+}
+
+void ForwardAmbient::begin_pass()
+{
+	// Uniform values belong to a program, the indirect one needs its own
+	bool indirect = is_indirect();
+	set_indirect(false);
+	set_pass_uniforms();
+	if (has_indirect()) {
+		set_indirect(true);
+		set_pass_uniforms();
+	}
+	set_indirect(indirect);
 }
 
-void ForwardAmbient::update_uniforms(Transform *transform,
-				     const Material &material)
+void ForwardAmbient::set_pass_uniforms()
 {
 	BaseCamera *camera = static_cast<BaseCamera *>(
 		SharedGlobals::get_instance().main_camera);
 
-	Matrix4f projected_matrix =
-		Matrix4f::flip_matrix(camera->get_view_projection() *
-				      transform->get_transformation());
+	this->set_uniform(view_projection,
+			  Matrix4f::flip_matrix(camera->get_view_projection()));
+	this->set_uniform(ambient_intensity,
+			  SharedGlobals::get_instance().active_ambient_light);
+	ambient_overridden[is_indirect()] = false;
+}
 
-	static_cast<Texture *>(material.get_property("diffuse"))->bind();
+void ForwardAmbient::update_uniforms(const MaterialData &material)
+{
+	if (material.diffuse) {
+		material.diffuse->bind();
+	}
 
-	this->set_uniform("MVP", projected_matrix);
-	this->set_uniform("ambient_intensity",
-			  SharedGlobals::get_instance().active_ambient_light);
+	// Materials may override the scene ambient light, the next one that
+	// doesn't puts it back
+	bool &overridden = ambient_overridden[is_indirect()];
+	if (material.flags & MaterialData::HAS_AMBIENT) {
+		this->set_uniform(ambient_intensity, material.ambient);
+		overridden = true;
+	} else if (overridden) {
+		this->set_uniform(
+			ambient_intensity,
+			SharedGlobals::get_instance().active_ambient_light);
+		overridden = false;
+	}
 }
@@ -0,0 +1,193 @@
+#include <graphics/ForwardMultiLight.h>
+
+#include <graphics/Shader.h>
+#include <graphics/Texture.h>
+#include <graphics/Material.h>
+#include <graphics/LightStorage.h>
+#include <graphics/IndirectRenderer.h>
+
+#include <components/Camera.h>
+#include <components/SharedGlobals.h>
+
+#include <string>
+#include <algorithm>
+
+ForwardMultiLight::ForwardMultiLight()
+	: Shader()
+{
+	this->load_shader();
+}
+
+ForwardMultiLight &ForwardMultiLight::get_instance()
+{
+	static ForwardMultiLight instance;
+	return instance;
+}
+
+int ForwardMultiLight::get_pass_count(const LightStorage &lights) noexcept
+{
+	int count = std::max({ lights.get_directional().sources.size(),
+			       lights.get_point().sources.size(),
+			       lights.get_spot().sources.size() });
+	return (count + LIGHTS_PER_PASS - 1) / LIGHTS_PER_PASS;
+}
+
+void ForwardMultiLight::load_shader()
+{
+	ShaderPreprocessor::Defines defines{
+		{ "MAX_LIGHTS", std::to_string(LIGHTS_PER_PASS) }
+	};
+
+	this->load("shaders/forwardLight.vert",
+		   "shaders/forwardMultiLight.frag", defines);
+	if (IndirectRenderer::is_supported()) {
+		this->load_indirect("shaders/forwardLight.vert",
+				    "shaders/forwardMultiLight.frag", defines);
+	}
+
+	this->add_uniform("view_projection");
+
+	for (int i = 0; i < LIGHTS_PER_PASS; i++) {
+		std::string directional =
+			"directional_lights[" + std::to_string(i) + "]";
+		this->add_uniform(directional + ".base_light.color");
+		this->add_uniform(directional + ".base_light.intensity");
+		this->add_uniform(directional + ".direction");
+
+		std::string points[] = {
+			"point_lights[" + std::to_string(i) + "]",
+			"spot_lights[" + std::to_string(i) + "].point_light"
+		};
+		for (const std::string &point : points) {
+			this->add_uniform(point + ".base_light.color");
+			this->add_uniform(point + ".base_light.intensity");
+			this->add_uniform(point + ".attenuation.constant");
+			this->add_uniform(point + ".attenuation.linear");
+			this->add_uniform(point + ".attenuation.exponent");
+			this->add_uniform(point + ".position");
+			this->add_uniform(point + ".range");
+		}
+
+		std::string spot = "spot_lights[" + std::to_string(i) + "]";
+		this->add_uniform(spot + ".direction");
+		this->add_uniform(spot + ".cutoff");
+	}
+
+	this->add_uniform("directional_light_count");
+	this->add_uniform("point_light_count");
+	this->add_uniform("spot_light_count");
+
+	this->add_uniform("specular.intensity");
+	this->add_uniform("specular.exponent");
+	this->add_uniform("eyePos");
+
+	view_projection = find_uniform("view_projection");
+	eye_position = find_uniform("eyePos");
+	specular_intensity = find_uniform("specular.intensity");
+	specular_exponent = find_uniform("specular.exponent");
+}
+
+void ForwardMultiLight::begin_pass()
+{
+	// Uniform values belong to a program, the indirect one needs its own
+	bool indirect = is_indirect();
+	set_indirect(false);
+	set_pass_uniforms();
+	if (has_indirect()) {
+		set_indirect(true);
+		set_pass_uniforms();
+	}
+	set_indirect(indirect);
+}
+
+void ForwardMultiLight::set_pass_uniforms()
+{
+	Camera *camera = static_cast<Camera *>(
+		SharedGlobals::get_instance().main_camera);
+
+	Vector3f camera_position =
+		camera->get_parent_transform()->get_transformed_position();
+
+	Matrix4f projected_matrix =
+		Matrix4f::flip_matrix(camera->get_view_projection());
+
+	this->set_uniform(view_projection, projected_matrix);
+	this->set_uniform(eye_position, camera_position);
+
+	// Group k covers lights [k * N, (k + 1) * N) of every type
+	LightStorage &lights = LightStorage::get_instance();
+	int first = lights.get_active() * LIGHTS_PER_PASS;
+	auto group_size = [&](int count) {
+		return std::max(0, std::min(count - first, LIGHTS_PER_PASS));
+	};
+
+	int directional_count =
+		group_size(lights.get_directional().sources.size());
+	int point_count = group_size(lights.get_point().sources.size());
+	int spot_count = group_size(lights.get_spot().sources.size());
+
+	for (int i = 0; i < directional_count; i++) {
+		this->set_uniform("directional_lights[" + std::to_string(i) +
+					  "]",
+				  lights.get_directional(), first + i);
+	}
+	for (int i = 0; i < point_count; i++) {
+		this->set_uniform("point_lights[" + std::to_string(i) + "]",
+				  lights.get_point(), first + i);
+	}
+	for (int i = 0; i < spot_count; i++) {
+		this->set_uniform("spot_lights[" + std::to_string(i) + "]",
+				  lights.get_spot(), first + i);
+	}
+
+	this->set_uniform("directional_light_count", directional_count);
+	this->set_uniform("point_light_count", point_count);
+	this->set_uniform("spot_light_count", spot_count);
+}
+
+void ForwardMultiLight::update_uniforms(const MaterialData &material)
+{
+	if (material.diffuse) {
+		material.diffuse->bind();
+	}
+
+	this->set_uniform(specular_intensity, material.specular.intensity);
+	this->set_uniform(specular_exponent, material.specular.exponent);
+}
+
+void ForwardMultiLight::set_uniform(
+	const std::string &uniform,
+	const LightStorage::DirectionalLights &lights, int index) noexcept
+{
+	this->set_uniform(uniform + ".base_light.color", lights.color[index]);
+	this->set_uniform(uniform + ".base_light.intensity",
+			  lights.intensity[index]);
+	this->set_uniform(uniform + ".direction", lights.direction[index]);
+}
+
+void ForwardMultiLight::set_uniform(const std::string &uniform,
+				    const LightStorage::PointLights &lights,
+				    int index) noexcept
+{
+	const Attenuation &attenuation = lights.attenuation[index];
+	this->set_uniform(uniform + ".base_light.color", lights.color[index]);
+	this->set_uniform(uniform + ".base_light.intensity",
+			  lights.intensity[index]);
+	this->set_uniform(uniform + ".attenuation.constant",
+			  attenuation.get_constant());
+	this->set_uniform(uniform + ".attenuation.linear",
+			  attenuation.get_linear());
+	this->set_uniform(uniform + ".attenuation.exponent",
+			  attenuation.get_exponent());
+	this->set_uniform(uniform + ".position", lights.position[index]);
+	this->set_uniform(uniform + ".range", lights.range[index]);
+}
+
+void ForwardMultiLight::set_uniform(const std::string &uniform,
+				    const LightStorage::SpotLights &lights,
+				    int index) noexcept
+{
+	this->set_uniform(uniform + ".point_light", lights.point, index);
+	this->set_uniform(uniform + ".direction", lights.direction[index]);
+	this->set_uniform(uniform + ".cutoff", lights.cutoff[index]);
+}
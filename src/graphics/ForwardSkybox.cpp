@@ -0,0 +1,48 @@
+#include <graphics/ForwardSkybox.h>
+
+#include <math/Matrix4f.h>
+
+#include <graphics/Shader.h>
+#include <graphics/Texture.h>
+#include <graphics/Material.h>
+
+#include <components/GameObject.h>
+#include <components/SharedGlobals.h>
+
+ForwardSkybox::ForwardSkybox()
+	: Shader()
+{
+	this->load_shader();
+}
+
+ForwardSkybox &ForwardSkybox::get_instance()
+{
+	static ForwardSkybox instance;
+	return instance;
+}
+
+void ForwardSkybox::load_shader()
+{
+	this->load("shaders/skybox.vert", "shaders/skybox.frag");
+	this->add_uniform("view_projection");
+}
+
+void ForwardSkybox::update_uniforms(const MaterialData &material)
+{
+	SharedGlobals &globals = SharedGlobals::get_instance();
+	BaseCamera *camera = static_cast<BaseCamera *>(globals.main_camera);
+	GameObject *skybox = static_cast<GameObject *>(globals.skybox);
+
+	// Undo the camera translation so the sky stays at infinity, only
+	// the camera and skybox rotations remain
+	Matrix4f view_projection =
+		camera->get_view_projection() *
+		Matrix4f::Translation_Matrix(camera->get_position()) *
+		skybox->transform.get_transformed_rotation()
+			.to_rotation_matrix();
+
+	material.cubemap->bind();
+
+	this->set_uniform("view_projection",
+			  Matrix4f::flip_matrix(view_projection));
+}
@@ -0,0 +1,498 @@
+#include <graphics/FrameGraph.h>
+
+#include <misc/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <graphics/GLState.h>
+
+#include <map>
+#include <string>
+#include <vector>
+#include <utility>
+#include <iostream>
+#include <algorithm>
+#include <exception>
+
+static bool is_depth_stencil(GLenum format)
+{
+	return format == GL_DEPTH24_STENCIL8 || format == GL_DEPTH32F_STENCIL8;
+}
+
+static bool is_depth(GLenum format)
+{
+	return is_depth_stencil(format) || format == GL_DEPTH_COMPONENT16 ||
+	       format == GL_DEPTH_COMPONENT24 ||
+	       format == GL_DEPTH_COMPONENT32F;
+}
+
+bool FrameGraph::TextureDesc::operator==(
+	const TextureDesc &other) const noexcept
+{
+	return internal_format == other.internal_format &&
+	       width == other.width && height == other.height;
+}
+
+FrameGraph::PassBuilder::PassBuilder(FrameGraph &graph, int pass)
+	: graph(graph)
+	, pass(pass)
+{
+}
+
+FrameGraph::PassBuilder &FrameGraph::PassBuilder::read(Handle resource)
+{
+	graph.passes[pass].reads.push_back(resource);
+	graph.compiled = false;
+	return *this;
+}
+
+FrameGraph::PassBuilder &FrameGraph::PassBuilder::write(Handle resource)
+{
+	graph.passes[pass].writes.push_back(resource);
+	graph.compiled = false;
+	return *this;
+}
+
+FrameGraph::PassBuilder &FrameGraph::PassBuilder::clear()
+{
+	graph.passes[pass].clear = true;
+	graph.compiled = false;
+	return *this;
+}
+
+FrameGraph::PassBuilder &FrameGraph::PassBuilder::viewport(int width,
+							   int height)
+{
+	graph.passes[pass].viewport_width = width;
+	graph.passes[pass].viewport_height = height;
+	return *this;
+}
+
+FrameGraph::FrameGraph()
+	: compiled(false)
+	, next_serial(0)
+	, framebuffer_binds(0)
+{
+}
+
+FrameGraph::~FrameGraph()
+{
+	for (auto &[key, framebuffer] : framebuffers) {
+		glDeleteFramebuffers(1, &framebuffer);
+	}
+	for (PhysicalResource &physical : pool) {
+		if (physical.renderbuffer) {
+			glDeleteRenderbuffers(1, &physical.id);
+		} else {
+			GLState::get_instance().forget_texture(physical.id);
+			glDeleteTextures(1, &physical.id);
+		}
+	}
+}
+
+void FrameGraph::reset()
+{
+	resources.clear();
+	passes.clear();
+	order.clear();
+	slots.clear();
+	compiled = false;
+}
+
+FrameGraph::Handle FrameGraph::create_texture(const std::string &name,
+					      const TextureDesc &desc)
+{
+	resources.push_back({ name, desc, false, 0, false, -1, -1, -1 });
+	compiled = false;
+	return resources.size() - 1;
+}
+
+FrameGraph::Handle FrameGraph::import_target(const std::string &name,
+					     GLuint framebuffer, int width,
+					     int height)
+{
+	resources.push_back({ name,
+			      { GL_RGBA8, width, height },
+			      true,
+			      framebuffer,
+			      false,
+			      -1,
+			      -1,
+			      -1 });
+	compiled = false;
+	return resources.size() - 1;
+}
+
+FrameGraph::PassBuilder FrameGraph::add_pass(const std::string &name,
+					     std::function<void()> execute)
+{
+	passes.push_back({ name, std::move(execute), {}, {}, false, 0, 0,
+			   false });
+	compiled = false;
+	return PassBuilder(*this, passes.size() - 1);
+}
+
+void FrameGraph::compile()
+{
+	// Passes run in declaration order, so every read must follow a write
+	std::vector<bool> written(resources.size());
+	for (int i = 0; i < resources.size(); i++) {
+		written[i] = resources[i].imported;
+	}
+	for (const Pass &pass : passes) {
+		for (Handle resource : pass.reads) {
+			if (!written[resource]) {
+				std::cerr << "Error: Pass " << pass.name
+					  << " reads "
+					  << resources[resource].name
+					  << " before it is written\n";
+				throw std::runtime_error(
+					"Frame graph read before write");
+			}
+		}
+		for (Handle resource : pass.writes) {
+			written[resource] = true;
+		}
+	}
+
+	// Walk backwards from the imported targets, a pass survives when a
+	// later live pass still needs something it writes
+	std::vector<bool> needed(resources.size());
+	for (int i = 0; i < resources.size(); i++) {
+		needed[i] = resources[i].imported;
+		resources[i].sampled = false;
+		resources[i].first_use = -1;
+		resources[i].last_use = -1;
+		resources[i].slot = -1;
+	}
+	for (int i = passes.size() - 1; i >= 0; i--) {
+		Pass &pass = passes[i];
+		pass.live = std::any_of(pass.writes.begin(), pass.writes.end(),
+					[&](Handle resource) {
+						return needed[resource];
+					});
+		if (!pass.live)
+			continue;
+
+		// Attachments are loaded unless the pass clears them
+		for (Handle resource : pass.writes) {
+			needed[resource] = !pass.clear;
+		}
+		for (Handle resource : pass.reads) {
+			needed[resource] = true;
+			resources[resource].sampled = true;
+		}
+	}
+
+	order.clear();
+	for (int i = 0; i < passes.size(); i++) {
+		if (!passes[i].live)
+			continue;
+		int position = order.size();
+		order.push_back(i);
+
+		auto touch = [&](Handle resource) {
+			Resource &entry = resources[resource];
+			if (entry.first_use == -1) {
+				entry.first_use = position;
+			}
+			entry.last_use = position;
+		};
+		std::for_each(passes[i].reads.begin(), passes[i].reads.end(),
+			      touch);
+		std::for_each(passes[i].writes.begin(), passes[i].writes.end(),
+			      touch);
+	}
+
+	// Resources are handed a slot at their first use; a slot is free
+	// again once the last resource placed in it has been used
+	slots.clear();
+	std::vector<int> slot_last_use;
+	for (int position = 0; position < order.size(); position++) {
+		for (Resource &resource : resources) {
+			if (resource.imported || resource.first_use != position)
+				continue;
+
+			bool renderbuffer = !resource.sampled;
+			for (int j = 0; j < slots.size(); j++) {
+				if (slot_last_use[j] < position &&
+				    slots[j].renderbuffer == renderbuffer &&
+				    slots[j].desc == resource.desc) {
+					resource.slot = j;
+					break;
+				}
+			}
+			if (resource.slot == -1) {
+				resource.slot = slots.size();
+				slots.push_back(
+					{ resource.desc, renderbuffer });
+				slot_last_use.push_back(-1);
+			}
+			slot_last_use[resource.slot] = resource.last_use;
+		}
+	}
+
+	compiled = true;
+}
+
+void FrameGraph::realize()
+{
+	for (PhysicalResource &physical : pool) {
+		physical.used = false;
+	}
+
+	// Reuse pooled objects from earlier frames where the slot matches
+	std::vector<int> slot_serial(slots.size(), -1);
+	for (int i = 0; i < slots.size(); i++) {
+		for (PhysicalResource &physical : pool) {
+			if (!physical.used &&
+			    physical.renderbuffer == slots[i].renderbuffer &&
+			    physical.desc == slots[i].desc) {
+				physical.used = true;
+				slot_serial[i] = physical.serial;
+				break;
+			}
+		}
+	}
+
+	for (int i = pool.size() - 1; i >= 0; i--) {
+		PhysicalResource &physical = pool[i];
+		if (physical.used)
+			continue;
+
+		auto it = framebuffers.begin();
+		while (it != framebuffers.end()) {
+			if (std::find(it->first.begin(), it->first.end(),
+				      physical.serial) != it->first.end()) {
+				glDeleteFramebuffers(1, &it->second);
+				it = framebuffers.erase(it);
+			} else {
+				it++;
+			}
+		}
+		if (physical.renderbuffer) {
+			glDeleteRenderbuffers(1, &physical.id);
+		} else {
+			GLState::get_instance().forget_texture(physical.id);
+			glDeleteTextures(1, &physical.id);
+		}
+		pool.erase(pool.begin() + i);
+	}
+
+	for (int i = 0; i < slots.size(); i++) {
+		if (slot_serial[i] != -1)
+			continue;
+
+		const TextureDesc &desc = slots[i].desc;
+		PhysicalResource physical{ desc, slots[i].renderbuffer, 0,
+					   next_serial++, true };
+		if (physical.renderbuffer) {
+			glGenRenderbuffers(1, &physical.id);
+			glBindRenderbuffer(GL_RENDERBUFFER, physical.id);
+			glRenderbufferStorage(GL_RENDERBUFFER,
+					      desc.internal_format, desc.width,
+					      desc.height);
+			glBindRenderbuffer(GL_RENDERBUFFER, 0);
+		} else {
+			GLenum format = GL_RGBA;
+			GLenum type = GL_UNSIGNED_BYTE;
+			if (is_depth_stencil(desc.internal_format)) {
+				format = GL_DEPTH_STENCIL;
+				type = GL_UNSIGNED_INT_24_8;
+			} else if (is_depth(desc.internal_format)) {
+				format = GL_DEPTH_COMPONENT;
+				type = GL_FLOAT;
+			}
+			glGenTextures(1, &physical.id);
+			GLState::get_instance().bind_texture(GL_TEXTURE_2D,
+							     physical.id);
+			glTexImage2D(GL_TEXTURE_2D, 0, desc.internal_format,
+				     desc.width, desc.height, 0, format, type,
+				     nullptr);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+					GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
+					GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,
+					GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T,
+					GL_CLAMP_TO_EDGE);
+		}
+		slot_serial[i] = physical.serial;
+		pool.push_back(physical);
+	}
+
+	slot_physical.assign(slots.size(), -1);
+	for (int i = 0; i < slots.size(); i++) {
+		for (int j = 0; j < pool.size(); j++) {
+			if (pool[j].serial == slot_serial[i]) {
+				slot_physical[i] = j;
+				break;
+			}
+		}
+	}
+}
+
+GLuint FrameGraph::framebuffer_for(const std::vector<Handle> &attachments)
+{
+	std::vector<int> key;
+	for (Handle resource : attachments) {
+		if (resources[resource].imported) {
+			return resources[resource].framebuffer;
+		}
+		key.push_back(pool[slot_physical[resources[resource].slot]]
+				      .serial);
+	}
+
+	auto cached = framebuffers.find(key);
+	if (cached != framebuffers.end()) {
+		return cached->second;
+	}
+
+	GLint previous = 0;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+
+	GLuint framebuffer;
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+	std::vector<GLenum> draw_buffers;
+	for (Handle resource : attachments) {
+		const PhysicalResource &physical =
+			pool[slot_physical[resources[resource].slot]];
+		GLenum attachment;
+		if (is_depth_stencil(physical.desc.internal_format)) {
+			attachment = GL_DEPTH_STENCIL_ATTACHMENT;
+		} else if (is_depth(physical.desc.internal_format)) {
+			attachment = GL_DEPTH_ATTACHMENT;
+		} else {
+			attachment = GL_COLOR_ATTACHMENT0 + draw_buffers.size();
+			draw_buffers.push_back(attachment);
+		}
+
+		if (physical.renderbuffer) {
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment,
+						  GL_RENDERBUFFER, physical.id);
+		} else {
+			glFramebufferTexture2D(GL_FRAMEBUFFER, attachment,
+					       GL_TEXTURE_2D, physical.id, 0);
+		}
+	}
+	if (draw_buffers.empty()) {
+		glDrawBuffer(GL_NONE);
+	} else {
+		glDrawBuffers(draw_buffers.size(), draw_buffers.data());
+	}
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) !=
+	    GL_FRAMEBUFFER_COMPLETE) {
+		std::cerr << "Error: Frame graph framebuffer incomplete\n";
+		throw std::runtime_error("Frame graph framebuffer incomplete");
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, previous);
+
+	framebuffers[key] = framebuffer;
+	return framebuffer;
+}
+
+void FrameGraph::execute()
+{
+	if (!compiled) {
+		compile();
+	}
+	realize();
+
+	// Consecutive passes on the same attachments share one bind
+	bool bound = false;
+	GLuint current = 0;
+	framebuffer_binds = 0;
+
+	for (int index : order) {
+		Pass &pass = passes[index];
+		GLuint framebuffer = framebuffer_for(pass.writes);
+		if (!bound || framebuffer != current) {
+			glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+			current = framebuffer;
+			bound = true;
+			framebuffer_binds++;
+		}
+
+		const TextureDesc &desc = resources[pass.writes.front()].desc;
+		if (pass.viewport_width > 0) {
+			glViewport(0, 0, pass.viewport_width,
+				   pass.viewport_height);
+		} else {
+			glViewport(0, 0, desc.width, desc.height);
+		}
+
+		if (pass.clear) {
+			GLbitfield mask = 0;
+			for (Handle resource : pass.writes) {
+				const Resource &entry = resources[resource];
+				GLenum format = entry.desc.internal_format;
+				if (entry.imported) {
+					mask |= GL_COLOR_BUFFER_BIT |
+						GL_DEPTH_BUFFER_BIT |
+						GL_STENCIL_BUFFER_BIT;
+				} else if (is_depth_stencil(format)) {
+					mask |= GL_DEPTH_BUFFER_BIT |
+						GL_STENCIL_BUFFER_BIT;
+				} else if (is_depth(format)) {
+					mask |= GL_DEPTH_BUFFER_BIT;
+				} else {
+					mask |= GL_COLOR_BUFFER_BIT;
+				}
+			}
+			// Depth clears honour the depth write mask
+			GLState::get_instance().depth_mask(GL_TRUE);
+			glClear(mask);
+		}
+
+		pass.execute();
+	}
+
+	if (bound && current != 0) {
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+}
+
+GLuint FrameGraph::get_texture(Handle resource) const
+{
+	const Resource &entry = resources[resource];
+	if (entry.imported || entry.slot == -1 ||
+	    slots[entry.slot].renderbuffer) {
+		std::cerr << "Error: " << entry.name
+			  << " is not a sampled frame graph texture\n";
+		throw std::runtime_error("Not a sampled frame graph texture");
+	}
+	return pool[slot_physical[entry.slot]].id;
+}
+
+GLuint FrameGraph::get_framebuffer(Handle resource)
+{
+	return framebuffer_for({ resource });
+}
+
+bool FrameGraph::is_culled(const std::string &pass_name) const
+{
+	for (const Pass &pass : passes) {
+		if (pass.name == pass_name) {
+			return !pass.live;
+		}
+	}
+	return true;
+}
+
+int FrameGraph::get_live_pass_count() const noexcept
+{
+	return order.size();
+}
+
+int FrameGraph::get_slot_count() const noexcept
+{
+	return slots.size();
+}
+
+int FrameGraph::get_framebuffer_binds() const noexcept
+{
+	return framebuffer_binds;
+}
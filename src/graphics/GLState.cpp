@@ -0,0 +1,200 @@
+#include <graphics/GLState.h>
+
+#include <misc/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <array>
+
+GLState &GLState::get_instance()
+{
+	static GLState instance;
+	return instance;
+}
+
+// Mirrors the initial state of a fresh context
+GLState::GLState()
+	: program(0)
+	, vertex_array(0)
+	, active_unit(0)
+	, textures{}
+	, capabilities{}
+	, blend_source(GL_ONE)
+	, blend_destination(GL_ZERO)
+	, depth_function(GL_LESS)
+	, depth_write(GL_TRUE)
+	, cull_mode(GL_BACK)
+	, scissor_box{ -1, -1, -1, -1 }
+	, depth_bounds_range{ 0.0f, 1.0f }
+	, issued_calls(0)
+	, saved_calls(0)
+	, last_issued_calls(0)
+	, last_saved_calls(0)
+{
+	// GL_DITHER is the only capability enabled by default and is not
+	// tracked, so every shadowed capability starts disabled
+}
+
+bool GLState::skip(bool unchanged) noexcept
+{
+	if (unchanged) {
+		saved_calls++;
+	} else {
+		issued_calls++;
+	}
+	return unchanged;
+}
+
+void GLState::use_program(GLuint shader_program) noexcept
+{
+	if (skip(program == shader_program))
+		return;
+	glUseProgram(shader_program);
+	program = shader_program;
+}
+
+void GLState::bind_vertex_array(GLuint vao) noexcept
+{
+	if (skip(vertex_array == vao))
+		return;
+	glBindVertexArray(vao);
+	vertex_array = vao;
+}
+
+void GLState::bind_texture(GLenum target, GLuint texture, int unit) noexcept
+{
+	int slot = -1;
+	for (int i = 0; i < TEXTURE_TARGETS.size(); i++) {
+		if (TEXTURE_TARGETS[i] == target) {
+			slot = i;
+			break;
+		}
+	}
+
+	if (slot != -1 && unit < MAX_TEXTURE_UNITS &&
+	    skip(textures[slot][unit] == texture))
+		return;
+
+	if (!skip(active_unit == unit)) {
+		glActiveTexture(GL_TEXTURE0 + unit);
+		active_unit = unit;
+	}
+
+	glBindTexture(target, texture);
+	if (slot != -1 && unit < MAX_TEXTURE_UNITS) {
+		textures[slot][unit] = texture;
+	} else {
+		issued_calls++;
+	}
+}
+
+void GLState::set_capability(GLenum capability, bool enable) noexcept
+{
+	for (int i = 0; i < CAPABILITIES.size(); i++) {
+		if (CAPABILITIES[i] != capability)
+			continue;
+
+		if (skip(capabilities[i] == enable))
+			return;
+		capabilities[i] = enable;
+		break;
+	}
+
+	if (enable)
+		glEnable(capability);
+	else
+		glDisable(capability);
+}
+
+void GLState::blend_func(GLenum source, GLenum destination) noexcept
+{
+	if (skip(blend_source == source && blend_destination == destination))
+		return;
+	glBlendFunc(source, destination);
+	blend_source = source;
+	blend_destination = destination;
+}
+
+void GLState::depth_func(GLenum function) noexcept
+{
+	if (skip(depth_function == function))
+		return;
+	glDepthFunc(function);
+	depth_function = function;
+}
+
+void GLState::depth_mask(GLboolean enable) noexcept
+{
+	if (skip(depth_write == enable))
+		return;
+	glDepthMask(enable);
+	depth_write = enable;
+}
+
+void GLState::cull_face(GLenum mode) noexcept
+{
+	if (skip(cull_mode == mode))
+		return;
+	glCullFace(mode);
+	cull_mode = mode;
+}
+
+void GLState::scissor(int x, int y, int width, int height) noexcept
+{
+	std::array<int, 4> box{ x, y, width, height };
+	if (skip(scissor_box == box))
+		return;
+	glScissor(x, y, width, height);
+	scissor_box = box;
+}
+
+void GLState::depth_bounds(float min_depth, float max_depth) noexcept
+{
+	if (skip(depth_bounds_range[0] == min_depth &&
+		 depth_bounds_range[1] == max_depth))
+		return;
+	glDepthBoundsEXT(min_depth, max_depth);
+	depth_bounds_range = { min_depth, max_depth };
+}
+
+void GLState::forget_program(GLuint shader_program) noexcept
+{
+	if (program == shader_program) {
+		program = 0;
+	}
+}
+
+void GLState::forget_vertex_array(GLuint vao) noexcept
+{
+	if (vertex_array == vao) {
+		vertex_array = 0;
+	}
+}
+
+void GLState::forget_texture(GLuint texture) noexcept
+{
+	for (auto &units : textures) {
+		for (GLuint &bound : units) {
+			if (bound == texture) {
+				bound = 0;
+			}
+		}
+	}
+}
+
+void GLState::begin_frame() noexcept
+{
+	last_issued_calls = issued_calls;
+	last_saved_calls = saved_calls;
+	issued_calls = 0;
+	saved_calls = 0;
+}
+
+int GLState::get_issued_calls() const noexcept
+{
+	return last_issued_calls;
+}
+
+int GLState::get_saved_calls() const noexcept
+{
+	return last_saved_calls;
+}
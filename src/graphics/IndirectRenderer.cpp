@@ -0,0 +1,303 @@
+#include <graphics/IndirectRenderer.h>
+
+#include <misc/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <graphics/Shader.h>
+#include <graphics/GLState.h>
+#include <graphics/VertexLayout.h>
+#include <graphics/Texture.h>
+#include <graphics/Material.h>
+#include <graphics/MaterialTable.h>
+#include <graphics/Specular.h>
+#include <graphics/RenderQueue.h>
+#include <graphics/resource_management/MeshResource.h>
+
+#include <vector>
+#include <cstring>
+#include <tuple>
+#include <utility>
+#include <algorithm>
+
+IndirectRenderer &IndirectRenderer::get_instance()
+{
+	static IndirectRenderer instance;
+	return instance;
+}
+
+IndirectRenderer::IndirectRenderer()
+	: pool_dirty(false)
+	, vao(0)
+	, vbo(0)
+	, ebo(0)
+	, object_index_vbo(0)
+	, object_ssbo(0)
+	, material_ssbo(0)
+	, command_buffer(0)
+	, object_index_capacity(0)
+	, enabled(is_supported())
+{
+}
+
+IndirectRenderer::~IndirectRenderer()
+{
+	GLuint buffers[] = { vbo,	  ebo,		 object_index_vbo,
+			     object_ssbo, material_ssbo, command_buffer };
+	for (GLuint buffer : buffers) {
+		if (buffer) {
+			glDeleteBuffers(1, &buffer);
+		}
+	}
+	if (vao) {
+		GLState::get_instance().forget_vertex_array(vao);
+		glDeleteVertexArrays(1, &vao);
+		vao = 0;
+	}
+}
+
+bool IndirectRenderer::is_supported()
+{
+	bool version_4_3 = GLVersion.major > 4 ||
+			   (GLVersion.major == 4 && GLVersion.minor >= 3);
+	return version_4_3 && GLAD_GL_ARB_multi_draw_indirect &&
+	       GLAD_GL_ARB_shader_storage_buffer_object;
+}
+
+bool IndirectRenderer::is_pooled(const DrawGroup &group)
+{
+	const MaterialData &material =
+		MaterialTable::get_instance().get(group.material);
+	return group.mesh->get_resource()->base_vertex != -1 &&
+	       !(material.flags & MaterialData::SKINNED);
+}
+
+bool IndirectRenderer::is_enabled() const noexcept
+{
+	return enabled;
+}
+
+void IndirectRenderer::set_enabled(bool enable) noexcept
+{
+	enabled = enable && is_supported();
+}
+
+void IndirectRenderer::init()
+{
+	glGenVertexArrays(1, &vao);
+	glGenBuffers(1, &vbo);
+	glGenBuffers(1, &ebo);
+	glGenBuffers(1, &object_index_vbo);
+	glGenBuffers(1, &object_ssbo);
+	glGenBuffers(1, &material_ssbo);
+	glGenBuffers(1, &command_buffer);
+
+	GLState::get_instance().bind_vertex_array(vao);
+
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	VertexLayout::STATIC.apply();
+
+	// Object index, offset by each command's base instance
+	glEnableVertexAttribArray(5);
+	glBindBuffer(GL_ARRAY_BUFFER, object_index_vbo);
+	glVertexAttribIPointer(5, 1, GL_UNSIGNED_INT, sizeof(GLuint),
+			       (void *)0);
+	glVertexAttribDivisor(5, 1);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+
+	GLState::get_instance().bind_vertex_array(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void IndirectRenderer::add_geometry(MeshResource &resource,
+				    const std::vector<unsigned char> &vertices,
+				    const std::vector<int> &indices)
+{
+	if (!enabled)
+		return;
+
+	resource.base_vertex =
+		pool_vertices.size() / VertexLayout::STATIC.get_stride();
+	resource.first_index = pool_indices.size();
+
+	pool_vertices.insert(pool_vertices.end(), vertices.begin(),
+			     vertices.end());
+	pool_indices.insert(pool_indices.end(), indices.begin(),
+			    indices.end());
+	pool_dirty = true;
+}
+
+void IndirectRenderer::upload_pool()
+{
+	if (vao == 0) {
+		init();
+	}
+
+	GLState::get_instance().bind_vertex_array(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, pool_vertices.size(),
+		     pool_vertices.data(), GL_STATIC_DRAW);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, pool_indices.size() * sizeof(int),
+		     pool_indices.data(), GL_STATIC_DRAW);
+	GLState::get_instance().bind_vertex_array(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	pool_dirty = false;
+}
+
+void IndirectRenderer::build(const std::vector<DrawPacket> &packets,
+			     const std::vector<DrawGroup> &groups)
+{
+	commands.clear();
+	objects.clear();
+	materials.clear();
+	batches.clear();
+
+	if (!enabled || packets.empty())
+		return;
+
+	if (pool_dirty || vao == 0) {
+		upload_pool();
+	}
+
+	// Material table, deduplicated by contents
+	const MaterialTable &table = MaterialTable::get_instance();
+	std::vector<const MaterialData *> material_table;
+	std::vector<GLuint> group_material(groups.size());
+	for (int i = 0; i < groups.size(); i++) {
+		const MaterialData &material = table.get(groups[i].material);
+		int index = -1;
+		for (int j = 0; j < material_table.size(); j++) {
+			if (*material_table[j] == material) {
+				index = j;
+				break;
+			}
+		}
+		if (index == -1) {
+			index = material_table.size();
+			material_table.push_back(&material);
+		}
+		group_material[i] = index;
+	}
+
+	for (const MaterialData *material : material_table) {
+		materials.insert(materials.end(),
+				 { material->specular.intensity,
+				   material->specular.exponent, 0, 0 });
+	}
+
+	objects.resize(packets.size());
+	for (int i = 0; i < groups.size(); i++) {
+		for (int j = 0; j < groups[i].count; j++) {
+			ObjectData &object = objects[groups[i].first + j];
+			std::memcpy(object.model,
+				    packets[groups[i].first + j]
+					    .model.get_matrix(),
+				    16 * sizeof(float));
+			object.material_index = group_material[i];
+		}
+	}
+
+	// Commands sorted by diffuse texture so each texture is one draw;
+	// per-material uniforms the SSBOs don't carry split batches too
+	auto batch_key = [&](int index) {
+		const MaterialData &material = table.get(index);
+		GLuint texture = 0;
+		if (material.diffuse) {
+			texture = material.diffuse->get_id();
+		}
+		bool ambient = material.flags & MaterialData::HAS_AMBIENT;
+		return std::make_tuple(texture, ambient,
+				       ambient ? material.ambient.getX() : 0,
+				       ambient ? material.ambient.getY() : 0,
+				       ambient ? material.ambient.getZ() : 0);
+	};
+
+	std::vector<int> order;
+	for (int i = 0; i < groups.size(); i++) {
+		if (is_pooled(groups[i])) {
+			order.push_back(i);
+		}
+	}
+	std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+		return batch_key(groups[a].material) <
+		       batch_key(groups[b].material);
+	});
+
+	for (int i : order) {
+		const DrawGroup &group = groups[i];
+		const MeshResource *resource = group.mesh->get_resource();
+		const MeshResource::LOD &range =
+			resource->lods[group.mesh->get_lod()];
+
+		if (batches.empty() || batch_key(batches.back().material) !=
+					       batch_key(group.material)) {
+			batches.push_back({ group.material,
+					    static_cast<int>(commands.size()),
+					    0 });
+		}
+		batches.back().count++;
+
+		commands.push_back({ static_cast<GLuint>(range.count),
+				     static_cast<GLuint>(group.count),
+				     static_cast<GLuint>(resource->first_index +
+							 range.first),
+				     resource->base_vertex,
+				     static_cast<GLuint>(group.first) });
+	}
+
+	if (object_index_capacity < packets.size()) {
+		std::vector<GLuint> object_indices(packets.size());
+		for (int i = 0; i < object_indices.size(); i++) {
+			object_indices[i] = i;
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, object_index_vbo);
+		glBufferData(GL_ARRAY_BUFFER,
+			     object_indices.size() * sizeof(GLuint),
+			     object_indices.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		object_index_capacity = packets.size();
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, object_ssbo);
+	glBufferData(GL_SHADER_STORAGE_BUFFER,
+		     objects.size() * sizeof(ObjectData), objects.data(),
+		     GL_STREAM_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, material_ssbo);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, materials.size() * sizeof(float),
+		     materials.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER,
+		     commands.size() * sizeof(DrawCommand), commands.data(),
+		     GL_STREAM_DRAW);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void IndirectRenderer::draw(Shader &shader)
+{
+	if (commands.empty())
+		return;
+
+	shader.set_indirect(true);
+	shader.use_program();
+
+	GLState::get_instance().bind_vertex_array(vao);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, object_ssbo);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, material_ssbo);
+
+	for (const Batch &batch : batches) {
+		shader.update_uniforms(
+			MaterialTable::get_instance().get(batch.material));
+		glMultiDrawElementsIndirect(
+			GL_TRIANGLES, GL_UNSIGNED_INT,
+			(void *)(batch.first * sizeof(DrawCommand)),
+			batch.count, 0);
+	}
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+	shader.set_indirect(false);
+}
@@ -0,0 +1,170 @@
+#include <graphics/LightBounds.h>
+
+#include <math/Vector3f.h>
+#include <math/Matrix4f.h>
+
+#include <graphics/LightStorage.h>
+
+#include <cmath>
+#include <algorithm>
+
+LightBounds::Rect LightBounds::empty_rect() noexcept
+{
+	return { 0, 0, 0, 0, 1.0f, 0.0f, true, false };
+}
+
+LightBounds::Rect LightBounds::full_rect(int width, int height) noexcept
+{
+	return { 0, 0, width, height, 0.0f, 1.0f, false, true };
+}
+
+void LightBounds::spot_sphere(const Vector3f &position,
+			      const Vector3f &direction, float range,
+			      float cutoff, Vector3f &center, float &radius)
+{
+	// Wide cones are bounded by their base disc, narrow ones by the
+	// sphere through the apex and the base circle
+	float cos_angle = std::clamp(cutoff, 0.0f, 1.0f);
+	float sin_angle = std::sqrt(1.0f - cos_angle * cos_angle);
+	Vector3f axis = direction.normalize();
+
+	if (cutoff <= 0.0f) {
+		center = position;
+		radius = range;
+	} else if (cos_angle <= sin_angle) {
+		center = position + axis * (range * cos_angle);
+		radius = range * sin_angle;
+	} else {
+		radius = range / (2.0f * cos_angle);
+		center = position + axis * radius;
+	}
+}
+
+LightBounds::Rect LightBounds::project_sphere(const Vector3f &center,
+					      float radius,
+					      const Matrix4f &view_projection,
+					      int width, int height)
+{
+	float min_x = 1.0f, min_y = 1.0f, min_z = 1.0f;
+	float max_x = -1.0f, max_y = -1.0f, max_z = -1.0f;
+	int behind = 0;
+
+	// Corners of the sphere's bounding box, in normalized device space
+	for (int i = 0; i < 8; i++) {
+		float corner[4] = {
+			center.getX() + (i & 1 ? radius : -radius),
+			center.getY() + (i & 2 ? radius : -radius),
+			center.getZ() + (i & 4 ? radius : -radius), 1.0f
+		};
+		float clip[4];
+		for (int row = 0; row < 4; row++) {
+			clip[row] = 0;
+			for (int column = 0; column < 4; column++) {
+				clip[row] += view_projection.get(row, column) *
+					     corner[column];
+			}
+		}
+
+		if (clip[3] <= 1e-5f) {
+			behind++;
+			continue;
+		}
+
+		float x = clip[0] / clip[3];
+		float y = clip[1] / clip[3];
+		float z = clip[2] / clip[3];
+		if (i == behind) {
+			min_x = max_x = x;
+			min_y = max_y = y;
+			min_z = max_z = z;
+		} else {
+			min_x = std::min(min_x, x);
+			max_x = std::max(max_x, x);
+			min_y = std::min(min_y, y);
+			max_y = std::max(max_y, y);
+			min_z = std::min(min_z, z);
+			max_z = std::max(max_z, z);
+		}
+	}
+
+	if (behind == 8)
+		return empty_rect();
+	if (behind > 0)
+		return full_rect(width, height);
+
+	if (max_x < -1.0f || min_x > 1.0f || max_y < -1.0f || min_y > 1.0f ||
+	    min_z > 1.0f)
+		return empty_rect();
+
+	min_x = std::max(min_x, -1.0f);
+	min_y = std::max(min_y, -1.0f);
+	max_x = std::min(max_x, 1.0f);
+	max_y = std::min(max_y, 1.0f);
+
+	Rect rect;
+	rect.x = std::floor((min_x * 0.5f + 0.5f) * width);
+	rect.y = std::floor((min_y * 0.5f + 0.5f) * height);
+	rect.width = std::ceil((max_x * 0.5f + 0.5f) * width) - rect.x;
+	rect.height = std::ceil((max_y * 0.5f + 0.5f) * height) - rect.y;
+	rect.min_depth = std::max(min_z * 0.5f + 0.5f, 0.0f);
+	rect.max_depth = std::min(max_z * 0.5f + 0.5f, 1.0f);
+	rect.empty = rect.width <= 0 || rect.height <= 0;
+	rect.full = false;
+
+	return rect;
+}
+
+LightBounds::Rect LightBounds::merge(const Rect &a, const Rect &b) noexcept
+{
+	if (a.empty)
+		return b;
+	if (b.empty)
+		return a;
+
+	Rect rect;
+	rect.x = std::min(a.x, b.x);
+	rect.y = std::min(a.y, b.y);
+	rect.width = std::max(a.x + a.width, b.x + b.width) - rect.x;
+	rect.height = std::max(a.y + a.height, b.y + b.height) - rect.y;
+	rect.min_depth = std::min(a.min_depth, b.min_depth);
+	rect.max_depth = std::max(a.max_depth, b.max_depth);
+	rect.empty = false;
+	rect.full = a.full || b.full;
+
+	return rect;
+}
+
+LightBounds::Rect LightBounds::group_bounds(const LightStorage &lights,
+					   int first, int count,
+					   const Matrix4f &view_projection,
+					   int width, int height)
+{
+	if (first < lights.get_directional().sources.size())
+		return full_rect(width, height);
+
+	Rect rect = empty_rect();
+
+	const LightStorage::PointLights &point = lights.get_point();
+	int point_end = std::min<int>(first + count, point.sources.size());
+	for (int i = first; i < point_end; i++) {
+		rect = merge(rect, project_sphere(point.position[i],
+						  point.range[i],
+						  view_projection, width,
+						  height));
+	}
+
+	const LightStorage::SpotLights &spot = lights.get_spot();
+	int spot_end = std::min<int>(first + count, spot.sources.size());
+	for (int i = first; i < spot_end; i++) {
+		Vector3f center;
+		float radius;
+		spot_sphere(spot.point.position[i], spot.direction[i],
+			    spot.point.range[i], spot.cutoff[i], center,
+			    radius);
+		rect = merge(rect, project_sphere(center, radius,
+						  view_projection, width,
+						  height));
+	}
+
+	return rect;
+}
@@ -0,0 +1,146 @@
+#include <graphics/LightStorage.h>
+
+#include <math/Vector3f.h>
+#include <math/Transform.h>
+
+#include <components/DirectionalLight.h>
+#include <components/PointLight.h>
+#include <components/SpotLight.h>
+
+#include <vector>
+#include <algorithm>
+
+LightStorage &LightStorage::get_instance()
+{
+	static LightStorage instance;
+	return instance;
+}
+
+LightStorage::LightStorage()
+	: active(0)
+{
+}
+
+template <class T> static bool contains(const std::vector<T *> &v, T *value)
+{
+	return std::find(v.begin(), v.end(), value) != v.end();
+}
+
+static void resize(LightStorage::PointLights &lights)
+{
+	int size = lights.sources.size();
+	lights.color.resize(size);
+	lights.intensity.resize(size);
+	lights.attenuation.resize(size);
+	lights.range.resize(size);
+	lights.position.resize(size);
+}
+
+void LightStorage::add(DirectionalLight *light)
+{
+	if (contains(directional.sources, light))
+		return;
+
+	directional.sources.push_back(light);
+	int size = directional.sources.size();
+	directional.color.resize(size);
+	directional.intensity.resize(size);
+	directional.direction.resize(size);
+}
+
+void LightStorage::add(PointLight *light)
+{
+	if (contains(point.sources, light))
+		return;
+
+	point.sources.push_back(light);
+	resize(point);
+}
+
+void LightStorage::add(SpotLight *light)
+{
+	if (contains(spot.sources, light))
+		return;
+
+	spot.sources.push_back(light);
+	spot.point.sources.push_back(light);
+	resize(spot.point);
+	spot.direction.resize(spot.sources.size());
+	spot.cutoff.resize(spot.sources.size());
+}
+
+void LightStorage::clear() noexcept
+{
+	directional = {};
+	point = {};
+	spot = {};
+	active = 0;
+}
+
+static void update_point(LightStorage::PointLights &lights, int i)
+{
+	const PointLight *light = lights.sources[i];
+	lights.color[i] = light->color;
+	lights.intensity[i] = light->intensity;
+	lights.attenuation[i] = light->attenuation;
+	lights.range[i] = light->range;
+	lights.position[i] =
+		light->get_parent_transform()->get_transformed_position();
+}
+
+void LightStorage::update()
+{
+	for (int i = 0; i < directional.sources.size(); i++) {
+		const DirectionalLight *light = directional.sources[i];
+		directional.color[i] = light->color;
+		directional.intensity[i] = light->intensity;
+		directional.direction[i] = light->get_parent_transform()
+						   ->get_transformed_rotation()
+						   .get_forward();
+	}
+
+	for (int i = 0; i < point.sources.size(); i++) {
+		update_point(point, i);
+	}
+
+	for (int i = 0; i < spot.sources.size(); i++) {
+		update_point(spot.point, i);
+		spot.direction[i] = spot.sources[i]
+					    ->get_parent_transform()
+					    ->get_transformed_rotation()
+					    .get_forward();
+		spot.cutoff[i] = spot.sources[i]->cutoff;
+	}
+}
+
+const LightStorage::DirectionalLights &
+LightStorage::get_directional() const noexcept
+{
+	return directional;
+}
+
+const LightStorage::PointLights &LightStorage::get_point() const noexcept
+{
+	return point;
+}
+
+const LightStorage::SpotLights &LightStorage::get_spot() const noexcept
+{
+	return spot;
+}
+
+void LightStorage::set_active(int index) noexcept
+{
+	active = index;
+}
+
+int LightStorage::get_active() const noexcept
+{
+	return active;
+}
+
+int LightStorage::size() const noexcept
+{
+	return directional.sources.size() + point.sources.size() +
+	       spot.sources.size();
+}
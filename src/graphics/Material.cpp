@@ -2,40 +2,148 @@
 
 #include <math/Vector3f.h>
 
-#include <components/SharedGlobals.h>
+#include <graphics/Specular.h>
+#include <graphics/MaterialTable.h>
 
 #include <memory>
 #include <string>
+#include <algorithm>
+#include <unordered_map>
 
-const Material Material::None{};
+// Extras are sorted by id, returns where id is or would be inserted
+template <class Extras> static auto find_extra(Extras &extras, int id)
+{
+	return std::lower_bound(extras.begin(), extras.end(), id,
+				[](const auto &entry, int id) {
+					return entry.first < id;
+				});
+}
+
+bool MaterialData::operator==(const MaterialData &other) const noexcept
+{
+	return diffuse == other.diffuse && cubemap == other.cubemap &&
+	       specular.intensity == other.specular.intensity &&
+	       specular.exponent == other.specular.exponent &&
+	       ambient == other.ambient && skeleton == other.skeleton &&
+	       flags == other.flags && extras == other.extras;
+}
+
+Material::PropertyID Material::intern(const std::string &name)
+{
+	static std::unordered_map<std::string, PropertyID> ids;
+	auto [it, inserted] = ids.try_emplace(name, ids.size());
+	return it->second;
+}
 
 Material::Material()
-	: property{}
+	: index(MaterialTable::get_instance().allocate())
+{
+}
+
+Material::Material(const Material &other)
+	: index(MaterialTable::get_instance().allocate())
 {
+	MaterialTable &table = MaterialTable::get_instance();
+	table.get(index) = table.get(other.index);
+}
+
+Material &Material::operator=(const Material &other)
+{
+	MaterialTable &table = MaterialTable::get_instance();
+	table.get(index) = table.get(other.index);
+	return *this;
 }
 
 Material::~Material()
 {
-	property.clear();
+	MaterialTable::get_instance().release(index);
 }
 
-Material &Material::add_property(const std::string &name,
-				 std::shared_ptr<void> property)
+Material &Material::set_diffuse(std::shared_ptr<void> texture)
 {
-	this->property[name] = property;
+	MaterialData &data = MaterialTable::get_instance().get(index);
+	data.diffuse = static_cast<Texture *>(texture.get());
+	data.diffuse_owner = texture;
+	data.flags |= MaterialData::HAS_DIFFUSE;
 	return *this;
 }
 
-void *Material::get_property(const std::string &name) const noexcept
+Material &Material::set_cubemap(std::shared_ptr<void> texture)
 {
-	if (!property.count(name))
-		return (void *)(&Material::None);
+	MaterialData &data = MaterialTable::get_instance().get(index);
+	data.cubemap = static_cast<Texture *>(texture.get());
+	data.cubemap_owner = texture;
+	data.flags |= MaterialData::HAS_CUBEMAP;
+	return *this;
+}
 
-	return property.at(name).get();
+Material &Material::set_specular(const Specular &specular)
+{
+	MaterialTable::get_instance().get(index).specular = specular;
+	return *this;
+}
+
+Material &Material::set_ambient(const Vector3f &ambient)
+{
+	MaterialData &data = MaterialTable::get_instance().get(index);
+	data.ambient = ambient;
+	data.flags |= MaterialData::HAS_AMBIENT;
+	return *this;
 }
 
-void Material::delete_property(const std::string &name) noexcept
+Material &Material::set_skeleton(Skeleton *skeleton)
 {
-	if (property.count(name))
-		property.erase(name);
-}
\ No newline at end of file
+	MaterialData &data = MaterialTable::get_instance().get(index);
+	data.skeleton = skeleton;
+	if (skeleton) {
+		data.flags |= MaterialData::SKINNED;
+	} else {
+		data.flags &= ~MaterialData::SKINNED;
+	}
+	return *this;
+}
+
+Material &Material::add_property(PropertyID id, std::shared_ptr<void> property)
+{
+	auto &extras = MaterialTable::get_instance().get(index).extras;
+	auto it = find_extra(extras, id);
+	if (it != extras.end() && it->first == id) {
+		it->second = property;
+	} else {
+		extras.insert(it, { id, property });
+	}
+	return *this;
+}
+
+void *Material::get_property(PropertyID id) const noexcept
+{
+	const auto &extras = MaterialTable::get_instance().get(index).extras;
+	auto it = find_extra(extras, id);
+	if (it == extras.end() || it->first != id)
+		return nullptr;
+
+	return it->second.get();
+}
+
+void Material::delete_property(PropertyID id) noexcept
+{
+	auto &extras = MaterialTable::get_instance().get(index).extras;
+	auto it = find_extra(extras, id);
+	if (it != extras.end() && it->first == id)
+		extras.erase(it);
+}
+
+int Material::get_index() const noexcept
+{
+	return index;
+}
+
+const MaterialData &Material::get_data() const noexcept
+{
+	return MaterialTable::get_instance().get(index);
+}
+
+bool Material::operator==(const Material &other) const noexcept
+{
+	return index == other.index || get_data() == other.get_data();
+}
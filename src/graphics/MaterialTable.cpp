@@ -0,0 +1,51 @@
+#include <graphics/MaterialTable.h>
+
+#include <graphics/Material.h>
+
+#include <vector>
+
+MaterialTable &MaterialTable::get_instance()
+{
+	static MaterialTable instance;
+	return instance;
+}
+
+MaterialTable::MaterialTable()
+	: materials{}
+	, free_slots{}
+{
+}
+
+int MaterialTable::allocate()
+{
+	if (free_slots.empty()) {
+		materials.emplace_back();
+		return materials.size() - 1;
+	}
+
+	int index = free_slots.back();
+	free_slots.pop_back();
+	return index;
+}
+
+void MaterialTable::release(int index)
+{
+	// Drop the texture references now rather than on reuse
+	materials[index] = MaterialData{};
+	free_slots.push_back(index);
+}
+
+MaterialData &MaterialTable::get(int index) noexcept
+{
+	return materials[index];
+}
+
+const MaterialData &MaterialTable::get(int index) const noexcept
+{
+	return materials[index];
+}
+
+int MaterialTable::size() const noexcept
+{
+	return materials.size();
+}
@@ -4,7 +4,11 @@
 #include <GLFW/glfw3.h>
 
 #include <graphics/Vertex.h>
+#include <graphics/VertexLayout.h>
+#include <graphics/MeshOptimizer.h>
 #include <graphics/Material.h>
+#include <graphics/GLState.h>
+#include <graphics/IndirectRenderer.h>
 #include <graphics/mesh_models/OBJModel.h>
 #include <graphics/mesh_models/FBXModel.h>
 #include <graphics/resource_management/MeshResource.h>
@@ -16,7 +20,11 @@
 #include <sstream>
 #include <string>
 #include <cstdlib>
+#include <array>
+#include <memory>
+#include <utility>
 #include <exception>
+#include <algorithm>
 
 std::unordered_map<std::string, int> loaded_file_ids;
 
@@ -27,16 +35,26 @@ std::unordered_map<int, std::pair<std::vector<btScalar>, std::vector<int> > >
 
 std::unordered_map<int, std::vector<Vertex> > all_vertices{};
 
-void Mesh::pre_load(const std::string &file_path)
-{
-	if (loaded_file_ids.count(file_path))
-		return;
+std::unordered_map<int, std::vector<std::vector<int> > > all_lods{};
 
-	static int id = -1;
-	loaded_file_ids[file_path] = ++id;
-	std::cout << "Preloading Mesh Asset (" << id << "): " << file_path
-		  << '\n';
+static std::size_t index_size(GLenum index_type)
+{
+	return index_type == GL_UNSIGNED_SHORT ? sizeof(unsigned short) :
+						 sizeof(int);
+}
 
+// Everything pre_load keeps per file, built without touching GL
+struct MeshData {
+	std::vector<Vertex> vertices;
+	std::vector<int> indices;
+	std::vector<std::vector<int> > lods;
+	std::vector<btScalar> bullet_vertices;
+};
+
+// Safe on any thread, label tags the log lines
+static MeshData decode_mesh(const std::string &file_path,
+			    const std::string &label)
+{
 	IndexedModel model;
 	if (file_path.ends_with(".obj")) {
 		std::ifstream file(file_path);
@@ -56,10 +74,10 @@ void Mesh::pre_load(const std::string &file_path)
 		throw std::runtime_error("File type is not supported");
 	}
 
-	std::cout << "Preloading (" << id << "): Loaded into memory\n";
+	std::cout << "Preloading (" << label << "): Loaded into memory\n";
 
-	all_vertices[id] = {};
-	auto &vertices = all_vertices[id];
+	MeshData data;
+	auto &vertices = data.vertices;
 
 	for (int i = 0; i < model.positions.size(); i++) {
 		Vertex vertex(model.positions[i], model.texCoords[i],
@@ -69,14 +87,50 @@ void Mesh::pre_load(const std::string &file_path)
 		vertices.push_back(vertex);
 	}
 
-	all_bullet_vertices[id] = { {}, model.indices };
-	auto &[bullet_vertices, _] = all_bullet_vertices[id];
+	// Every mesh is drawn once per light, so vertex shading savings
+	// are multiplied by the light count
+	float acmr = MeshOptimizer::compute_acmr(model.indices, vertices.size());
+	MeshOptimizer::optimize_vertex_cache(model.indices, vertices.size());
+	MeshOptimizer::optimize_overdraw(model.indices, vertices);
+	MeshOptimizer::optimize_vertex_fetch(vertices, model.indices);
+	std::cout << "Preloading (" << label << "): Optimized "
+		  << vertices.size() << " vertices, ACMR " << acmr << " -> "
+		  << MeshOptimizer::compute_acmr(model.indices, vertices.size())
+		  << '\n';
+
+	data.lods = MeshOptimizer::generate_lods(model.indices, vertices);
+	std::cout << "Preloading (" << label << "): " << data.lods.size()
+		  << " LODs\n";
+
+	data.indices = std::move(model.indices);
 	for (Vertex &vertex : vertices) {
-		bullet_vertices.push_back(vertex.get_pos().getX());
-		bullet_vertices.push_back(vertex.get_pos().getY());
-		bullet_vertices.push_back(vertex.get_pos().getZ());
+		data.bullet_vertices.push_back(vertex.get_pos().getX());
+		data.bullet_vertices.push_back(vertex.get_pos().getY());
+		data.bullet_vertices.push_back(vertex.get_pos().getZ());
 	}
 
+	return data;
+}
+
+static int store_mesh(const std::string &file_path, MeshData data)
+{
+	static int id = -1;
+	loaded_file_ids[file_path] = ++id;
+
+	all_vertices[id] = std::move(data.vertices);
+	all_lods[id] = std::move(data.lods);
+	all_bullet_vertices[id] = { std::move(data.bullet_vertices),
+				    std::move(data.indices) };
+	return id;
+}
+
+void Mesh::pre_load(const std::string &file_path)
+{
+	if (loaded_file_ids.count(file_path))
+		return;
+
+	std::cout << "Preloading Mesh Asset: " << file_path << '\n';
+	int id = store_mesh(file_path, decode_mesh(file_path, file_path));
 	std::cout << "Preloading (" << id << "): Done\n";
 }
 
@@ -103,7 +157,7 @@ Mesh Mesh::load_mesh(const std::string &file_path,
 	}
 
 	mesh.add_vertices(all_vertices[id], all_bullet_vertices[id].second,
-			  false, mesh_physics_type);
+			  false, mesh_physics_type, all_lods[id]);
 
 	mesh.update_physics(id);
 
@@ -166,7 +220,8 @@ void Mesh::update_physics(int id)
 }
 
 void Mesh::add_vertices(std::vector<Vertex> vertices, std::vector<int> indices,
-			bool normals, MeshPhysicsType mesh_physics_type)
+			bool normals, MeshPhysicsType mesh_physics_type,
+			const std::vector<std::vector<int> > &lod_indices)
 {
 	if (buffers == nullptr) {
 		this->reset_mesh();
@@ -179,68 +234,106 @@ void Mesh::add_vertices(std::vector<Vertex> vertices, std::vector<int> indices,
 		this->calculate_normals(vertices, indices);
 	}
 
+	Staging staging = prepare(vertices, std::move(indices), lod_indices);
+
+	glGenBuffers(1, &buffers->vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, buffers->vbo);
+	glBufferData(GL_ARRAY_BUFFER, staging.vertices.size(),
+		     staging.vertices.data(), GL_STATIC_DRAW);
+
+	glGenBuffers(1, &buffers->ebo);
+	glBindBuffer(GL_ARRAY_BUFFER, buffers->ebo);
+	glBufferData(GL_ARRAY_BUFFER, staging.indices.size(),
+		     staging.indices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	create_vertex_array();
+	add_geometry(staging);
+}
+
+Mesh::Staging Mesh::prepare(const std::vector<Vertex> &vertices,
+			    std::vector<int> indices,
+			    const std::vector<std::vector<int> > &lod_indices)
+{
 	buffers->size = vertices.size();
 	buffers->isize = indices.size();
 
-	std::vector<float> buffer(buffers->size * Vertex::SIZE);
+	// LODs share the vertex buffer, their indices follow the base mesh
+	buffers->lods = { { 0, static_cast<int>(indices.size()) } };
+	for (const std::vector<int> &lod : lod_indices) {
+		buffers->lods.push_back({ static_cast<int>(indices.size()),
+					  static_cast<int>(lod.size()) });
+		indices.insert(indices.end(), lod.begin(), lod.end());
+	}
 
-	int i = 0;
-	for (const Vertex &v : vertices) {
-		Vector3f pos = v.get_pos();
-		Vector3f normal = v.get_normal();
-		Vector2f tex_coord = v.get_texCoord();
-		buffer[i++] = pos.getX();
-		buffer[i++] = pos.getY();
-		buffer[i++] = pos.getZ();
-		buffer[i++] = tex_coord.getX();
-		buffer[i++] = tex_coord.getY();
-		buffer[i++] = normal.getX();
-		buffer[i++] = normal.getY();
-		buffer[i++] = normal.getZ();
-
-		for (int j = 0; j < 4; ++j) {
-			buffer[i++] = v.boneIndices[j];
-		}
-		for (int j = 0; j < 4; ++j) {
-			buffer[i++] = v.boneWeights[j];
+	std::array<float, 3> lo{}, hi{};
+	for (int i = 0; i < vertices.size(); i++) {
+		std::array<float, 3> pos = vertices[i].get_pos().get();
+		for (int k = 0; k < 3; k++) {
+			lo[k] = i ? std::min(lo[k], pos[k]) : pos[k];
+			hi[k] = i ? std::max(hi[k], pos[k]) : pos[k];
 		}
 	}
+	buffers->center = { (lo[0] + hi[0]) / 2, (lo[1] + hi[1]) / 2,
+			    (lo[2] + hi[2]) / 2 };
+	buffers->radius = 0;
+	for (const Vertex &v : vertices) {
+		buffers->radius = std::max(
+			buffers->radius, (v.get_pos() - buffers->center).length());
+	}
 
-	glGenVertexArrays(1, &buffers->vao);
-	glBindVertexArray(buffers->vao);
+	const VertexLayout &layout = VertexLayout::select(vertices);
+	buffers->layout = layout.get_type();
+
+	Staging staging;
+	staging.vertices = layout.pack(vertices);
+
+	if (vertices.size() <= 0x10000) {
+		std::vector<unsigned short> short_indices(indices.begin(),
+							  indices.end());
+		buffers->index_type = GL_UNSIGNED_SHORT;
+		auto *bytes = reinterpret_cast<const unsigned char *>(
+			short_indices.data());
+		staging.indices.assign(bytes,
+				       bytes + short_indices.size() *
+						       sizeof(unsigned short));
+	} else {
+		buffers->index_type = GL_UNSIGNED_INT;
+		auto *bytes =
+			reinterpret_cast<const unsigned char *>(indices.data());
+		staging.indices.assign(bytes,
+				       bytes + indices.size() * sizeof(int));
+	}
 
-	glEnableVertexAttribArray(0); // Position
-	glEnableVertexAttribArray(1); // TexCoord
-	glEnableVertexAttribArray(2); // Normal
-	glEnableVertexAttribArray(3); // Bone Indices
-	glEnableVertexAttribArray(4); // Bone Weights
+	// The shared pool only holds the static layout
+	if (layout.get_type() != VertexLayout::Type::STATIC) {
+		staging.pool_vertices = VertexLayout::STATIC.pack(vertices);
+	}
+	staging.pool_indices = std::move(indices);
 
-	glGenBuffers(1, &buffers->vbo);
-	glBindBuffer(GL_ARRAY_BUFFER, buffers->vbo);
-	glBufferData(GL_ARRAY_BUFFER, buffer.size() * sizeof(float),
-		     buffer.data(), GL_STATIC_DRAW);
-
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE,
-			      Vertex::SIZE * sizeof(float), (void *)0);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE,
-			      Vertex::SIZE * sizeof(float),
-			      (void *)(3 * sizeof(float)));
-	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE,
-			      Vertex::SIZE * sizeof(float),
-			      (void *)(5 * sizeof(float)));
-	glVertexAttribIPointer(3, 4, GL_INT, Vertex::SIZE * sizeof(float),
-			       (void *)(8 * sizeof(float)));
-	glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE,
-			      Vertex::SIZE * sizeof(float),
-			      (void *)(12 * sizeof(float)));
+	return staging;
+}
 
-	glGenBuffers(1, &buffers->ebo);
+void Mesh::create_vertex_array()
+{
+	glGenVertexArrays(1, &buffers->vao);
+	GLState::get_instance().bind_vertex_array(buffers->vao);
+
+	glBindBuffer(GL_ARRAY_BUFFER, buffers->vbo);
+	VertexLayout::get(buffers->layout).apply();
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers->ebo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(int),
-		     indices.data(), GL_STATIC_DRAW);
 
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+	GLState::get_instance().bind_vertex_array(0);
+}
+
+void Mesh::add_geometry(const Staging &staging)
+{
+	IndirectRenderer::get_instance().add_geometry(
+		*buffers,
+		staging.pool_vertices.empty() ? staging.vertices :
+						staging.pool_vertices,
+		staging.pool_indices);
 }
 
 Mesh::Mesh() {};
@@ -264,9 +357,59 @@ void Mesh::draw() const
 		throw std::runtime_error("VAO not initialized\n");
 	}
 
-	glBindVertexArray(buffers->vao);
-	glDrawElements(GL_TRIANGLES, buffers->isize, GL_UNSIGNED_INT, 0);
-	glBindVertexArray(0);
+	const MeshResource::LOD &range = buffers->lods[lod];
+	GLState::get_instance().bind_vertex_array(buffers->vao);
+	glDrawElements(GL_TRIANGLES, range.count, buffers->index_type,
+		       (void *)(range.first * index_size(buffers->index_type)));
+}
+
+void Mesh::draw_instanced(GLuint instance_buffer, std::size_t offset,
+			  int count, GLuint vao) const
+{
+	if (buffers->vao == 0) {
+		std::cerr << "VAO not initialized\n";
+		throw std::runtime_error("VAO not initialized\n");
+	}
+
+	GLState::get_instance().bind_vertex_array(vao ? vao : buffers->vao);
+
+	// Per-instance model matrix, one column per attribute slot (5 - 8)
+	glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+	for (int i = 0; i < 4; i++) {
+		glEnableVertexAttribArray(5 + i);
+		glVertexAttribPointer(5 + i, 4, GL_FLOAT, GL_FALSE,
+				      16 * sizeof(float),
+				      (void *)(offset + i * 4 * sizeof(float)));
+		glVertexAttribDivisor(5 + i, 1);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	const MeshResource::LOD &range = buffers->lods[lod];
+	glDrawElementsInstanced(
+		GL_TRIANGLES, range.count, buffers->index_type,
+		(void *)(range.first * index_size(buffers->index_type)), count);
+}
+
+MeshResource *Mesh::get_resource() const noexcept
+{
+	return buffers.get();
+}
+
+int Mesh::get_lod() const noexcept
+{
+	return lod;
+}
+
+void Mesh::set_lod(int lod) noexcept
+{
+	this->lod = std::clamp(lod, 0, get_lod_count() - 1);
+}
+
+int Mesh::get_lod_count() const noexcept
+{
+	if (buffers == nullptr || buffers->lods.empty())
+		return 1;
+	return buffers->lods.size();
 }
 
 void Mesh::calculate_normals(std::vector<Vertex> &vertices,
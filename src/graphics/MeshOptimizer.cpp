@@ -0,0 +1,655 @@
+#include <graphics/MeshOptimizer.h>
+
+#include <math/Vector3f.h>
+
+#include <graphics/Vertex.h>
+
+#include <map>
+#include <array>
+#include <vector>
+#include <cmath>
+#include <tuple>
+#include <utility>
+#include <numeric>
+#include <algorithm>
+
+// Tuning constants from Forsyth's "Linear-Speed Vertex Cache Optimisation"
+static const float CACHE_DECAY_POWER = 1.5f;
+static const float LAST_TRIANGLE_SCORE = 0.75f;
+static const float VALENCE_BOOST_SCALE = 2.0f;
+static const float VALENCE_BOOST_POWER = 0.5f;
+
+static float vertex_score(int cache_position, int remaining)
+{
+	if (remaining == 0)
+		return -1.0f;
+
+	float score = 0.0f;
+	if (cache_position >= 0) {
+		if (cache_position < 3) {
+			// Vertices of the last triangle are penalised slightly
+			score = LAST_TRIANGLE_SCORE;
+		} else {
+			float scaler = 1.0f / (MeshOptimizer::CACHE_SIZE - 3);
+			score = std::pow(1.0f - (cache_position - 3) * scaler,
+					 CACHE_DECAY_POWER);
+		}
+	}
+
+	// Favour vertices with few triangles left, to finish them off
+	score += VALENCE_BOOST_SCALE *
+		 std::pow(static_cast<float>(remaining), -VALENCE_BOOST_POWER);
+	return score;
+}
+
+void MeshOptimizer::optimize_vertex_cache(std::vector<int> &indices,
+					  int vertex_count)
+{
+	int triangle_count = indices.size() / 3;
+	if (triangle_count == 0)
+		return;
+
+	// Per-vertex list of triangles not yet emitted, kept at the front of
+	// each vertex's slice of vertex_triangles
+	std::vector<int> remaining(vertex_count, 0);
+	for (int index : indices) {
+		remaining[index]++;
+	}
+	std::vector<int> offsets(vertex_count, 0);
+	for (int v = 1; v < vertex_count; v++) {
+		offsets[v] = offsets[v - 1] + remaining[v - 1];
+	}
+	std::vector<int> vertex_triangles(indices.size());
+	std::vector<int> filled(vertex_count, 0);
+	for (int i = 0; i < indices.size(); i++) {
+		int v = indices[i];
+		vertex_triangles[offsets[v] + filled[v]++] = i / 3;
+	}
+
+	std::vector<int> cache_position(vertex_count, -1);
+	std::vector<float> score(vertex_count);
+	for (int v = 0; v < vertex_count; v++) {
+		score[v] = vertex_score(-1, remaining[v]);
+	}
+
+	std::vector<float> triangle_score(triangle_count, 0.0f);
+	for (int t = 0; t < triangle_count; t++) {
+		for (int k = 0; k < 3; k++) {
+			triangle_score[t] += score[indices[t * 3 + k]];
+		}
+	}
+
+	std::vector<bool> emitted(triangle_count, false);
+	std::vector<int> result;
+	result.reserve(indices.size());
+
+	std::vector<int> cache;
+	std::vector<int> new_cache;
+	cache.reserve(CACHE_SIZE + 3);
+	new_cache.reserve(CACHE_SIZE + 3);
+
+	int best = std::max_element(triangle_score.begin(),
+				    triangle_score.end()) -
+		   triangle_score.begin();
+	int scan = 0;
+
+	for (int i = 0; i < triangle_count; i++) {
+		if (best == -1) {
+			// Nothing left around the cache, restart elsewhere
+			while (emitted[scan]) {
+				scan++;
+			}
+			best = scan;
+		}
+
+		emitted[best] = true;
+		const int *triangle = &indices[best * 3];
+		result.insert(result.end(), triangle, triangle + 3);
+
+		for (int k = 0; k < 3; k++) {
+			int v = triangle[k];
+			int *first = &vertex_triangles[offsets[v]];
+			int *last = first + remaining[v];
+			std::iter_swap(std::find(first, last, best), last - 1);
+			remaining[v]--;
+		}
+
+		// Emitted vertices move to the front of the LRU cache
+		new_cache.clear();
+		for (int k = 0; k < 3; k++) {
+			if (std::find(new_cache.begin(), new_cache.end(),
+				      triangle[k]) == new_cache.end()) {
+				new_cache.push_back(triangle[k]);
+			}
+		}
+		for (int v : cache) {
+			if (std::find(new_cache.begin(), new_cache.end(), v) ==
+			    new_cache.end()) {
+				new_cache.push_back(v);
+			}
+		}
+
+		for (int k = 0; k < new_cache.size(); k++) {
+			int v = new_cache[k];
+			cache_position[v] = k < CACHE_SIZE ? k : -1;
+
+			float new_score =
+				vertex_score(cache_position[v], remaining[v]);
+			float delta = new_score - score[v];
+			score[v] = new_score;
+			for (int j = 0; j < remaining[v]; j++) {
+				triangle_score[vertex_triangles[offsets[v] +
+								j]] += delta;
+			}
+		}
+		if (new_cache.size() > CACHE_SIZE) {
+			new_cache.resize(CACHE_SIZE);
+		}
+		cache.swap(new_cache);
+
+		best = -1;
+		float best_score = -1.0f;
+		for (int v : cache) {
+			for (int j = 0; j < remaining[v]; j++) {
+				int t = vertex_triangles[offsets[v] + j];
+				if (triangle_score[t] > best_score) {
+					best_score = triangle_score[t];
+					best = t;
+				}
+			}
+		}
+	}
+
+	indices.swap(result);
+}
+
+void MeshOptimizer::optimize_overdraw(std::vector<int> &indices,
+				      const std::vector<Vertex> &vertices,
+				      float threshold)
+{
+	int triangle_count = indices.size() / 3;
+	if (triangle_count == 0)
+		return;
+
+	// FIFO cache simulation through timestamps
+	std::vector<int> cache_time(vertices.size(), 0);
+	int timestamp = CACHE_SIZE + 1;
+	auto triangle_misses = [&](int t) {
+		int misses = 0;
+		for (int k = 0; k < 3; k++) {
+			int v = indices[t * 3 + k];
+			if (timestamp - cache_time[v] > CACHE_SIZE) {
+				cache_time[v] = timestamp++;
+				misses++;
+			}
+		}
+		return misses;
+	};
+	auto reset_cache = [&]() { timestamp += CACHE_SIZE + 1; };
+
+	// Hard boundaries: the cache was fully flushed at this triangle
+	std::vector<int> hard_clusters;
+	for (int t = 0; t < triangle_count; t++) {
+		if (triangle_misses(t) == 3) {
+			hard_clusters.push_back(t);
+		}
+	}
+	if (hard_clusters.empty() || hard_clusters[0] != 0) {
+		hard_clusters.insert(hard_clusters.begin(), 0);
+	}
+
+	// Soft boundaries: wherever splitting costs little cache efficiency
+	std::vector<int> clusters;
+	for (int c = 0; c < hard_clusters.size(); c++) {
+		int start = hard_clusters[c];
+		int end = c + 1 < hard_clusters.size() ? hard_clusters[c + 1] :
+							 triangle_count;
+
+		reset_cache();
+		int cluster_misses = 0;
+		for (int t = start; t < end; t++) {
+			cluster_misses += triangle_misses(t);
+		}
+		float cluster_acmr =
+			static_cast<float>(cluster_misses) / (end - start);
+
+		reset_cache();
+		clusters.push_back(start);
+		int sub_start = start;
+		int misses = 0;
+		for (int t = start; t < end; t++) {
+			misses += triangle_misses(t);
+			float acmr = static_cast<float>(misses) /
+				     (t + 1 - sub_start);
+			if (t + 1 < end && acmr <= cluster_acmr * threshold) {
+				clusters.push_back(t + 1);
+				sub_start = t + 1;
+				misses = 0;
+				reset_cache();
+			}
+		}
+	}
+
+	// Sort clusters so outward facing ones on the hull come first
+	std::vector<Vector3f> cluster_centroid(clusters.size());
+	std::vector<Vector3f> cluster_normal(clusters.size());
+	Vector3f mesh_centroid;
+	float mesh_area = 0.0f;
+
+	for (int c = 0; c < clusters.size(); c++) {
+		int end = c + 1 < clusters.size() ? clusters[c + 1] :
+						    triangle_count;
+		float cluster_area = 0.0f;
+		for (int t = clusters[c]; t < end; t++) {
+			Vector3f p0 = vertices[indices[t * 3]].get_pos();
+			Vector3f p1 = vertices[indices[t * 3 + 1]].get_pos();
+			Vector3f p2 = vertices[indices[t * 3 + 2]].get_pos();
+
+			Vector3f normal = (p1 - p0).cross(p2 - p0);
+			float area = normal.length();
+			Vector3f centroid = (p0 + p1 + p2) / 3.0f;
+
+			cluster_centroid[c] += centroid * area;
+			cluster_normal[c] += normal;
+			cluster_area += area;
+		}
+		mesh_centroid += cluster_centroid[c];
+		mesh_area += cluster_area;
+		if (cluster_area > 0) {
+			cluster_centroid[c] /= cluster_area;
+		}
+	}
+	if (mesh_area > 0) {
+		mesh_centroid /= mesh_area;
+	}
+
+	std::vector<float> sort_key(clusters.size());
+	for (int c = 0; c < clusters.size(); c++) {
+		sort_key[c] = (cluster_centroid[c] - mesh_centroid)
+				      .dot(cluster_normal[c].normalize());
+	}
+
+	std::vector<int> order(clusters.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+		return sort_key[a] > sort_key[b];
+	});
+
+	std::vector<int> result;
+	result.reserve(indices.size());
+	for (int c : order) {
+		int end = c + 1 < clusters.size() ? clusters[c + 1] :
+						    triangle_count;
+		result.insert(result.end(), indices.begin() + clusters[c] * 3,
+			      indices.begin() + end * 3);
+	}
+
+	indices.swap(result);
+}
+
+void MeshOptimizer::optimize_vertex_fetch(std::vector<Vertex> &vertices,
+					  std::vector<int> &indices)
+{
+	std::vector<int> remap(vertices.size(), -1);
+	std::vector<Vertex> reordered;
+	reordered.reserve(vertices.size());
+
+	for (int &index : indices) {
+		if (remap[index] == -1) {
+			remap[index] = reordered.size();
+			reordered.push_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+
+	vertices.swap(reordered);
+}
+
+// Symmetric 4x4 error quadric, upper triangle stored row by row
+struct Quadric {
+	double a[10] = { 0 };
+
+	void add_plane(double x, double y, double z, double w) noexcept
+	{
+		double plane[4] = { x, y, z, w };
+		int k = 0;
+		for (int i = 0; i < 4; i++) {
+			for (int j = i; j < 4; j++) {
+				a[k++] += plane[i] * plane[j];
+			}
+		}
+	}
+
+	Quadric operator+(const Quadric &q) const noexcept
+	{
+		Quadric result;
+		for (int i = 0; i < 10; i++) {
+			result.a[i] = a[i] + q.a[i];
+		}
+		return result;
+	}
+
+	double evaluate(const Vector3f &p) const noexcept
+	{
+		double v[4] = { p.getX(), p.getY(), p.getZ(), 1.0 };
+		double result = 0;
+		int k = 0;
+		for (int i = 0; i < 4; i++) {
+			for (int j = i; j < 4; j++) {
+				result += (i == j ? 1 : 2) * a[k++] * v[i] * v[j];
+			}
+		}
+		return result;
+	}
+};
+
+std::vector<int> MeshOptimizer::simplify(const std::vector<int> &indices,
+					 const std::vector<Vertex> &vertices,
+					 int target_index_count,
+					 float target_error,
+					 float *result_error)
+{
+	int vertex_count = vertices.size();
+	std::vector<int> result = indices;
+	if (result_error != nullptr) {
+		*result_error = 0.0f;
+	}
+
+	// Collapse vertices that share a position into one position id
+	std::map<std::array<float, 3>, int> position_ids;
+	std::vector<int> position(vertex_count);
+	std::vector<Vector3f> points;
+	for (int v = 0; v < vertex_count; v++) {
+		auto [it, inserted] = position_ids.try_emplace(
+			vertices[v].get_pos().get(), position_ids.size());
+		position[v] = it->second;
+		if (inserted) {
+			points.push_back(vertices[v].get_pos());
+		}
+	}
+	int position_count = points.size();
+
+	// Vertices at one position with the same UVs and bone weights form a
+	// wedge. Normals may differ within a wedge, hard edges still collapse
+	using WedgeKey = std::tuple<int, std::array<float, 2>,
+				    std::array<int, 4>, std::array<float, 4> >;
+	std::map<WedgeKey, int> wedge_ids;
+	std::vector<int> wedge(vertex_count);
+	std::vector<int> position_wedges(position_count, 0);
+	for (int v = 0; v < vertex_count; v++) {
+		auto [it, inserted] = wedge_ids.try_emplace(
+			WedgeKey{ position[v], vertices[v].get_texCoord().get(),
+				  vertices[v].boneIndices,
+				  vertices[v].boneWeights },
+			wedge_ids.size());
+		wedge[v] = it->second;
+		if (inserted) {
+			position_wedges[position[v]]++;
+		}
+	}
+
+	// An edge is on a seam when its triangles use different wedges
+	struct Edge {
+		int count = 0;
+		std::array<int, 2> wedges;
+		bool seam = false;
+	};
+	std::map<std::pair<int, int>, Edge> edges;
+	for (int t = 0; t < result.size() / 3; t++) {
+		for (int k = 0; k < 3; k++) {
+			int a = result[t * 3 + k];
+			int b = result[t * 3 + (k + 1) % 3];
+			if (position[a] > position[b]) {
+				std::swap(a, b);
+			}
+			Edge &edge = edges[{ position[a], position[b] }];
+			if (edge.count++ == 0) {
+				edge.wedges = { wedge[a], wedge[b] };
+			} else if (edge.wedges !=
+				   std::array<int, 2>{ wedge[a], wedge[b] }) {
+				edge.seam = true;
+			}
+		}
+	}
+
+	// Open borders and seam junctions never move. A seam through a
+	// position (two wedges) may still slide along itself
+	std::vector<bool> locked(position_count, false);
+	for (int p = 0; p < position_count; p++) {
+		locked[p] = position_wedges[p] > 2;
+	}
+	for (auto &[ends, edge] : edges) {
+		if (edge.count != 2) {
+			locked[ends.first] = true;
+			locked[ends.second] = true;
+		}
+	}
+
+	std::vector<Quadric> quadrics(position_count);
+	for (int t = 0; t < result.size() / 3; t++) {
+		int p[3];
+		for (int k = 0; k < 3; k++) {
+			p[k] = position[result[t * 3 + k]];
+		}
+		Vector3f normal = (points[p[1]] - points[p[0]])
+					  .cross(points[p[2]] - points[p[0]]);
+		if (normal.length() == 0)
+			continue;
+		normal = normal.normalize();
+		double d = -normal.dot(points[p[0]]);
+		for (int k = 0; k < 3; k++) {
+			quadrics[p[k]].add_plane(normal.getX(), normal.getY(),
+						 normal.getZ(), d);
+		}
+
+		// A plane through each seam edge, upright on the triangle,
+		// keeps the seam's outline when its vertices slide along it
+		for (int k = 0; k < 3; k++) {
+			int a = p[k], b = p[(k + 1) % 3];
+			if (!edges.at({ std::min(a, b), std::max(a, b) }).seam)
+				continue;
+			Vector3f side = (points[b] - points[a]).cross(normal);
+			if (side.length() == 0)
+				continue;
+			side = side.normalize();
+			double w = -side.dot(points[a]);
+			quadrics[a].add_plane(side.getX(), side.getY(),
+					      side.getZ(), w);
+			quadrics[b].add_plane(side.getX(), side.getY(),
+					      side.getZ(), w);
+		}
+	}
+
+	float radius = 0.0f;
+	for (const Vector3f &point : points) {
+		radius = std::max(radius, point.length());
+	}
+	double max_cost = std::pow(target_error * radius, 2);
+	double worst_cost = 0.0;
+
+	struct Collapse {
+		int from;
+		int to;
+		double cost;
+	};
+
+	while (result.size() > target_index_count) {
+		int triangle_count = result.size() / 3;
+
+		std::vector<std::vector<int> > position_triangles(
+			position_count);
+		std::vector<Collapse> collapses;
+		for (int t = 0; t < triangle_count; t++) {
+			for (int k = 0; k < 3; k++) {
+				int a = position[result[t * 3 + k]];
+				int b = position[result[t * 3 + (k + 1) % 3]];
+				position_triangles[a].push_back(t);
+				for (auto [from, to] : { std::pair{ a, b },
+							 std::pair{ b, a } }) {
+					if (locked[from])
+						continue;
+					Quadric q = quadrics[from] +
+						    quadrics[to];
+					collapses.push_back(
+						{ from, to,
+						  q.evaluate(points[to]) });
+				}
+			}
+		}
+		std::sort(collapses.begin(), collapses.end(),
+			  [](const Collapse &a, const Collapse &b) {
+				  return a.cost < b.cost;
+			  });
+
+		// Each collapse removes about two triangles
+		int budget = (triangle_count - target_index_count / 3) / 2 + 1;
+		std::vector<int> remap(vertex_count);
+		std::iota(remap.begin(), remap.end(), 0);
+		std::vector<bool> touched(position_count, false);
+		int collapsed = 0;
+
+		for (const Collapse &c : collapses) {
+			if (c.cost > max_cost || collapsed >= budget)
+				break;
+			if (touched[c.from] || touched[c.to])
+				continue;
+
+			// Each wedge folds into the vertex it shares an edge
+			// with, one missing means the edge crosses a seam
+			std::map<int, int> targets;
+			for (int t : position_triangles[c.from]) {
+				const int *tri = &result[t * 3];
+				int from = -1, to = -1;
+				for (int k = 0; k < 3; k++) {
+					if (position[tri[k]] == c.from) {
+						from = tri[k];
+					} else if (position[tri[k]] == c.to) {
+						to = tri[k];
+					}
+				}
+				if (to >= 0) {
+					targets.try_emplace(wedge[from], to);
+				}
+			}
+
+			// Reject collapses that strand a wedge or flip a
+			// remaining triangle
+			bool valid = true;
+			for (int t : position_triangles[c.from]) {
+				const int *tri = &result[t * 3];
+				Vector3f before[3], after[3];
+				bool shared = false;
+				for (int k = 0; k < 3; k++) {
+					int p = position[tri[k]];
+					if (p == c.from &&
+					    !targets.count(wedge[tri[k]])) {
+						valid = false;
+					}
+					shared |= p == c.to;
+					before[k] = points[p];
+					after[k] = p == c.from ? points[c.to] :
+								 before[k];
+				}
+				if (!valid)
+					break;
+				if (shared)
+					continue;
+				Vector3f n0 = (before[1] - before[0])
+						      .cross(before[2] - before[0]);
+				Vector3f n1 = (after[1] - after[0])
+						      .cross(after[2] - after[0]);
+				if (n0.dot(n1) <= 0) {
+					valid = false;
+					break;
+				}
+			}
+			if (!valid)
+				continue;
+
+			for (int t : position_triangles[c.from]) {
+				for (int k = 0; k < 3; k++) {
+					int v = result[t * 3 + k];
+					if (position[v] == c.from) {
+						remap[v] = targets[wedge[v]];
+					}
+					touched[position[v]] = true;
+				}
+			}
+			quadrics[c.to] = quadrics[c.to] + quadrics[c.from];
+			worst_cost = std::max(worst_cost, c.cost);
+			collapsed++;
+		}
+
+		if (collapsed == 0)
+			break;
+
+		// Corners now sharing a position are degenerate, even when
+		// they are different vertices
+		std::vector<int> next;
+		next.reserve(result.size());
+		for (int t = 0; t < triangle_count; t++) {
+			int a = remap[result[t * 3]];
+			int b = remap[result[t * 3 + 1]];
+			int c = remap[result[t * 3 + 2]];
+			if (position[a] != position[b] &&
+			    position[b] != position[c] &&
+			    position[a] != position[c]) {
+				next.insert(next.end(), { a, b, c });
+			}
+		}
+		result.swap(next);
+	}
+
+	if (result_error != nullptr && radius > 0) {
+		*result_error = std::sqrt(worst_cost) / radius;
+	}
+	return result;
+}
+
+std::vector<std::vector<int> >
+MeshOptimizer::generate_lods(const std::vector<int> &indices,
+			     const std::vector<Vertex> &vertices, int max_lods)
+{
+	// Too small to be worth the extra index data
+	const int MIN_TRIANGLES = 64;
+
+	std::vector<std::vector<int> > lods;
+	const std::vector<int> *previous = &indices;
+
+	for (int level = 1; level <= max_lods; level++) {
+		if (previous->size() / 3 < MIN_TRIANGLES)
+			break;
+
+		int target = previous->size() / 6 * 3;
+		std::vector<int> lod = simplify(*previous, vertices, target,
+						0.02f * level);
+		if (lod.size() > previous->size() * 4 / 5)
+			break;
+
+		optimize_vertex_cache(lod, vertices.size());
+		lods.push_back(std::move(lod));
+		previous = &lods.back();
+	}
+
+	return lods;
+}
+
+float MeshOptimizer::compute_acmr(const std::vector<int> &indices,
+				  int vertex_count, int cache_size)
+{
+	int triangle_count = indices.size() / 3;
+	if (triangle_count == 0)
+		return 0.0f;
+
+	std::vector<int> cache_time(vertex_count, 0);
+	int timestamp = cache_size + 1;
+	int misses = 0;
+	for (int index : indices) {
+		if (timestamp - cache_time[index] > cache_size) {
+			cache_time[index] = timestamp++;
+			misses++;
+		}
+	}
+
+	return static_cast<float>(misses) / triangle_count;
+}
@@ -0,0 +1,183 @@
+#include <graphics/RenderQueue.h>
+
+#include <misc/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <math/Matrix4f.h>
+#include <math/Transform.h>
+
+#include <graphics/Mesh.h>
+#include <graphics/Shader.h>
+#include <graphics/Material.h>
+#include <graphics/MaterialTable.h>
+#include <graphics/IndirectRenderer.h>
+#include <graphics/SkinningPass.h>
+
+#include <vector>
+#include <cstring>
+
+RenderQueue &RenderQueue::get_instance()
+{
+	static RenderQueue instance;
+	return instance;
+}
+
+RenderQueue::RenderQueue()
+	: instance_vbo(0)
+	, uploaded(false)
+{
+}
+
+RenderQueue::~RenderQueue()
+{
+	if (instance_vbo) {
+		glDeleteBuffers(1, &instance_vbo);
+		instance_vbo = 0;
+	}
+}
+
+void RenderQueue::submit(const Mesh &mesh, const Material &material,
+			 Transform *transform)
+{
+	packets.push_back({ &mesh, material.get_index(),
+			    Matrix4f::flip_matrix(
+				    transform->get_transformation()) });
+	uploaded = false;
+}
+
+void RenderQueue::build_groups()
+{
+	// Bucket packets by (MeshResource, LOD, material), preserving
+	// submission order inside each bucket so every group is contiguous
+	// once sorted
+	std::vector<std::vector<int> > buckets;
+	groups.clear();
+	const MaterialTable &materials = MaterialTable::get_instance();
+
+	for (int i = 0; i < packets.size(); i++) {
+		const DrawPacket &packet = packets[i];
+		int bucket = -1;
+		for (int j = 0; j < groups.size(); j++) {
+			if (groups[j].mesh->get_resource() ==
+				    packet.mesh->get_resource() &&
+			    groups[j].mesh->get_lod() == packet.mesh->get_lod() &&
+			    (groups[j].material == packet.material ||
+			     materials.get(groups[j].material) ==
+				     materials.get(packet.material))) {
+				bucket = j;
+				break;
+			}
+		}
+		if (bucket == -1) {
+			bucket = groups.size();
+			groups.push_back({ packet.mesh, packet.material, 0, 0 });
+			buckets.emplace_back();
+		}
+		buckets[bucket].push_back(i);
+	}
+
+	std::vector<DrawPacket> sorted;
+	sorted.reserve(packets.size());
+	for (int j = 0; j < groups.size(); j++) {
+		groups[j].first = sorted.size();
+		groups[j].count = buckets[j].size();
+		for (int i : buckets[j]) {
+			sorted.push_back(packets[i]);
+		}
+	}
+	packets.swap(sorted);
+
+	instance_data.resize(packets.size() * 16);
+	for (int i = 0; i < packets.size(); i++) {
+		std::memcpy(&instance_data[i * 16],
+			    packets[i].model.get_matrix(), 16 * sizeof(float));
+	}
+
+	if (instance_vbo == 0) {
+		glGenBuffers(1, &instance_vbo);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+	glBufferData(GL_ARRAY_BUFFER, instance_data.size() * sizeof(float),
+		     instance_data.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	IndirectRenderer &indirect_renderer = IndirectRenderer::get_instance();
+	if (indirect_renderer.is_enabled()) {
+		indirect_renderer.build(packets, groups);
+	}
+
+	uploaded = true;
+}
+
+void RenderQueue::skin()
+{
+	if (!packets.empty() && !uploaded) {
+		build_groups();
+	}
+
+	SkinningPass &skinning = SkinningPass::get_instance();
+	const MaterialTable &materials = MaterialTable::get_instance();
+	skinning.begin_frame();
+	for (const DrawGroup &group : groups) {
+		const MaterialData &material = materials.get(group.material);
+		if (material.flags & MaterialData::SKINNED) {
+			skinning.add(*group.mesh, material);
+		}
+	}
+	skinning.execute();
+}
+
+void RenderQueue::flush(Shader &shader)
+{
+	if (packets.empty())
+		return;
+
+	if (!uploaded) {
+		build_groups();
+	}
+
+	// Groups living in the shared geometry pool go out as one
+	// multi-draw, everything else keeps the per-group instanced path
+	IndirectRenderer &indirect_renderer = IndirectRenderer::get_instance();
+	bool indirect = indirect_renderer.is_enabled() && shader.has_indirect();
+	if (indirect) {
+		indirect_renderer.draw(shader);
+	}
+
+	const MaterialTable &materials = MaterialTable::get_instance();
+	const SkinningPass &skinning = SkinningPass::get_instance();
+	shader.use_program();
+	for (const DrawGroup &group : groups) {
+		if (indirect && IndirectRenderer::is_pooled(group))
+			continue;
+		const MaterialData &material = materials.get(group.material);
+		shader.update_uniforms(material);
+
+		// Skinned meshes are drawn from this frame's skinned output
+		GLuint vao = 0;
+		if (material.skeleton) {
+			vao = skinning.get_vertex_array(*group.mesh,
+							material.skeleton);
+		}
+		group.mesh->draw_instanced(instance_vbo,
+					   group.first * 16 * sizeof(float),
+					   group.count, vao);
+	}
+}
+
+void RenderQueue::clear() noexcept
+{
+	packets.clear();
+	groups.clear();
+	uploaded = false;
+}
+
+int RenderQueue::get_group_count() const noexcept
+{
+	return groups.size();
+}
+
+int RenderQueue::get_packet_count() const noexcept
+{
+	return packets.size();
+}
@@ -8,16 +8,23 @@
 #include <core/Window.h>
 
 #include <graphics/ForwardAmbient.h>
-#include <graphics/ForwardDirectional.h>
-#include <graphics/ForwardPoint.h>
-#include <graphics/ForwardSpot.h>
+#include <graphics/ForwardMultiLight.h>
+#include <graphics/RenderQueue.h>
+#include <graphics/GLState.h>
+#include <graphics/LightStorage.h>
+#include <graphics/LightBounds.h>
+#include <graphics/DynamicResolution.h>
 
 #include <components/BaseCamera.h>
-#include <components/BaseLight.h>
+#include <components/Camera.h>
 #include <components/GameObject.h>
 #include <components/SharedGlobals.h>
+#include <components/Skybox.h>
 
 #include <cmath>
+#include <string>
+#include <utility>
+#include <functional>
 
 void RenderingEngine::clear_screen()
 {
@@ -28,14 +35,17 @@ RenderingEngine::RenderingEngine()
 {
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
+	GLState &state = GLState::get_instance();
+
 	glFrontFace(GL_CW);
-	glCullFace(GL_BACK);
-	glEnable(GL_CULL_FACE);
-	glEnable(GL_DEPTH_TEST);
-	glDepthFunc(GL_LESS);
+	state.cull_face(GL_BACK);
+	state.set_capability(GL_CULL_FACE, true);
+	state.set_capability(GL_DEPTH_TEST, true);
+	state.depth_func(GL_LESS);
 
-	glEnable(GL_DEPTH_CLAMP);
+	state.set_capability(GL_DEPTH_CLAMP, true);
 	glEnable(GL_TEXTURE_2D);
+	glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
 
 	RenderingEngine::clear_screen();
 }
@@ -55,7 +65,7 @@ void RenderingEngine::set_clear_color(const Vector3f &color)
 
 void RenderingEngine::unbind_textures()
 {
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLState::get_instance().bind_texture(GL_TEXTURE_2D, 0);
 }
 
 RenderingEngine &RenderingEngine::get_instance()
@@ -70,23 +80,160 @@ void RenderingEngine::input()
 
 void RenderingEngine::render(GameObject *object)
 {
-	clear_screen();
+	GLState &state = GLState::get_instance();
+	state.begin_frame();
+
+	Window &window = Window::get_instance();
+	int width = window.get_framebuffer_width();
+	int height = window.get_framebuffer_height();
+	DynamicResolution &dynamic_resolution =
+		DynamicResolution::get_instance();
+	dynamic_resolution.begin_frame(width, height);
 
-	SharedGlobals &light_sources = SharedGlobals::get_instance();
+	SharedGlobals &globals = SharedGlobals::get_instance();
+	RenderQueue &render_queue = RenderQueue::get_instance();
 
+	// Collect draw packets once, then replay the batches for every pass
+	render_queue.clear();
 	object->render(ForwardAmbient::get_instance());
+	render_queue.skin();
+
+	frame_graph.reset();
+	FrameGraph::Handle backbuffer =
+		frame_graph.import_target("backbuffer", 0, width, height);
+
+	// Scene passes draw into scaled offscreen targets when dynamic
+	// resolution is on, straight into the window otherwise
+	bool offscreen = dynamic_resolution.is_enabled();
+	FrameGraph::Handle color = backbuffer;
+	FrameGraph::Handle depth = backbuffer;
+	if (offscreen) {
+		int storage_width = dynamic_resolution.get_storage_width();
+		int storage_height = dynamic_resolution.get_storage_height();
+		color = frame_graph.create_texture(
+			"scene_color",
+			{ GL_RGBA8, storage_width, storage_height });
+		depth = frame_graph.create_texture(
+			"scene_depth",
+			{ GL_DEPTH24_STENCIL8, storage_width, storage_height });
+	}
 
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_ONE, GL_ONE);
-	glDepthMask(GL_FALSE);
-	glDepthFunc(GL_EQUAL);
+	auto scene_pass = [&](const std::string &name,
+			      std::function<void()> execute) {
+		FrameGraph::PassBuilder pass =
+			frame_graph.add_pass(name, std::move(execute));
+		pass.write(color);
+		if (offscreen) {
+			pass.write(depth).viewport(
+				dynamic_resolution.get_render_width(),
+				dynamic_resolution.get_render_height());
+		}
+		return pass;
+	};
+
+	scene_pass("ambient", [&]() {
+		ForwardAmbient &shader = ForwardAmbient::get_instance();
+		shader.begin_pass();
+		render_queue.flush(shader);
+	}).clear();
+
+	// World space light data is computed once and shared by every pass
+	LightStorage &lights = LightStorage::get_instance();
+	lights.update();
+
+	scene_pass("lights", [&]() {
+		state.set_capability(GL_BLEND, true);
+		state.blend_func(GL_ONE, GL_ONE);
+		state.depth_mask(GL_FALSE);
+		state.depth_func(GL_EQUAL);
+
+		// Pixels outside the group's projected light volumes, or whose
+		// depth lies outside them, are never shaded
+		Camera *camera = static_cast<Camera *>(globals.main_camera);
+		Matrix4f view_projection = camera->get_view_projection();
+		int viewport_width =
+			offscreen ? dynamic_resolution.get_render_width() :
+				    width;
+		int viewport_height =
+			offscreen ? dynamic_resolution.get_render_height() :
+				    height;
+		bool depth_bounds = GLAD_GL_EXT_depth_bounds_test;
+
+		// Every pass shades a group of lights of each type at once
+		ForwardMultiLight &shader = ForwardMultiLight::get_instance();
+		int passes = ForwardMultiLight::get_pass_count(lights);
+		for (int i = 0; i < passes; i++) {
+			LightBounds::Rect bounds = LightBounds::group_bounds(
+				lights, i * ForwardMultiLight::LIGHTS_PER_PASS,
+				ForwardMultiLight::LIGHTS_PER_PASS,
+				view_projection, viewport_width,
+				viewport_height);
+			if (bounds.empty)
+				continue;
+
+			state.set_capability(GL_SCISSOR_TEST, !bounds.full);
+			if (depth_bounds) {
+				state.set_capability(GL_DEPTH_BOUNDS_TEST_EXT,
+						     !bounds.full);
+			}
+			if (!bounds.full) {
+				state.scissor(bounds.x, bounds.y, bounds.width,
+					      bounds.height);
+				if (depth_bounds) {
+					state.depth_bounds(bounds.min_depth,
+							   bounds.max_depth);
+				}
+			}
+
+			lights.set_active(i);
+			shader.begin_pass();
+			render_queue.flush(shader);
+		}
+		state.set_capability(GL_SCISSOR_TEST, false);
+		if (depth_bounds) {
+			state.set_capability(GL_DEPTH_BOUNDS_TEST_EXT, false);
+		}
+
+		state.depth_func(GL_LESS);
+		state.depth_mask(GL_TRUE);
+		state.set_capability(GL_BLEND, false);
+	});
+
+	// Sky last, on the far plane, so it only shades uncovered pixels
+	if (globals.skybox) {
+		scene_pass("sky", [&]() {
+			state.depth_func(GL_LEQUAL);
+			state.depth_mask(GL_FALSE);
+			state.set_capability(GL_CULL_FACE, false);
+			Skybox *skybox = static_cast<Skybox *>(globals.skybox);
+			skybox->render_sky();
+			state.set_capability(GL_CULL_FACE, true);
+			state.depth_mask(GL_TRUE);
+			state.depth_func(GL_LESS);
+		});
+	}
 
-	for (void *light : light_sources.get_lights()) {
-		light_sources.active_light = light;
-		object->render(*(static_cast<BaseLight *>(light)->shader));
+	if (offscreen) {
+		// Blits honour the scissor test, the scene passes must leave
+		// it disabled
+		auto upscale = [&]() {
+			int render_width = dynamic_resolution.get_render_width();
+			int render_height =
+				dynamic_resolution.get_render_height();
+			glBindFramebuffer(GL_READ_FRAMEBUFFER,
+					  frame_graph.get_framebuffer(color));
+			glBlitFramebuffer(0, 0, render_width, render_height, 0,
+					  0, width, height, GL_COLOR_BUFFER_BIT,
+					  GL_LINEAR);
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+		};
+		frame_graph.add_pass("upscale", upscale)
+			.read(color)
+			.write(backbuffer);
 	}
 
-	glDepthFunc(GL_LESS);
-	glDepthMask(GL_TRUE);
-	glDisable(GL_BLEND);
-}
\ No newline at end of file
+	frame_graph.compile();
+	frame_graph.execute();
+
+	dynamic_resolution.end_frame();
+}
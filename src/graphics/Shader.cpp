@@ -1,4 +1,5 @@
 #include <graphics/Shader.h>
+#include <graphics/GLState.h>
 
 #include <misc/glad.h>
 #include <GLFW/glfw3.h>
@@ -11,12 +12,13 @@
 
 #include <graphics/Material.h>
 #include <graphics/Specular.h>
+#include <graphics/ShaderBinaryCache.h>
+#include <graphics/ShaderPreprocessor.h>
 #include <graphics/resource_management/ShaderResource.h>
 
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <array>
+#include <vector>
 #include <cstddef>
 #include <string>
 #include <memory>
@@ -24,32 +26,16 @@
 #include <exception>
 
 // #define _DEBUG_DISPLAY_ALL_UNIFORMS_ON
-std::unordered_map<std::pair<std::string, std::string>,
-		   std::weak_ptr<ShaderResource>, Shader::__pair_hash>
+std::unordered_map<Shader::VariantKey, std::weak_ptr<ShaderResource>,
+		   Shader::__variant_hash>
 	Shader::shader_cache{};
 
-std::string Shader::read_shader(const std::string &filepath) const
+std::size_t
+Shader::__variant_hash::operator()(const VariantKey &key) const noexcept
 {
-	std::ifstream file;
-	std::stringstream bufferedLines;
-	std::string line;
-
-	file.open(filepath);
-	if (!file.good()) {
-		std::cerr << "File Does not exist: " << filepath << '\n';
-		throw std::runtime_error("File Does not exist");
-		throw std::runtime_error("File Does not exist");
-	}
-
-	while (std::getline(file, line)) {
-		bufferedLines << line << '\n';
-	}
-
-	file.close();
-
-	std::string source = bufferedLines.str();
-
-	return source;
+	std::size_t hash = std::hash<std::string>{}(key.vertex_filepath);
+	hash ^= std::hash<std::string>{}(key.fragment_filepath) << 1;
+	return hash ^ (ShaderPreprocessor::hash(key.defines) << 2);
 }
 
 GLuint Shader::create_shader_module(const std::string &shader_source,
@@ -74,34 +60,71 @@ GLuint Shader::create_shader_module(const std::string &shader_source,
 	return shader_module;
 }
 
-void Shader::load(const std::string &vertex_filepath,
-		  const std::string &fragment_filepath)
-{
-	if (shader_cache.count({ vertex_filepath, fragment_filepath })) {
-		std::shared_ptr<ShaderResource> resource =
-			shader_cache.at({ vertex_filepath, fragment_filepath })
-				.lock();
-		if (resource) {
-			this->shader_resource = resource;
+void Shader::load_program(const std::string &vertex_filepath,
+			  const std::string &fragment_filepath,
+			  std::shared_ptr<ShaderResource> &resource,
+			  const ShaderPreprocessor::Defines &defines)
+{
+	// Every (sources, defines) variant is compiled once and shared
+	VariantKey key{ vertex_filepath, fragment_filepath, defines,
+			feedback_varyings };
+	if (shader_cache.count(key)) {
+		std::shared_ptr<ShaderResource> cached =
+			shader_cache.at(key).lock();
+		if (cached) {
+			resource = cached;
 			return;
 		}
 	}
-	if (this->shader_resource == nullptr) {
-		shader_resource = std::make_shared<ShaderResource>();
-		shader_cache[{ vertex_filepath, fragment_filepath }] =
-			shader_resource;
+	if (resource == nullptr) {
+		resource = std::make_shared<ShaderResource>();
+		shader_cache[key] = resource;
 	}
 
-	std::array<GLuint, 2> modules;
-	modules[0] = create_shader_module(read_shader(vertex_filepath),
-					  GL_VERTEX_SHADER);
-	modules[1] = create_shader_module(read_shader(fragment_filepath),
-					  GL_FRAGMENT_SHADER);
+	std::string vertex_source =
+		ShaderPreprocessor::process(vertex_filepath, defines);
+	std::string fragment_source;
+	if (!fragment_filepath.empty()) {
+		fragment_source =
+			ShaderPreprocessor::process(fragment_filepath, defines);
+	}
+	std::string sources = vertex_source + '\0' + fragment_source;
+	for (const std::string &varying : feedback_varyings) {
+		sources += '\0' + varying;
+	}
 
-	GLuint shader = glCreateProgram();
+	// Skip compiling and linking when a previous run left a binary
+	ShaderBinaryCache &binary_cache = ShaderBinaryCache::get_instance();
+	GLuint shader = binary_cache.load(sources);
+	if (shader) {
+		resource->shader_program = shader;
+		return;
+	}
+
+	std::vector<GLuint> modules;
+	modules.push_back(
+		create_shader_module(vertex_source, GL_VERTEX_SHADER));
+	if (!fragment_filepath.empty()) {
+		modules.push_back(create_shader_module(fragment_source,
+						       GL_FRAGMENT_SHADER));
+	}
+
+	shader = glCreateProgram();
 	for (auto &module : modules) {
 		glAttachShader(shader, module);
 	}
+	if (!feedback_varyings.empty()) {
+		std::vector<const GLchar *> names;
+		for (const std::string &varying : feedback_varyings) {
+			names.push_back(varying.c_str());
+		}
+		glTransformFeedbackVaryings(shader, names.size(), names.data(),
+					    GL_INTERLEAVED_ATTRIBS);
+	}
+	if (binary_cache.is_supported()) {
+		glProgramParameteri(shader, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+				    GL_TRUE);
+	}
 	glLinkProgram(shader);
 
 	GLint success;
@@ -120,10 +143,47 @@ void Shader::load(const std::string &vertex_filepath,
 		glDeleteShader(module);
 	}
 
-	shader_resource->shader_program = shader;
+	binary_cache.store(sources, shader);
+
+	resource->shader_program = shader;
 }
 
-Shader::Shader() {};
+void Shader::load(const std::string &vertex_filepath,
+		  const std::string &fragment_filepath,
+		  const ShaderPreprocessor::Defines &defines)
+{
+	load_program(vertex_filepath, fragment_filepath, shader_resource,
+		     defines);
+}
+
+void Shader::load_indirect(const std::string &vertex_filepath,
+			   const std::string &fragment_filepath,
+			   ShaderPreprocessor::Defines defines)
+{
+	defines["INDIRECT"] = "";
+	load_program(vertex_filepath, fragment_filepath, indirect_resource,
+		     defines);
+}
+
+void Shader::set_feedback_varyings(std::vector<std::string> varyings)
+{
+	feedback_varyings = std::move(varyings);
+}
+
+Shader::Shader()
+	: indirect(false) {};
+
+ShaderResource *Shader::active_resource() const noexcept
+{
+	if (indirect)
+		return indirect_resource.get();
+	return shader_resource.get();
+}
+
+GLint Shader::active_location(const Uniform &uniform) const noexcept
+{
+	return indirect ? uniform.indirect : uniform.direct;
+}
 
 GLuint Shader::get_program() const noexcept
 {
@@ -134,7 +194,23 @@ GLuint Shader::get_program() const noexcept
 
 void Shader::use_program() const noexcept
 {
-	glUseProgram(shader_resource->shader_program);
+	GLState::get_instance().use_program(
+		active_resource()->shader_program);
+}
+
+bool Shader::has_indirect() const noexcept
+{
+	return indirect_resource != nullptr;
+}
+
+void Shader::set_indirect(bool enable) noexcept
+{
+	indirect = enable && has_indirect();
+}
+
+bool Shader::is_indirect() const noexcept
+{
+	return indirect;
 }
 
 void Shader::add_uniform(const std::string &uniform)
@@ -169,67 +245,92 @@ void Shader::add_uniform(const std::string &uniform)
 	}
 
 	shader_resource->uniforms[uniform] = uniform_location;
+
+	// Uniforms fed from buffers on the indirect path are absent from that
+	// program; GL silently ignores writes to location -1
+	if (indirect_resource != nullptr) {
+		indirect_resource->uniforms[uniform] =
+			glGetUniformLocation(indirect_resource->shader_program,
+					     uniform.c_str());
+	}
 }
 
 GLuint Shader::get_uniform(const std::string &uniform) const
 {
 	use_program();
-	if (!shader_resource->uniforms.count(uniform)) {
+	if (!active_resource()->uniforms.count(uniform)) {
 		std::cerr << "Error: Uniform Does not exist: \"" << uniform
 			  << "\"\n";
 		throw std::runtime_error("Uniform Does not exist");
 		throw std::runtime_error("Uniform Does not exist");
 	}
-	return shader_resource->uniforms.at(uniform);
+	return active_resource()->uniforms.at(uniform);
+}
+
+Shader::Uniform Shader::find_uniform(const std::string &uniform) const
+{
+	if (!shader_resource->uniforms.count(uniform)) {
+		std::cerr << "Error: Uniform Does not exist: \"" << uniform
+			  << "\"\n";
+		throw std::runtime_error("Uniform Does not exist");
+	}
+
+	Uniform result{ static_cast<GLint>(
+				shader_resource->uniforms.at(uniform)),
+			-1 };
+	if (indirect_resource != nullptr) {
+		result.indirect = indirect_resource->uniforms.at(uniform);
+	}
+	return result;
 }
 
 void Shader::set_uniform(const std::string &uniform, int value)
 {
 	use_program();
-	if (!shader_resource->uniforms.count(uniform)) {
+	if (!active_resource()->uniforms.count(uniform)) {
 		std::cerr << "Error: Uniform Does not exist: \"" << uniform
 			  << "\"\n";
 		throw std::runtime_error("Uniform Does not exist");
 		throw std::runtime_error("Uniform Does not exist");
 	}
-	glUniform1i(shader_resource->uniforms[uniform], value);
+	glUniform1i(active_resource()->uniforms[uniform], value);
 }
 
 void Shader::set_uniform(const std::string &uniform, float value)
 {
 	use_program();
-	if (!shader_resource->uniforms.count(uniform)) {
+	if (!active_resource()->uniforms.count(uniform)) {
 		std::cerr << "Error: Uniform Does not exist: \"" << uniform
 			  << "\"\n";
 		throw std::runtime_error("Uniform Does not exist");
 		throw std::runtime_error("Uniform Does not exist");
 	}
-	glUniform1f(shader_resource->uniforms[uniform], value);
+	glUniform1f(active_resource()->uniforms[uniform], value);
 }
 
 void Shader::set_uniform(const std::string &uniform, Vector3f vec)
 {
 	use_program();
-	if (!shader_resource->uniforms.count(uniform)) {
+	if (!active_resource()->uniforms.count(uniform)) {
 		std::cerr << "Error: Uniform Does not exist: \"" << uniform
 			  << "\"\n";
 		throw std::runtime_error("Uniform Does not exist");
 		throw std::runtime_error("Uniform Does not exist");
 	}
-	glUniform3f(shader_resource->uniforms[uniform], vec.getX(), vec.getY(),
+	glUniform3f(active_resource()->uniforms[uniform], vec.getX(), vec.getY(),
 		    vec.getZ());
 }
 
 void Shader::set_uniform(const std::string &uniform, Matrix4f matrix)
 {
 	use_program();
-	if (!shader_resource->uniforms.count(uniform)) {
+	if (!active_resource()->uniforms.count(uniform)) {
 		std::cerr << "Error: Uniform Does not exist: \"" << uniform
 			  << "\"\n";
 		throw std::runtime_error("Uniform Does not exist");
 		throw std::runtime_error("Uniform Does not exist");
 	}
-	glUniformMatrix4fv(shader_resource->uniforms[uniform], 1, GL_FALSE,
+	glUniformMatrix4fv(active_resource()->uniforms[uniform], 1, GL_FALSE,
 			   matrix.get_matrix());
 }
 
@@ -244,12 +345,39 @@ void Shader::set_uniform(const std::string &uniform, const Matrix4f &matrix,
 {
 	use_program(); // Make sure the shader program is active
 
-	if (!shader_resource->uniforms.count(uniform)) {
+	if (!active_resource()->uniforms.count(uniform)) {
 		std::cerr << "Error: Uniform Does not exist: \"" << uniform
 			  << "\"\n";
 		throw std::runtime_error("Uniform Does not exist");
 	}
 
-	glUniformMatrix4fv(shader_resource->uniforms[uniform], count, GL_FALSE,
+	glUniformMatrix4fv(active_resource()->uniforms[uniform], count, GL_FALSE,
 			   &matrix.get_matrix()[0]);
-}
\ No newline at end of file
+}
+
+void Shader::set_uniform(const Uniform &uniform, int value) noexcept
+{
+	use_program();
+	glUniform1i(active_location(uniform), value);
+}
+
+void Shader::set_uniform(const Uniform &uniform, float value) noexcept
+{
+	use_program();
+	glUniform1f(active_location(uniform), value);
+}
+
+void Shader::set_uniform(const Uniform &uniform, const Vector3f &vec) noexcept
+{
+	use_program();
+	glUniform3f(active_location(uniform), vec.getX(), vec.getY(),
+		    vec.getZ());
+}
+
+void Shader::set_uniform(const Uniform &uniform,
+			 const Matrix4f &matrix) noexcept
+{
+	use_program();
+	glUniformMatrix4fv(active_location(uniform), 1, GL_FALSE,
+			   matrix.get_matrix());
+}
@@ -0,0 +1,153 @@
+#include <graphics/ShaderBinaryCache.h>
+
+#include <misc/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+
+static const char MAGIC[4] = { 'G', 'E', 'P', 'B' };
+
+ShaderBinaryCache &ShaderBinaryCache::get_instance()
+{
+	static ShaderBinaryCache instance;
+	return instance;
+}
+
+ShaderBinaryCache::ShaderBinaryCache()
+	: directory("shader_cache")
+	, supported(false)
+{
+	bool version_4_1 = GLVersion.major > 4 ||
+			   (GLVersion.major == 4 && GLVersion.minor >= 1);
+	if (version_4_1 || GLAD_GL_ARB_get_program_binary) {
+		GLint formats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		supported = formats > 0;
+	}
+
+	// Binaries are only valid for the exact driver that produced them
+	for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION,
+			     GL_SHADING_LANGUAGE_VERSION }) {
+		const GLubyte *value = glGetString(name);
+		if (value != nullptr) {
+			driver += reinterpret_cast<const char *>(value);
+		}
+		driver += '\n';
+	}
+}
+
+bool ShaderBinaryCache::is_supported() const noexcept
+{
+	return supported;
+}
+
+void ShaderBinaryCache::set_directory(const std::string &directory)
+{
+	this->directory = directory;
+}
+
+// FNV-1a, stable across runs unlike std::hash
+std::uint64_t ShaderBinaryCache::hash(const std::string &data) noexcept
+{
+	std::uint64_t result = 14695981039346656037ull;
+	for (unsigned char c : data) {
+		result ^= c;
+		result *= 1099511628211ull;
+	}
+	return result;
+}
+
+std::string ShaderBinaryCache::get_path(const std::string &sources) const
+{
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llx.bin",
+		      static_cast<unsigned long long>(hash(sources + driver)));
+	return (std::filesystem::path(directory) / name).string();
+}
+
+GLuint ShaderBinaryCache::load(const std::string &sources)
+{
+	if (!supported)
+		return 0;
+
+	std::ifstream file(get_path(sources), std::ios::binary);
+	if (!file.good())
+		return 0;
+
+	char magic[4];
+	std::uint32_t driver_size = 0;
+	file.read(magic, sizeof(magic));
+	file.read(reinterpret_cast<char *>(&driver_size), sizeof(driver_size));
+	if (!file || std::string(magic, sizeof(magic)) !=
+			     std::string(MAGIC, sizeof(MAGIC)))
+		return 0;
+
+	std::string cached_driver(driver_size, '\0');
+	file.read(cached_driver.data(), driver_size);
+	if (!file || cached_driver != driver)
+		return 0;
+
+	GLenum format = 0;
+	std::uint32_t size = 0;
+	file.read(reinterpret_cast<char *>(&format), sizeof(format));
+	file.read(reinterpret_cast<char *>(&size), sizeof(size));
+	std::vector<char> binary(size);
+	file.read(binary.data(), size);
+	if (!file)
+		return 0;
+
+	GLuint program = glCreateProgram();
+	glProgramBinary(program, format, binary.data(), size);
+
+	GLint success = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success) {
+		glDeleteProgram(program);
+		return 0;
+	}
+	return program;
+}
+
+void ShaderBinaryCache::store(const std::string &sources, GLuint program)
+{
+	if (!supported)
+		return;
+
+	GLint size = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+	if (size <= 0)
+		return;
+
+	std::vector<char> binary(size);
+	GLenum format = 0;
+	glGetProgramBinary(program, size, nullptr, &format, binary.data());
+
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+	if (error) {
+		std::cerr << "Warning: Cannot create shader cache directory "
+			  << directory << ": " << error.message() << '\n';
+		return;
+	}
+
+	std::ofstream file(get_path(sources), std::ios::binary);
+	std::uint32_t driver_size = driver.size();
+	std::uint32_t binary_size = size;
+	file.write(MAGIC, sizeof(MAGIC));
+	file.write(reinterpret_cast<const char *>(&driver_size),
+		   sizeof(driver_size));
+	file.write(driver.data(), driver_size);
+	file.write(reinterpret_cast<const char *>(&format), sizeof(format));
+	file.write(reinterpret_cast<const char *>(&binary_size),
+		   sizeof(binary_size));
+	file.write(binary.data(), binary_size);
+	if (!file) {
+		std::cerr << "Warning: Failed to write shader cache entry\n";
+	}
+}
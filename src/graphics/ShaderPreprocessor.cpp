@@ -0,0 +1,107 @@
+#include <graphics/ShaderPreprocessor.h>
+
+#include <set>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+#include <filesystem>
+#include <functional>
+
+std::string ShaderPreprocessor::process(const std::string &filepath,
+					const Defines &defines)
+{
+	std::string define_block;
+	for (const auto &[name, value] : defines) {
+		define_block += "#define " + name;
+		if (!value.empty()) {
+			define_block += ' ' + value;
+		}
+		define_block += '\n';
+	}
+
+	std::set<std::string> included;
+	std::string output;
+	expand(filepath, included, define_block, true, output);
+
+	return output;
+}
+
+std::size_t ShaderPreprocessor::hash(const Defines &defines) noexcept
+{
+	std::size_t seed = defines.size();
+	std::hash<std::string> hasher;
+	for (const auto &[name, value] : defines) {
+		seed ^= hasher(name) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+		seed ^= hasher(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+	}
+	return seed;
+}
+
+void ShaderPreprocessor::expand(const std::string &filepath,
+				std::set<std::string> &included,
+				const std::string &define_block, bool root,
+				std::string &output)
+{
+	std::filesystem::path path =
+		std::filesystem::path(filepath).lexically_normal();
+	if (!included.insert(path.string()).second)
+		return;
+
+	std::ifstream file(path);
+	if (!file.good()) {
+		std::cerr << "File Does not exist: " << filepath << '\n';
+		throw std::runtime_error("File Does not exist");
+	}
+
+	bool defined = !root;
+	std::string line;
+	while (std::getline(file, line)) {
+		std::istringstream tokens(line);
+		std::string directive;
+		tokens >> directive;
+
+		if (directive == "#version") {
+			if (root) {
+				output += line + '\n' + define_block;
+				defined = true;
+			}
+			continue;
+		}
+
+		if (directive == "#include") {
+			std::size_t open = line.find('"');
+			std::size_t close = line.find('"', open + 1);
+			if (open == std::string::npos ||
+			    close == std::string::npos) {
+				std::cerr << "Malformed include in " << filepath
+					  << ": " << line << '\n';
+				throw std::runtime_error("Malformed include");
+			}
+
+			if (!defined) {
+				output += define_block;
+				defined = true;
+			}
+			std::filesystem::path include =
+				path.parent_path() /
+				line.substr(open + 1, close - open - 1);
+			expand(include.string(), included, define_block, false,
+			       output);
+			continue;
+		}
+
+		// Sources without a #version still see the defines first
+		if (!defined && !directive.empty() &&
+		    directive.rfind("//", 0) != 0) {
+			output += define_block;
+			defined = true;
+		}
+		output += line + '\n';
+	}
+
+	if (!defined) {
+		output += define_block;
+	}
+}
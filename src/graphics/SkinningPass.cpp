@@ -0,0 +1,212 @@
+#include <graphics/SkinningPass.h>
+
+#include <misc/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <graphics/Mesh.h>
+#include <graphics/Material.h>
+#include <graphics/GLState.h>
+#include <graphics/VertexLayout.h>
+#include <graphics/SkinningShader.h>
+#include <graphics/resource_management/MeshResource.h>
+
+#include <physics/Skeleton.h>
+#include <physics/AnimationSystem.h>
+
+SkinningPass &SkinningPass::get_instance()
+{
+	static SkinningPass instance;
+	return instance;
+}
+
+SkinningPass::SkinningPass()
+	: palette_buffer(0)
+	, palette_texture(0)
+	, mode(SkinningShader::Mode::LINEAR)
+	, next_mode(SkinningShader::Mode::LINEAR)
+	, skinned_vertices(0)
+	, last_skinned_vertices(0)
+{
+}
+
+SkinningPass::~SkinningPass()
+{
+	for (auto &[key, output] : outputs) {
+		release(output);
+	}
+	if (palette_buffer) {
+		glDeleteBuffers(1, &palette_buffer);
+		palette_buffer = 0;
+	}
+	if (palette_texture) {
+		GLState::get_instance().forget_texture(palette_texture);
+		glDeleteTextures(1, &palette_texture);
+		palette_texture = 0;
+	}
+}
+
+void SkinningPass::release(Output &output)
+{
+	if (output.vbo) {
+		glDeleteBuffers(1, &output.vbo);
+		output.vbo = 0;
+	}
+	if (output.vao) {
+		GLState::get_instance().forget_vertex_array(output.vao);
+		glDeleteVertexArrays(1, &output.vao);
+		output.vao = 0;
+	}
+}
+
+void SkinningPass::init_output(Output &output, const MeshResource &resource)
+{
+	glGenBuffers(1, &output.vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, output.vbo);
+	glBufferData(GL_ARRAY_BUFFER, resource.size * OUTPUT_STRIDE, nullptr,
+		     GL_DYNAMIC_COPY);
+	output.capacity = resource.size;
+
+	// Same attribute slots as VertexLayout::STATIC: position and normal
+	// come from the skinned output, UVs stay in the source buffer
+	glGenVertexArrays(1, &output.vao);
+	GLState::get_instance().bind_vertex_array(output.vao);
+
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, OUTPUT_STRIDE,
+			      (void *)0);
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, OUTPUT_STRIDE,
+			      (void *)(3 * sizeof(float)));
+
+	glBindBuffer(GL_ARRAY_BUFFER, resource.vbo);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 2, GL_HALF_FLOAT, GL_FALSE,
+			      VertexLayout::get(resource.layout).get_stride(),
+			      (void *)16);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, resource.ebo);
+
+	GLState::get_instance().bind_vertex_array(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void SkinningPass::set_mode(SkinningShader::Mode mode) noexcept
+{
+	next_mode = mode;
+}
+
+SkinningShader::Mode SkinningPass::get_mode() const noexcept
+{
+	return next_mode;
+}
+
+void SkinningPass::begin_frame() noexcept
+{
+	for (auto &[key, output] : outputs) {
+		output.used = false;
+	}
+	mode = next_mode;
+	jobs.clear();
+	palette.clear();
+	palette_offsets.clear();
+
+	// Skeletons driven by the AnimationSystem arrive already packed,
+	// add() only packs the ones it hasn't seen
+	AnimationSystem::get_instance().take_palette(mode, palette,
+						      palette_offsets);
+
+	last_skinned_vertices = skinned_vertices;
+	skinned_vertices = 0;
+}
+
+void SkinningPass::add(const Mesh &mesh, const MaterialData &material)
+{
+	const MeshResource *resource = mesh.get_resource();
+	if (!material.skeleton || resource->vao == 0 ||
+	    resource->layout != VertexLayout::Type::SKINNED)
+		return;
+
+	Output &output = outputs[{ resource, material.skeleton }];
+	if (output.used)
+		return;
+	output.used = true;
+
+	// Meshes sharing a skeleton share its palette
+	auto [it, inserted] = palette_offsets.insert(
+		{ material.skeleton,
+		  static_cast<int>(palette.size() / 4) });
+	if (inserted) {
+		for (const Bone &bone : material.skeleton->bones) {
+			SkinningShader::pack_bone(
+				mode, bone.finalTransformation, palette);
+		}
+	}
+
+	jobs.push_back({ resource, &output, it->second });
+}
+
+void SkinningPass::execute()
+{
+	for (auto it = outputs.begin(); it != outputs.end();) {
+		if (it->second.used) {
+			++it;
+			continue;
+		}
+		release(it->second);
+		it = outputs.erase(it);
+	}
+
+	if (jobs.empty())
+		return;
+
+	if (palette_buffer == 0) {
+		glGenBuffers(1, &palette_buffer);
+		glGenTextures(1, &palette_texture);
+		glBindTexture(GL_TEXTURE_BUFFER, palette_texture);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, palette_buffer);
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
+	}
+	glBindBuffer(GL_TEXTURE_BUFFER, palette_buffer);
+	glBufferData(GL_TEXTURE_BUFFER, palette.size() * sizeof(float),
+		     palette.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	GLState &state = GLState::get_instance();
+	SkinningShader &shader = SkinningShader::get_instance(mode);
+	shader.use_program();
+
+	glEnable(GL_RASTERIZER_DISCARD);
+	for (const Job &job : jobs) {
+		Output &output = *job.output;
+		if (output.vbo == 0 || output.capacity != job.resource->size) {
+			release(output);
+			init_output(output, *job.resource);
+		}
+
+		shader.set_palette(palette_texture, job.palette_offset);
+
+		state.bind_vertex_array(job.resource->vao);
+		glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, output.vbo);
+		glBeginTransformFeedback(GL_POINTS);
+		glDrawArrays(GL_POINTS, 0, job.resource->size);
+		glEndTransformFeedback();
+
+		skinned_vertices += job.resource->size;
+	}
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+	glDisable(GL_RASTERIZER_DISCARD);
+}
+
+GLuint SkinningPass::get_vertex_array(const Mesh &mesh,
+				      const Skeleton *skeleton) const
+{
+	auto it = outputs.find({ mesh.get_resource(), skeleton });
+	if (it == outputs.end() || !it->second.used)
+		return 0;
+	return it->second.vao;
+}
+
+int SkinningPass::get_skinned_vertices() const noexcept
+{
+	return last_skinned_vertices;
+}
@@ -0,0 +1,181 @@
+#include <graphics/SkinningShader.h>
+
+#include <graphics/Shader.h>
+#include <graphics/Material.h>
+#include <graphics/GLState.h>
+
+#include <cmath>
+#include <algorithm>
+#include <array>
+#include <string>
+#include <vector>
+
+SkinningShader::SkinningShader(Mode mode)
+	: Shader()
+	, mode(mode)
+{
+	this->load_shader();
+}
+
+SkinningShader &SkinningShader::get_instance(Mode mode)
+{
+	if (mode == Mode::DUAL_QUATERNION) {
+		static SkinningShader dual_quaternion(Mode::DUAL_QUATERNION);
+		return dual_quaternion;
+	}
+	static SkinningShader linear(Mode::LINEAR);
+	return linear;
+}
+
+int SkinningShader::get_bone_texels(Mode mode) noexcept
+{
+	return mode == Mode::DUAL_QUATERNION ? 2 : 6;
+}
+
+std::array<float, 9> SkinningShader::normal_matrix(const Matrix4f &bone)
+{
+	auto m = [&](int row, int column) { return bone.get(row, column); };
+
+	// Cofactors equal det * inverse transpose, the fragment shaders
+	// normalize the normal so only the sign of det matters
+	std::array<float, 9> cofactors{
+		m(1, 1) * m(2, 2) - m(1, 2) * m(2, 1),
+		m(1, 2) * m(2, 0) - m(1, 0) * m(2, 2),
+		m(1, 0) * m(2, 1) - m(1, 1) * m(2, 0),
+		m(0, 2) * m(2, 1) - m(0, 1) * m(2, 2),
+		m(0, 0) * m(2, 2) - m(0, 2) * m(2, 0),
+		m(0, 1) * m(2, 0) - m(0, 0) * m(2, 1),
+		m(0, 1) * m(1, 2) - m(0, 2) * m(1, 1),
+		m(0, 2) * m(1, 0) - m(0, 0) * m(1, 2),
+		m(0, 0) * m(1, 1) - m(0, 1) * m(1, 0)
+	};
+
+	float determinant = m(0, 0) * cofactors[0] + m(0, 1) * cofactors[1] +
+			    m(0, 2) * cofactors[2];
+	if (determinant < 0) {
+		for (float &cofactor : cofactors) {
+			cofactor = -cofactor;
+		}
+	}
+
+	return cofactors;
+}
+
+std::array<float, 8> SkinningShader::dual_quaternion(const Matrix4f &bone)
+{
+	// Rotation with the scale of every axis divided out
+	float r[3][3];
+	for (int column = 0; column < 3; column++) {
+		float length = 0;
+		for (int row = 0; row < 3; row++) {
+			length += bone.get(row, column) * bone.get(row, column);
+		}
+		length = std::sqrt(length);
+		for (int row = 0; row < 3; row++) {
+			r[row][column] = length > 0 ? bone.get(row, column) /
+							      length :
+						      (row == column);
+		}
+	}
+
+	float x, y, z, w;
+	float trace = r[0][0] + r[1][1] + r[2][2];
+	if (trace > 0) {
+		float s = 2.0f * std::sqrt(trace + 1.0f);
+		w = 0.25f * s;
+		x = (r[2][1] - r[1][2]) / s;
+		y = (r[0][2] - r[2][0]) / s;
+		z = (r[1][0] - r[0][1]) / s;
+	} else if (r[0][0] > r[1][1] && r[0][0] > r[2][2]) {
+		float s = 2.0f * std::sqrt(1.0f + r[0][0] - r[1][1] - r[2][2]);
+		w = (r[2][1] - r[1][2]) / s;
+		x = 0.25f * s;
+		y = (r[0][1] + r[1][0]) / s;
+		z = (r[0][2] + r[2][0]) / s;
+	} else if (r[1][1] > r[2][2]) {
+		float s = 2.0f * std::sqrt(1.0f + r[1][1] - r[0][0] - r[2][2]);
+		w = (r[0][2] - r[2][0]) / s;
+		x = (r[0][1] + r[1][0]) / s;
+		y = 0.25f * s;
+		z = (r[1][2] + r[2][1]) / s;
+	} else {
+		float s = 2.0f * std::sqrt(1.0f + r[2][2] - r[0][0] - r[1][1]);
+		w = (r[1][0] - r[0][1]) / s;
+		x = (r[0][2] + r[2][0]) / s;
+		y = (r[1][2] + r[2][1]) / s;
+		z = 0.25f * s;
+	}
+	float length = std::sqrt(x * x + y * y + z * z + w * w);
+	x /= length;
+	y /= length;
+	z /= length;
+	w /= length;
+
+	// dual = 0.5 * (translation, 0) * real
+	float tx = bone.get(0, 3), ty = bone.get(1, 3), tz = bone.get(2, 3);
+	return { x,
+		 y,
+		 z,
+		 w,
+		 0.5f * (w * tx + ty * z - tz * y),
+		 0.5f * (w * ty + tz * x - tx * z),
+		 0.5f * (w * tz + tx * y - ty * x),
+		 -0.5f * (tx * x + ty * y + tz * z) };
+}
+
+void SkinningShader::pack_bone(Mode mode, const Matrix4f &bone, float *texels)
+{
+	if (mode == Mode::DUAL_QUATERNION) {
+		std::array<float, 8> quaternions = dual_quaternion(bone);
+		std::copy(quaternions.begin(), quaternions.end(), texels);
+		return;
+	}
+
+	for (int row = 0; row < 3; row++) {
+		for (int column = 0; column < 4; column++) {
+			*texels++ = bone.get(row, column);
+		}
+	}
+
+	std::array<float, 9> normal = normal_matrix(bone);
+	for (int row = 0; row < 3; row++) {
+		texels = std::copy(&normal[row * 3], &normal[row * 3 + 3],
+				   texels);
+		*texels++ = 0;
+	}
+}
+
+void SkinningShader::pack_bone(Mode mode, const Matrix4f &bone,
+			       std::vector<float> &palette)
+{
+	std::size_t size = palette.size();
+	palette.resize(size + get_bone_texels(mode) * 4);
+	pack_bone(mode, bone, &palette[size]);
+}
+
+void SkinningShader::load_shader()
+{
+	ShaderPreprocessor::Defines defines{
+		{ "BONE_TEXELS", std::to_string(get_bone_texels(mode)) }
+	};
+	if (mode == Mode::DUAL_QUATERNION) {
+		defines["DUAL_QUATERNION"] = "";
+	}
+
+	this->set_feedback_varyings({ "skinned_position", "skinned_normal" });
+	this->load("shaders/skinning.vert", "", defines);
+
+	this->add_uniform("palette");
+	this->add_uniform("palette_offset");
+}
+
+void SkinningShader::set_palette(GLuint texture, int offset)
+{
+	GLState::get_instance().bind_texture(GL_TEXTURE_BUFFER, texture);
+	this->set_uniform("palette", 0);
+	this->set_uniform("palette_offset", offset);
+}
+
+void SkinningShader::update_uniforms(const MaterialData &material)
+{
+}
@@ -3,7 +3,12 @@
 #include <misc/glad.h>
 #include <GLFW/glfw3.h>
 
+#include <math/Vector3f.h>
+
 #include <graphics/Specular.h>
+#include <graphics/GLState.h>
+#include <graphics/AssetLoader.h>
+#include <graphics/CookedTexture.h>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <misc/stb_image.h>
@@ -18,6 +23,12 @@
 #include <iostream>
 #include <functional>
 #include <exception>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
 
 const std::function<void(void *)> Specular::deleter{ [](void *ptr) {
 	delete static_cast<Specular *>(ptr);
@@ -36,7 +47,8 @@ void Texture::bind() const
 {
 	if (texture_resource == nullptr || texture_resource->id == -1)
 		return;
-	glBindTexture(GL_TEXTURE_2D, texture_resource->id);
+	GLState::get_instance().bind_texture(texture_resource->target,
+					     texture_resource->id);
 }
 
 GLuint Texture::get_id() const noexcept
@@ -44,25 +56,18 @@ GLuint Texture::get_id() const noexcept
 	return this->texture_resource->id;
 }
 
-std::shared_ptr<void> Texture::load_texture(const std::string &file_path)
-{
-	Texture *texture = new Texture();
-
-	// Check cache for already loaded textures
-	if (Texture::texture_cache.count(file_path)) {
-		std::shared_ptr<TextureResource> resource =
-			Texture::texture_cache[file_path].lock();
-		if (resource) {
-			texture->texture_resource = resource;
-			return std::shared_ptr<void>(texture, Texture::deleter);
-		}
-	}
-
-	if (texture->texture_resource == nullptr) {
-		texture->texture_resource = std::make_shared<TextureResource>();
-		texture_cache[file_path] = texture->texture_resource;
-	}
+// Level 0 of a 2D texture, decoded without touching GL
+struct Image {
+	int width;
+	int height;
+	GLenum internal_format;
+	GLenum format;
+	GLenum type;
+	std::vector<unsigned char> pixels;
+};
 
+static Image decode_image(const std::string &file_path)
+{
 	// Extract file extension to determine whether it's PNG or EXR
 	std::string extension =
 		file_path.substr(file_path.find_last_of('.') + 1);
@@ -81,23 +86,15 @@ std::shared_ptr<void> Texture::load_texture(const std::string &file_path)
 					       1, width);
 			exrFile.readPixels(dw.min.y, dw.max.y);
 
-			glGenTextures(1, &texture->texture_resource->id);
-			glBindTexture(GL_TEXTURE_2D,
-				      texture->texture_resource->id);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,
-					GL_REPEAT);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T,
-					GL_REPEAT);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-					GL_LINEAR_MIPMAP_LINEAR);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
-					GL_LINEAR);
-
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width,
-				     height, 0, GL_RGBA, GL_HALF_FLOAT,
-				     &pixels[0][0]);
-
-			glGenerateMipmap(GL_TEXTURE_2D);
+			auto *data = reinterpret_cast<unsigned char *>(
+				&pixels[0][0]);
+			return { width,
+				 height,
+				 GL_RGBA16F,
+				 GL_RGBA,
+				 GL_HALF_FLOAT,
+				 { data, data + width * height *
+						       sizeof(Imf::Rgba) } };
 		} catch (const std::exception &e) {
 			std::cerr << "Failed to load EXR texture: " << e.what()
 				  << '\n';
@@ -121,6 +118,9 @@ std::shared_ptr<void> Texture::load_texture(const std::string &file_path)
 		case 1:
 			format = GL_RED;
 			break;
+		case 2:
+			format = GL_RG;
+			break;
 		case 4:
 			format = GL_RGBA;
 			break;
@@ -128,27 +128,381 @@ std::shared_ptr<void> Texture::load_texture(const std::string &file_path)
 			format = GL_RGB;
 		}
 
-		glGenTextures(1, &texture->texture_resource->id);
-		glBindTexture(GL_TEXTURE_2D, texture->texture_resource->id);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-				GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
-				GL_LINEAR);
+		Image image{ width, height, format, format, GL_UNSIGNED_BYTE,
+			     { data, data + width * height * channels } };
+		stbi_image_free(data);
+		return image;
+	}
 
-		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format,
-			     GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
+	std::cerr << "Unsupported texture format: " << file_path << '\n';
+	throw std::runtime_error("Unsupported texture format");
+}
 
-		stbi_image_free(data);
+static void set_texture_parameters()
+{
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+			GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+// The cooked version of a texture is used when the driver can take it and
+// it isn't older than the source, which doesn't have to be shipped
+static bool load_cooked(const std::string &file_path, CookedTexture &cooked)
+{
+	if (!GLAD_GL_ARB_texture_storage ||
+	    !GLAD_GL_EXT_texture_compression_s3tc)
+		return false;
+
+	std::string cooked_path = CookedTexture::get_path(file_path);
+	std::error_code error;
+	auto cooked_time = std::filesystem::last_write_time(cooked_path, error);
+	if (error)
+		return false;
+	auto source_time = std::filesystem::last_write_time(file_path, error);
+	if (!error && source_time > cooked_time)
+		return false;
+
+	return cooked.load(cooked_path);
+}
+
+// The whole chain is allocated at once, immutable and never regenerated
+static void allocate_storage(const CookedTexture &cooked)
+{
+	glTexStorage2D(GL_TEXTURE_2D, cooked.get_level_count(),
+		       cooked.get_internal_format(), cooked.get_width(),
+		       cooked.get_height());
+}
+
+static void upload_cooked(const CookedTexture &cooked)
+{
+	allocate_storage(cooked);
+	for (int i = 0; i < cooked.get_level_count(); i++) {
+		const std::vector<unsigned char> &level = cooked.get_level(i);
+		int width = cooked.get_level_width(i);
+		int height = cooked.get_level_height(i);
+		if (cooked.is_compressed()) {
+			glCompressedTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, width,
+						  height,
+						  cooked.get_internal_format(),
+						  level.size(), level.data());
+		} else {
+			glTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, width, height,
+					GL_RGBA, GL_HALF_FLOAT, level.data());
+		}
 	}
+}
+
+bool Texture::cook_texture(const std::string &file_path)
+{
+	Image image = decode_image(file_path);
+
+	CookedTexture cooked;
+	if (image.type == GL_HALF_FLOAT) {
+		std::vector<std::uint16_t> halves(image.pixels.size() /
+						  sizeof(std::uint16_t));
+		std::memcpy(halves.data(), image.pixels.data(),
+			    image.pixels.size());
+		cooked = CookedTexture::cook_hdr(halves.data(), image.width,
+						 image.height);
+	} else {
+		int channels = image.pixels.size() /
+			       (static_cast<std::size_t>(image.width) *
+				image.height);
+		cooked = CookedTexture::cook(image.pixels.data(), image.width,
+					     image.height, channels);
+	}
+	return cooked.save(CookedTexture::get_path(file_path));
+}
+
+std::shared_ptr<void> Texture::load_texture(const std::string &file_path)
+{
+	Texture *texture = new Texture();
+
+	// Check cache for already loaded textures
+	if (Texture::texture_cache.count(file_path)) {
+		std::shared_ptr<TextureResource> resource =
+			Texture::texture_cache[file_path].lock();
+		if (resource) {
+			texture->texture_resource = resource;
+			return std::shared_ptr<void>(texture, Texture::deleter);
+		}
+	}
+
+	CookedTexture cooked;
+	bool is_cooked = load_cooked(file_path, cooked);
+	Image image;
+	try {
+		if (!is_cooked) {
+			image = decode_image(file_path);
+		}
+	} catch (...) {
+		delete texture;
+		throw;
+	}
+
+	texture->texture_resource = std::make_shared<TextureResource>();
+	texture_cache[file_path] = texture->texture_resource;
 
-	else {
-		std::cerr << "Unsupported texture format: " << file_path
+	glGenTextures(1, &texture->texture_resource->id);
+	GLState::get_instance().bind_texture(GL_TEXTURE_2D,
+					     texture->texture_resource->id);
+	set_texture_parameters();
+
+	if (is_cooked) {
+		upload_cooked(cooked);
+		return std::shared_ptr<void>(texture, Texture::deleter);
+	}
+
+	// RGB rows aren't always 4 byte aligned
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, image.internal_format, image.width,
+		     image.height, 0, image.format, image.type,
+		     image.pixels.data());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glGenerateMipmap(GL_TEXTURE_2D);
+
+	return std::shared_ptr<void>(texture, Texture::deleter);
+}
+
+// Replaces the placeholder of an asynchronous load with the uploaded texture
+static void swap_in(TextureResource &resource, GLuint id)
+{
+	GLuint placeholder = resource.id;
+	resource.id = id;
+	resource.loading = false;
+	GLState::get_instance().forget_texture(placeholder);
+	glDeleteTextures(1, &placeholder);
+
+	std::vector<std::function<void()> > on_load;
+	std::swap(on_load, resource.on_load);
+	for (auto &callback : on_load) {
+		callback();
+	}
+}
+
+// Levels finish in order, so the last one completes the texture
+static void upload_cooked_async(AssetLoader &loader, GLuint id,
+				CookedTexture &cooked,
+				std::function<void()> done)
+{
+	allocate_storage(cooked);
+	int last = cooked.get_level_count() - 1;
+	for (int i = 0; i <= last; i++) {
+		std::function<void()> level_done;
+		if (i == last) {
+			level_done = std::move(done);
+		}
+		if (cooked.is_compressed()) {
+			loader.upload_compressed_level(
+				id, i, cooked.get_level_width(i),
+				cooked.get_level_height(i),
+				cooked.get_internal_format(),
+				cooked.take_level(i), std::move(level_done));
+		} else {
+			loader.upload_texture_level(
+				id, i, cooked.get_level_width(i),
+				cooked.get_level_height(i), GL_RGBA,
+				GL_HALF_FLOAT, cooked.take_level(i),
+				std::move(level_done));
+		}
+	}
+}
+
+std::shared_ptr<void> Texture::load_texture_async(
+	const std::string &file_path,
+	std::function<void(std::shared_ptr<void>)> loaded)
+{
+	Texture *texture = new Texture();
+	std::shared_ptr<void> handle(texture, Texture::deleter);
+
+	std::shared_ptr<TextureResource> resource;
+	if (Texture::texture_cache.count(file_path)) {
+		resource = Texture::texture_cache[file_path].lock();
+	}
+	if (resource) {
+		texture->texture_resource = resource;
+		if (loaded && resource->loading) {
+			resource->on_load.push_back(
+				[loaded, handle] { loaded(handle); });
+		} else if (loaded) {
+			loaded(handle);
+		}
+		return handle;
+	}
+
+	resource = std::make_shared<TextureResource>();
+	texture->texture_resource = resource;
+	texture_cache[file_path] = resource;
+
+	// Mid grey stands in until the upload completes
+	static const unsigned char grey[] = { 128, 128, 128, 255 };
+	glGenTextures(1, &resource->id);
+	GLState::get_instance().bind_texture(GL_TEXTURE_2D, resource->id);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA,
+		     GL_UNSIGNED_BYTE, grey);
+
+	resource->loading = true;
+	if (loaded) {
+		resource->on_load.push_back(
+			[loaded, handle] { loaded(handle); });
+	}
+
+	// The jobs keep the resource alive even if every handle is dropped
+	auto image = std::make_shared<Image>();
+	auto cooked = std::make_shared<CookedTexture>();
+	AssetLoader &loader = AssetLoader::get_instance();
+	auto work = [image, cooked, file_path] {
+		if (!load_cooked(file_path, *cooked)) {
+			*image = decode_image(file_path);
+		}
+	};
+	auto ready = [image, cooked, resource, &loader] {
+		GLuint id;
+		glGenTextures(1, &id);
+		GLState::get_instance().bind_texture(GL_TEXTURE_2D, id);
+		set_texture_parameters();
+
+		auto done = [resource, id] { swap_in(*resource, id); };
+		if (cooked->get_level_count() > 0) {
+			upload_cooked_async(loader, id, *cooked,
+					    std::move(done));
+		} else {
+			loader.upload_texture(id, image->width, image->height,
+					      image->internal_format,
+					      image->format, image->type,
+					      std::move(image->pixels),
+					      std::move(done));
+		}
+	};
+	// Nothing will be swapped in. The callbacks hold handles to the
+	// resource, and a later load of the path should try again
+	auto failed = [resource, file_path] {
+		resource->loading = false;
+		resource->on_load.clear();
+		auto cached = texture_cache.find(file_path);
+		if (cached != texture_cache.end() &&
+		    cached->second.lock() == resource) {
+			texture_cache.erase(cached);
+		}
+	};
+	loader.load(std::move(work), std::move(ready), std::move(failed));
+
+	return handle;
+}
+
+std::shared_ptr<void> Texture::load_cubemap(const std::string &file_path,
+					   int face_size)
+{
+	Texture *texture = new Texture();
+	std::string cache_key = file_path + "#cubemap";
+
+	if (Texture::texture_cache.count(cache_key)) {
+		std::shared_ptr<TextureResource> resource =
+			Texture::texture_cache[cache_key].lock();
+		if (resource) {
+			texture->texture_resource = resource;
+			return std::shared_ptr<void>(texture, Texture::deleter);
+		}
+	}
+
+	int width, height, channels;
+	unsigned char *data =
+		stbi_load(file_path.c_str(), &width, &height, &channels, 3);
+	if (!data) {
+		std::cerr << "Failed to load cubemap texture: " << file_path
 			  << '\n';
-		throw std::runtime_error("Unsupported texture format");
+		throw std::runtime_error("Failed to load cubemap texture");
+	}
+	if (face_size <= 0) {
+		face_size = width / 4;
+	}
+
+	texture->texture_resource = std::make_shared<TextureResource>();
+	texture->texture_resource->target = GL_TEXTURE_CUBE_MAP;
+	texture_cache[cache_key] = texture->texture_resource;
+
+	glGenTextures(1, &texture->texture_resource->id);
+	GLState::get_instance().bind_texture(GL_TEXTURE_CUBE_MAP,
+					     texture->texture_resource->id);
+
+	// Bilinear lookup with wrapping longitude and clamped latitude
+	auto sample = [&](float u, float v, int channel) {
+		float x = u * width - 0.5f;
+		float y = std::clamp(v * height - 0.5f, 0.0f, height - 1.0f);
+		int x0 = static_cast<int>(std::floor(x));
+		int y0 = static_cast<int>(y);
+		int y1 = std::min(y0 + 1, height - 1);
+		float fx = x - x0;
+		float fy = y - y0;
+		x0 = ((x0 % width) + width) % width;
+		int x1 = (x0 + 1) % width;
+
+		auto texel = [&](int tx, int ty) -> float {
+			return data[(ty * width + tx) * 3 + channel];
+		};
+		float top = texel(x0, y0) * (1 - fx) + texel(x1, y0) * fx;
+		float bottom = texel(x0, y1) * (1 - fx) + texel(x1, y1) * fx;
+		return top * (1 - fy) + bottom * fy;
+	};
+
+	std::vector<unsigned char> face(face_size * face_size * 3);
+	for (int f = 0; f < 6; f++) {
+		for (int j = 0; j < face_size; j++) {
+			for (int i = 0; i < face_size; i++) {
+				float s = (i + 0.5f) / face_size * 2 - 1;
+				float t = (j + 0.5f) / face_size * 2 - 1;
+
+				// Face orientation from the GL cubemap spec
+				Vector3f direction;
+				switch (f) {
+				case 0:
+					direction = { 1, -t, -s };
+					break;
+				case 1:
+					direction = { -1, -t, s };
+					break;
+				case 2:
+					direction = { s, 1, t };
+					break;
+				case 3:
+					direction = { s, -1, -t };
+					break;
+				case 4:
+					direction = { s, -t, 1 };
+					break;
+				default:
+					direction = { -s, -t, -1 };
+				}
+				direction = direction.normalize();
+
+				float u = 0.5f + std::atan2(direction.getZ(),
+							    direction.getX()) /
+							 (2 * M_PI);
+				float v = std::acos(direction.getY()) / M_PI;
+				for (int c = 0; c < 3; c++) {
+					face[(j * face_size + i) * 3 + c] =
+						sample(u, v, c) + 0.5f;
+				}
+			}
+		}
+		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + f, 0, GL_RGB8,
+			     face_size, face_size, 0, GL_RGB, GL_UNSIGNED_BYTE,
+			     face.data());
 	}
+	stbi_image_free(data);
+
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S,
+			GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T,
+			GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R,
+			GL_CLAMP_TO_EDGE);
 
 	return std::shared_ptr<void>(texture, Texture::deleter);
 }
@@ -0,0 +1,163 @@
+#include <graphics/VertexLayout.h>
+
+#include <misc/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <math/Vector2f.h>
+#include <math/Vector3f.h>
+
+#include <graphics/Vertex.h>
+
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+
+const VertexLayout VertexLayout::STATIC{ VertexLayout::Type::STATIC, 20 };
+const VertexLayout VertexLayout::SKINNED{ VertexLayout::Type::SKINNED, 32 };
+
+VertexLayout::VertexLayout(Type type, GLsizei stride)
+	: type(type)
+	, stride(stride)
+{
+}
+
+const VertexLayout &VertexLayout::get(Type type) noexcept
+{
+	if (type == Type::SKINNED)
+		return SKINNED;
+	return STATIC;
+}
+
+const VertexLayout &VertexLayout::select(const std::vector<Vertex> &vertices)
+{
+	for (const Vertex &v : vertices) {
+		for (float weight : v.boneWeights) {
+			if (weight != 0.0f)
+				return SKINNED;
+		}
+	}
+	return STATIC;
+}
+
+VertexLayout::Type VertexLayout::get_type() const noexcept
+{
+	return type;
+}
+
+GLsizei VertexLayout::get_stride() const noexcept
+{
+	return stride;
+}
+
+std::uint16_t VertexLayout::to_half(float value) noexcept
+{
+	std::uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+
+	std::uint16_t sign = (bits >> 16) & 0x8000;
+	int exponent = static_cast<int>((bits >> 23) & 0xFF) - 127 + 15;
+	std::uint32_t mantissa = bits & 0x7FFFFF;
+
+	// Below the normal half range, flush to signed zero
+	if (exponent <= 0)
+		return sign;
+	// Above it (including Inf / NaN), clamp to infinity
+	if (exponent >= 31)
+		return sign | 0x7C00;
+
+	// Round to nearest, a carry correctly bumps the exponent
+	std::uint16_t half = sign | (exponent << 10) | (mantissa >> 13);
+	if (mantissa & 0x1000) {
+		half++;
+	}
+	return half;
+}
+
+std::uint32_t VertexLayout::pack_normal(const Vector3f &normal) noexcept
+{
+	auto component = [](float value) -> std::uint32_t {
+		value = std::clamp(value, -1.0f, 1.0f);
+		std::int32_t snorm = static_cast<std::int32_t>(
+			std::lround(value * 511.0f));
+		return static_cast<std::uint32_t>(snorm) & 0x3FF;
+	};
+
+	return component(normal.getX()) | (component(normal.getY()) << 10) |
+	       (component(normal.getZ()) << 20);
+}
+
+std::vector<unsigned char>
+VertexLayout::pack(const std::vector<Vertex> &vertices) const
+{
+	std::vector<unsigned char> buffer(vertices.size() * stride);
+
+	unsigned char *out = buffer.data();
+	for (const Vertex &v : vertices) {
+		Vector3f pos = v.get_pos();
+		float position[3] = { pos.getX(), pos.getY(), pos.getZ() };
+		std::uint32_t normal = pack_normal(v.get_normal());
+		Vector2f tex_coord = v.get_texCoord();
+		std::uint16_t uv[2] = { to_half(tex_coord.getX()),
+					to_half(tex_coord.getY()) };
+
+		std::memcpy(out, position, sizeof(position));
+		std::memcpy(out + 12, &normal, sizeof(normal));
+		std::memcpy(out + 16, uv, sizeof(uv));
+
+		if (type == Type::SKINNED) {
+			std::uint8_t indices[4];
+			std::uint16_t weights[4];
+			for (int j = 0; j < 4; ++j) {
+				if (v.boneIndices[j] < 0 ||
+				    v.boneIndices[j] > 255) {
+					std::cerr << "Error: Bone index "
+						  << v.boneIndices[j]
+						  << " does not fit uint8\n";
+					throw std::runtime_error(
+						"Bone index out of range");
+				}
+				indices[j] = v.boneIndices[j];
+				weights[j] = std::lround(
+					std::clamp(v.boneWeights[j], 0.0f,
+						   1.0f) *
+					65535.0f);
+			}
+			std::memcpy(out + 20, indices, sizeof(indices));
+			std::memcpy(out + 24, weights, sizeof(weights));
+		}
+
+		out += stride;
+	}
+
+	return buffer;
+}
+
+void VertexLayout::apply() const
+{
+	glEnableVertexAttribArray(0); // Position
+	glEnableVertexAttribArray(1); // TexCoord
+	glEnableVertexAttribArray(2); // Normal
+
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void *)0);
+	glVertexAttribPointer(1, 2, GL_HALF_FLOAT, GL_FALSE, stride,
+			      (void *)16);
+	glVertexAttribPointer(2, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride,
+			      (void *)12);
+
+	if (type == Type::SKINNED) {
+		glEnableVertexAttribArray(3); // Bone Indices
+		glEnableVertexAttribArray(4); // Bone Weights
+
+		glVertexAttribIPointer(3, 4, GL_UNSIGNED_BYTE, stride,
+				       (void *)20);
+		glVertexAttribPointer(4, 4, GL_UNSIGNED_SHORT, GL_TRUE, stride,
+				      (void *)24);
+	} else {
+		glDisableVertexAttribArray(3);
+		glDisableVertexAttribArray(4);
+	}
+}
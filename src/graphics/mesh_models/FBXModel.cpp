@@ -90,9 +90,12 @@ void FBXModel::process_mesh(aiMesh *mesh, const aiScene *scene,
 FBXModel::FBXModel(const std::string &file_path)
 {
 	Assimp::Importer importer;
+	// The FBX importer writes one vertex per face corner, welding them
+	// is what lets MeshOptimizer reuse vertices across triangles
 	const aiScene *scene = importer.ReadFile(
 		file_path, aiProcess_Triangulate | aiProcess_FlipUVs |
-				   aiProcess_GenNormals);
+				   aiProcess_GenNormals |
+				   aiProcess_JoinIdenticalVertices);
 
 	if (!scene || !scene->mRootNode) {
 		throw std::runtime_error("Failed to load FBX file: " +
@@ -3,7 +3,7 @@
 #include <misc/glad.h>
 #include <GLFW/glfw3.h>
 
-#include <graphics/Vertex.h>
+#include <graphics/GLState.h>
 
 MeshResource::MeshResource()
 	: vao(0)
@@ -11,6 +11,11 @@ MeshResource::MeshResource()
 	, ebo(0)
 	, size(0)
 	, isize(0)
+	, index_type(GL_UNSIGNED_INT)
+	, layout(VertexLayout::Type::STATIC)
+	, radius(0)
+	, base_vertex(-1)
+	, first_index(-1)
 {
 }
 
@@ -21,10 +26,11 @@ MeshResource::~MeshResource()
 		ebo = 0;
 	}
 	if (vbo) {
-		glDeleteBuffers(size * Vertex::SIZE, &vbo);
+		glDeleteBuffers(1, &vbo);
 		vbo = 0;
 	}
 	if (vao) {
+		GLState::get_instance().forget_vertex_array(vao);
 		glDeleteVertexArrays(1, &vao);
 		vao = 0;
 	}
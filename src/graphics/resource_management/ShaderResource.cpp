@@ -3,6 +3,8 @@
 #include <misc/glad.h>
 #include <GLFW/glfw3.h>
 
+#include <graphics/GLState.h>
+
 ShaderResource::ShaderResource()
 	: shader_program(0)
 	, uniforms{}
@@ -12,7 +14,8 @@ ShaderResource::ShaderResource()
 ShaderResource::~ShaderResource()
 {
 	if (shader_program) {
-		glDeleteTextures(1, &shader_program);
+		GLState::get_instance().forget_program(shader_program);
+		glDeleteProgram(shader_program);
 		shader_program = 0;
 	}
 }
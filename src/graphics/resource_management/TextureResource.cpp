@@ -3,14 +3,19 @@
 #include <misc/glad.h>
 #include <GLFW/glfw3.h>
 
+#include <graphics/GLState.h>
+
 TextureResource::TextureResource()
 	: id(0)
+	, target(GL_TEXTURE_2D)
+	, loading(false)
 {
 }
 
 TextureResource::~TextureResource()
 {
 	if (id) {
+		GLState::get_instance().forget_texture(id);
 		glDeleteTextures(1, &id);
 		id = 0;
 	}
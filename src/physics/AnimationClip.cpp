@@ -0,0 +1,473 @@
+#include <physics/AnimationClip.h>
+
+#include <assimp/scene.h>
+#include <assimp/anim.h>
+
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+
+static const char MAGIC[4] = { 'G', 'E', 'A', 'C' };
+static const std::uint32_t VERSION = 1;
+
+// Far beyond any real skeleton or clip, larger counts in a file mean it is
+// corrupt
+static const std::uint32_t MAX_CHANNELS = 1 << 12;
+static const std::uint32_t MAX_FRAMES = 1 << 20;
+static const std::uint32_t MAX_NAME = 1 << 10;
+
+static const float FIXED_MAX = 65535.0f;
+static const float SMALLEST_MAX = 32767.0f;
+static const float SQRT_2 = 1.41421356f;
+
+AnimationClip::AnimationClip()
+	: sample_rate(SAMPLE_RATE)
+	, duration(0)
+	, frame_count(0)
+{
+}
+
+// Range of every channel's axis over all frames, as min and step per unit
+static void fixed_range(const std::vector<float> &values, int channels,
+			std::vector<float> &min, std::vector<float> &step)
+{
+	int components = channels * 3;
+	min.assign(components, 0);
+	step.assign(components, 0);
+	std::vector<float> max(components, 0);
+	for (int i = 0; i < values.size(); i++) {
+		int k = i % components;
+		if (i < components || values[i] < min[k]) {
+			min[k] = values[i];
+		}
+		if (i < components || values[i] > max[k]) {
+			max[k] = values[i];
+		}
+	}
+	for (int k = 0; k < components; k++) {
+		step[k] = (max[k] - min[k]) / FIXED_MAX;
+	}
+}
+
+static void encode_fixed(const std::vector<float> &values,
+			 const std::vector<float> &min,
+			 const std::vector<float> &step,
+			 std::vector<std::uint16_t> &keys)
+{
+	int components = min.size();
+	keys.resize(values.size());
+	for (int i = 0; i < values.size(); i++) {
+		int k = i % components;
+		float key = step[k] > 0 ? (values[i] - min[k]) / step[k] : 0;
+		keys[i] = static_cast<std::uint16_t>(
+			std::clamp(std::round(key), 0.0f, FIXED_MAX));
+	}
+}
+
+static void encode_rotation(const float *q, std::uint16_t *key)
+{
+	float length = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] +
+				 q[3] * q[3]);
+	float unit[4] = { 0, 0, 0, 1 };
+	if (length > 0) {
+		for (int i = 0; i < 4; i++) {
+			unit[i] = q[i] / length;
+		}
+	}
+
+	int largest = 0;
+	for (int i = 1; i < 4; i++) {
+		if (std::abs(unit[i]) > std::abs(unit[largest])) {
+			largest = i;
+		}
+	}
+	// q and -q are the same rotation, keep the dropped one positive
+	float sign = unit[largest] < 0 ? -1.0f : 1.0f;
+
+	for (int i = 0, j = 0; i < 4; i++) {
+		if (i == largest)
+			continue;
+		float value = (sign * unit[i] * SQRT_2 + 1) * 0.5f;
+		std::uint16_t bits = static_cast<std::uint16_t>(std::clamp(
+			std::round(value * SMALLEST_MAX), 0.0f, SMALLEST_MAX));
+		key[j] = (bits << 1) | ((largest >> j) & 1);
+		j++;
+	}
+}
+
+static void decode_rotation(const std::uint16_t *key, float *q)
+{
+	int largest = (key[0] & 1) | ((key[1] & 1) << 1);
+	float sum = 0;
+	for (int i = 0, j = 0; i < 4; i++) {
+		if (i == largest)
+			continue;
+		float value = (key[j] >> 1) / SMALLEST_MAX;
+		q[i] = (value * 2 - 1) / SQRT_2;
+		sum += q[i] * q[i];
+		j++;
+	}
+	q[largest] = std::sqrt(std::max(0.0f, 1 - sum));
+}
+
+AnimationClip::AnimationClip(const std::vector<std::string> &channel_names,
+			     float sample_rate,
+			     const std::vector<float> &translations,
+			     const std::vector<float> &rotations,
+			     const std::vector<float> &scales)
+	: channel_names(channel_names)
+	, sample_rate(sample_rate)
+	, duration(0)
+	, frame_count(0)
+{
+	int channels = channel_names.size();
+	if (channels == 0)
+		return;
+
+	frame_count = translations.size() / (channels * 3);
+	if (rotations.size() != frame_count * channels * 4 ||
+	    scales.size() != translations.size()) {
+		std::cerr << "Error: Animation clip frames have mismatched "
+			     "sizes\n";
+		throw std::runtime_error("Mismatched animation clip frames");
+	}
+	duration = frame_count > 1 ? (frame_count - 1) / sample_rate : 0;
+
+	fixed_range(translations, channels, translation_min,
+		    translation_step);
+	encode_fixed(translations, translation_min, translation_step,
+		     translation_keys);
+	fixed_range(scales, channels, scale_min, scale_step);
+	encode_fixed(scales, scale_min, scale_step, scale_keys);
+
+	rotation_keys.resize(frame_count * channels * 3);
+	for (int i = 0; i < frame_count * channels; i++) {
+		encode_rotation(&rotations[i * 4], &rotation_keys[i * 3]);
+	}
+}
+
+// Index of the last key at or after hint that starts no later than time
+template <typename Key>
+static unsigned int find_key(const Key *keys, unsigned int count, double time,
+			     unsigned int hint)
+{
+	unsigned int i = hint;
+	while (i + 1 < count && keys[i + 1].mTime <= time) {
+		i++;
+	}
+	return i;
+}
+
+template <typename Key>
+static float key_factor(const Key *keys, unsigned int count, unsigned int i,
+			double time)
+{
+	if (i + 1 >= count)
+		return 0;
+	double delta = keys[i + 1].mTime - keys[i].mTime;
+	if (delta <= 0)
+		return 0;
+	return std::clamp(static_cast<float>((time - keys[i].mTime) / delta),
+			  0.0f, 1.0f);
+}
+
+static aiVector3D interpolate(const aiVectorKey *keys, unsigned int count,
+			      unsigned int i, double time)
+{
+	float factor = key_factor(keys, count, i, time);
+	const aiVector3D &a = keys[i].mValue;
+	const aiVector3D &b = keys[std::min(i + 1, count - 1)].mValue;
+
+	aiVector3D result;
+	result.x = a.x + (b.x - a.x) * factor;
+	result.y = a.y + (b.y - a.y) * factor;
+	result.z = a.z + (b.z - a.z) * factor;
+	return result;
+}
+
+static aiQuaternion interpolate(const aiQuatKey *keys, unsigned int count,
+				unsigned int i, double time)
+{
+	float factor = key_factor(keys, count, i, time);
+
+	aiQuaternion result;
+	aiQuaternion::Interpolate(result, keys[i].mValue,
+				  keys[std::min(i + 1, count - 1)].mValue,
+				  factor);
+	result.Normalize();
+	return result;
+}
+
+AnimationClip AnimationClip::bake(const aiAnimation *animation,
+				  float sample_rate)
+{
+	double ticks_per_second = animation->mTicksPerSecond != 0 ?
+					  animation->mTicksPerSecond :
+					  25.0; // Assimp's default
+	float seconds = animation->mDuration / ticks_per_second;
+	int frames = static_cast<int>(std::ceil(seconds * sample_rate)) + 1;
+	int channels = animation->mNumChannels;
+
+	std::vector<std::string> names(channels);
+	std::vector<float> translations(frames * channels * 3);
+	std::vector<float> rotations(frames * channels * 4);
+	std::vector<float> scales(frames * channels * 3);
+
+	for (int c = 0; c < channels; c++) {
+		const aiNodeAnim *nodeAnim = animation->mChannels[c];
+		names[c] = nodeAnim->mNodeName.data;
+
+		// Frames only move forward, so each key search resumes
+		// where the previous frame stopped
+		unsigned int position = 0, rotation = 0, scaling = 0;
+		for (int f = 0; f < frames; f++) {
+			double time =
+				std::min(f / sample_rate * ticks_per_second,
+					 animation->mDuration);
+			int index = f * channels + c;
+
+			position = find_key(nodeAnim->mPositionKeys,
+					    nodeAnim->mNumPositionKeys, time,
+					    position);
+			aiVector3D translation = interpolate(
+				nodeAnim->mPositionKeys,
+				nodeAnim->mNumPositionKeys, position, time);
+			translations[index * 3 + 0] = translation.x;
+			translations[index * 3 + 1] = translation.y;
+			translations[index * 3 + 2] = translation.z;
+
+			rotation = find_key(nodeAnim->mRotationKeys,
+					    nodeAnim->mNumRotationKeys, time,
+					    rotation);
+			aiQuaternion quaternion = interpolate(
+				nodeAnim->mRotationKeys,
+				nodeAnim->mNumRotationKeys, rotation, time);
+			rotations[index * 4 + 0] = quaternion.x;
+			rotations[index * 4 + 1] = quaternion.y;
+			rotations[index * 4 + 2] = quaternion.z;
+			rotations[index * 4 + 3] = quaternion.w;
+
+			scaling = find_key(nodeAnim->mScalingKeys,
+					   nodeAnim->mNumScalingKeys, time,
+					   scaling);
+			aiVector3D scale = interpolate(
+				nodeAnim->mScalingKeys,
+				nodeAnim->mNumScalingKeys, scaling, time);
+			scales[index * 3 + 0] = scale.x;
+			scales[index * 3 + 1] = scale.y;
+			scales[index * 3 + 2] = scale.z;
+		}
+	}
+
+	return AnimationClip(names, sample_rate, translations, rotations,
+			     scales);
+}
+
+template <typename T>
+static void write_vector(std::ofstream &file, const std::vector<T> &values)
+{
+	file.write(reinterpret_cast<const char *>(values.data()),
+		   values.size() * sizeof(T));
+}
+
+template <typename T>
+static void read_vector(std::ifstream &file, std::vector<T> &values,
+			std::size_t size)
+{
+	values.resize(size);
+	file.read(reinterpret_cast<char *>(values.data()), size * sizeof(T));
+}
+
+bool AnimationClip::save(const std::string &path) const
+{
+	std::ofstream file(path, std::ios::binary);
+	std::uint32_t channels = channel_names.size();
+	std::uint32_t frames = frame_count;
+	file.write(MAGIC, sizeof(MAGIC));
+	file.write(reinterpret_cast<const char *>(&VERSION), sizeof(VERSION));
+	file.write(reinterpret_cast<const char *>(&sample_rate),
+		   sizeof(sample_rate));
+	file.write(reinterpret_cast<const char *>(&duration), sizeof(duration));
+	file.write(reinterpret_cast<const char *>(&channels), sizeof(channels));
+	file.write(reinterpret_cast<const char *>(&frames), sizeof(frames));
+	for (const std::string &name : channel_names) {
+		std::uint32_t size = name.size();
+		file.write(reinterpret_cast<const char *>(&size), sizeof(size));
+		file.write(name.data(), size);
+	}
+	write_vector(file, translation_min);
+	write_vector(file, translation_step);
+	write_vector(file, scale_min);
+	write_vector(file, scale_step);
+	write_vector(file, translation_keys);
+	write_vector(file, rotation_keys);
+	write_vector(file, scale_keys);
+
+	if (!file) {
+		std::cerr << "Warning: Failed to write animation clip " << path
+			  << '\n';
+		return false;
+	}
+	return true;
+}
+
+bool AnimationClip::load(const std::string &path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.good())
+		return false;
+
+	char magic[4];
+	std::uint32_t version = 0;
+	file.read(magic, sizeof(magic));
+	file.read(reinterpret_cast<char *>(&version), sizeof(version));
+	if (!file ||
+	    std::string(magic, sizeof(magic)) !=
+		    std::string(MAGIC, sizeof(MAGIC)) ||
+	    version != VERSION)
+		return false;
+
+	AnimationClip clip;
+	std::uint32_t channels = 0, frames = 0;
+	file.read(reinterpret_cast<char *>(&clip.sample_rate),
+		  sizeof(clip.sample_rate));
+	file.read(reinterpret_cast<char *>(&clip.duration),
+		  sizeof(clip.duration));
+	file.read(reinterpret_cast<char *>(&channels), sizeof(channels));
+	file.read(reinterpret_cast<char *>(&frames), sizeof(frames));
+	if (!file || channels > MAX_CHANNELS || frames > MAX_FRAMES)
+		return false;
+
+	// Sizes are checked against what is left of the file before anything
+	// is allocated for them, so a truncated file fails early
+	std::streamoff start = file.tellg();
+	file.seekg(0, std::ios::end);
+	std::uint64_t remaining = file.tellg() - start;
+	file.seekg(start);
+	std::uint64_t components = channels * 3;
+	std::uint64_t ranges = components * 4 * sizeof(float);
+	std::uint64_t keys = frames * components * 3 * sizeof(std::uint16_t);
+	if (channels * sizeof(std::uint32_t) + ranges + keys > remaining)
+		return false;
+
+	clip.frame_count = frames;
+	clip.channel_names.resize(channels);
+	for (std::string &name : clip.channel_names) {
+		std::uint32_t size = 0;
+		file.read(reinterpret_cast<char *>(&size), sizeof(size));
+		if (!file || size > MAX_NAME)
+			return false;
+		name.resize(size);
+		file.read(name.data(), size);
+	}
+
+	read_vector(file, clip.translation_min, components);
+	read_vector(file, clip.translation_step, components);
+	read_vector(file, clip.scale_min, components);
+	read_vector(file, clip.scale_step, components);
+	read_vector(file, clip.translation_keys, frames * components);
+	read_vector(file, clip.rotation_keys, frames * components);
+	read_vector(file, clip.scale_keys, frames * components);
+	if (!file)
+		return false;
+
+	*this = std::move(clip);
+	return true;
+}
+
+void AnimationClip::sample(float time, std::vector<float> &translations,
+			   std::vector<float> &rotations,
+			   std::vector<float> &scales) const
+{
+	int channels = channel_names.size();
+	int components = channels * 3;
+	translations.resize(components);
+	rotations.resize(channels * 4);
+	scales.resize(components);
+	if (frame_count == 0)
+		return;
+
+	float position = 0;
+	if (duration > 0) {
+		time = std::fmod(time, duration);
+		if (time < 0) {
+			time += duration;
+		}
+		position = time * sample_rate;
+	}
+	int frame = std::min(static_cast<int>(position), frame_count - 1);
+	int next = std::min(frame + 1, frame_count - 1);
+	float t = position - frame;
+
+	// Fixed point keys interpolate before being scaled into range
+	const std::uint16_t *a = &translation_keys[frame * components];
+	const std::uint16_t *b = &translation_keys[next * components];
+	for (int k = 0; k < components; k++) {
+		float key = a[k] + (b[k] - a[k]) * t;
+		translations[k] =
+			translation_min[k] + key * translation_step[k];
+	}
+
+	a = &scale_keys[frame * components];
+	b = &scale_keys[next * components];
+	for (int k = 0; k < components; k++) {
+		float key = a[k] + (b[k] - a[k]) * t;
+		scales[k] = scale_min[k] + key * scale_step[k];
+	}
+
+	// Normalized lerp along the shorter arc
+	a = &rotation_keys[frame * components];
+	b = &rotation_keys[next * components];
+	for (int c = 0; c < channels; c++) {
+		float qa[4], qb[4];
+		decode_rotation(&a[c * 3], qa);
+		decode_rotation(&b[c * 3], qb);
+
+		float dot = qa[0] * qb[0] + qa[1] * qb[1] + qa[2] * qb[2] +
+			    qa[3] * qb[3];
+		float tb = dot < 0 ? -t : t;
+		float q[4], length = 0;
+		for (int i = 0; i < 4; i++) {
+			q[i] = qa[i] * (1 - t) + qb[i] * tb;
+			length += q[i] * q[i];
+		}
+		length = length > 0 ? 1 / std::sqrt(length) : 0;
+		for (int i = 0; i < 4; i++) {
+			rotations[c * 4 + i] = q[i] * length;
+		}
+	}
+}
+
+int AnimationClip::find_channel(const std::string &name) const
+{
+	for (int i = 0; i < channel_names.size(); i++) {
+		if (channel_names[i] == name)
+			return i;
+	}
+	return -1;
+}
+
+int AnimationClip::get_channel_count() const noexcept
+{
+	return channel_names.size();
+}
+
+int AnimationClip::get_frame_count() const noexcept
+{
+	return frame_count;
+}
+
+float AnimationClip::get_sample_rate() const noexcept
+{
+	return sample_rate;
+}
+
+float AnimationClip::get_duration() const noexcept
+{
+	return duration;
+}
@@ -0,0 +1,379 @@
+#include <physics/AnimationSystem.h>
+
+#include <physics/Skeleton.h>
+#include <physics/AnimationClip.h>
+
+#include <math/Vector3f.h>
+#include <math/Matrix4f.h>
+#include <math/Transform.h>
+
+#include <graphics/LightBounds.h>
+#include <graphics/SkinningPass.h>
+#include <graphics/SkinningShader.h>
+
+#include <map>
+#include <cmath>
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <iostream>
+#include <algorithm>
+
+AnimationSystem &AnimationSystem::get_instance()
+{
+	static AnimationSystem instance;
+	return instance;
+}
+
+AnimationSystem::AnimationSystem()
+	: lod_distances{ 20.0f, 40.0f, 80.0f }
+	, has_view(false)
+	, lod_counts{}
+	, evaluated_count(0)
+	, palette_mode(SkinningShader::Mode::LINEAR)
+	, palette_ready(false)
+	, generation(0)
+	, active_workers(0)
+	, stopping(false)
+	, next_batch(0)
+	, benchmark(false)
+	, update_time(0)
+	, bone_count(0)
+{
+	unsigned int threads = std::thread::hardware_concurrency();
+	set_thread_count(threads > 1 ? threads - 1 : 0);
+}
+
+AnimationSystem::~AnimationSystem()
+{
+	set_thread_count(0);
+}
+
+void AnimationSystem::set_thread_count(int count)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	start.notify_all();
+	for (std::thread &worker : workers) {
+		worker.join();
+	}
+	workers.clear();
+
+	// Workers are only spawned between updates, the generation they
+	// start from has been fully handled
+	stopping = false;
+	for (int i = 0; i < count; i++) {
+		workers.emplace_back(&AnimationSystem::work, this, generation);
+	}
+}
+
+int AnimationSystem::get_thread_count() const noexcept
+{
+	return workers.size();
+}
+
+void AnimationSystem::work(int seen)
+{
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			start.wait(lock, [&] {
+				return stopping || generation != seen;
+			});
+			if (stopping)
+				return;
+			seen = generation;
+		}
+
+		run_batches();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			active_workers--;
+		}
+		done.notify_one();
+	}
+}
+
+void AnimationSystem::run_batches()
+{
+	for (;;) {
+		int first = next_batch.fetch_add(1) * BATCH_SIZE;
+		if (first >= instances.size())
+			return;
+		int last = std::min<int>(first + BATCH_SIZE, instances.size());
+
+		for (int i = first; i < last; i++) {
+			pose(instances[i]);
+		}
+	}
+}
+
+void AnimationSystem::schedule(Instance &instance, float delta)
+{
+	LOD previous_lod = instance.lod;
+	instance.lod = FULL;
+	Transform *transform = instance.transform;
+	if (has_view && transform) {
+		Vector3f position = transform->get_transformed_position();
+		LightBounds::Rect bounds = LightBounds::project_sphere(
+			position, instance.radius, view_projection, 1, 1);
+		float distance = (position - view_position).length();
+
+		if (bounds.empty) {
+			instance.lod = HIDDEN;
+		} else {
+			for (int i = 0; i < 3; i++) {
+				if (distance >= lod_distances[i]) {
+					instance.lod = LOD(HALF + i);
+				}
+			}
+		}
+	}
+	lod_counts[instance.lod]++;
+
+	// A pose from before it went out of view is too old to blend from
+	if (previous_lod == HIDDEN && instance.lod != HIDDEN) {
+		instance.next.clear();
+	}
+
+	std::size_t size = instance.palette_size;
+	bool posed = instance.next.size() == size;
+	if (instance.lod == HIDDEN) {
+		// Keeps the last pose, then catches up as soon as it's visible
+		instance.evaluate = !posed;
+		instance.interval = 1;
+		instance.frame = 0;
+	} else if (!posed || instance.frame + 1 >= instance.interval) {
+		instance.evaluate = true;
+		instance.interval = 1 << instance.lod;
+		instance.frame = 0;
+	} else {
+		instance.evaluate = false;
+		instance.frame++;
+	}
+
+	// Posed for the last frame of the interval, the frames before it
+	// blend from the previous evaluation
+	float ahead = (instance.interval - 1) * delta * instance.speed;
+	instance.evaluate_time = instance.time + ahead;
+	if (instance.evaluate) {
+		evaluated_count++;
+	}
+}
+
+void AnimationSystem::pose(Instance &instance)
+{
+	std::size_t size = instance.palette_size;
+	if (instance.evaluate) {
+		Skeleton &skeleton = *instance.skeleton;
+		skeleton.update_bone_transforms(instance.evaluate_time);
+
+		std::swap(instance.previous, instance.next);
+		instance.next.resize(size);
+		float *texels = instance.next.data();
+		int bone_floats =
+			SkinningShader::get_bone_texels(palette_mode) * 4;
+		for (const Bone &bone : skeleton.bones) {
+			SkinningShader::pack_bone(palette_mode,
+						  bone.finalTransformation,
+						  texels);
+			texels += bone_floats;
+		}
+		if (instance.previous.size() != size) {
+			instance.previous = instance.next;
+		}
+	}
+
+	float *out = palette.data() + instance.palette_offset;
+	float t = static_cast<float>(instance.frame + 1) / instance.interval;
+	if (instance.lod == HIDDEN || t >= 1) {
+		std::copy(instance.next.begin(), instance.next.end(), out);
+		return;
+	}
+
+	const float *a = instance.previous.data();
+	const float *b = instance.next.data();
+	if (palette_mode != SkinningShader::Mode::DUAL_QUATERNION) {
+		for (std::size_t i = 0; i < size; i++) {
+			out[i] = a[i] + (b[i] - a[i]) * t;
+		}
+		return;
+	}
+
+	// Dual quaternions blend in the hemisphere of the previous pose
+	for (std::size_t i = 0; i < size; i += 8) {
+		float dot = a[i] * b[i] + a[i + 1] * b[i + 1] +
+			    a[i + 2] * b[i + 2] + a[i + 3] * b[i + 3];
+		float sign = dot < 0 ? -1.0f : 1.0f;
+		for (std::size_t j = i; j < i + 8; j++) {
+			out[j] = a[j] + (sign * b[j] - a[j]) * t;
+		}
+	}
+}
+
+void AnimationSystem::add(Skeleton *skeleton, float speed,
+			  Transform *transform, float radius)
+{
+	for (const Instance &instance : instances) {
+		if (instance.skeleton == skeleton)
+			return;
+	}
+
+	Instance instance{};
+	instance.skeleton = skeleton;
+	instance.transform = transform;
+	instance.radius = radius;
+	instance.speed = speed;
+	instance.lod = FULL;
+	instance.interval = 1;
+	instances.push_back(std::move(instance));
+}
+
+void AnimationSystem::remove(Skeleton *skeleton)
+{
+	instances.erase(std::remove_if(instances.begin(), instances.end(),
+				       [&](const Instance &instance) {
+					       return instance.skeleton ==
+						      skeleton;
+				       }),
+			instances.end());
+}
+
+void AnimationSystem::update(float delta)
+{
+	auto begin = std::chrono::steady_clock::now();
+
+	palette_mode = SkinningPass::get_instance().get_mode();
+	int texels = SkinningShader::get_bone_texels(palette_mode);
+
+	// Offsets are fixed up front so no two batches write the same floats
+	palette_offsets.clear();
+	bone_count = 0;
+	std::fill(std::begin(lod_counts), std::end(lod_counts), 0);
+	evaluated_count = 0;
+	for (Instance &instance : instances) {
+		float duration = instance.skeleton->get_clip().get_duration();
+		instance.time += delta * instance.speed;
+		if (duration > 0) {
+			instance.time = std::fmod(instance.time, duration);
+		}
+
+		int bones = instance.skeleton->bones.size();
+		instance.palette_offset = bone_count * texels * 4;
+		instance.palette_size = bones * texels * 4;
+		palette_offsets[instance.skeleton] = bone_count * texels;
+		bone_count += bones;
+
+		schedule(instance, delta);
+	}
+	palette.resize(bone_count * texels * 4);
+
+	next_batch = 0;
+	if (!workers.empty() && instances.size() > BATCH_SIZE) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			active_workers = workers.size();
+			generation++;
+		}
+		start.notify_all();
+
+		run_batches();
+
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [&] { return active_workers == 0; });
+	} else {
+		run_batches();
+	}
+	palette_ready = true;
+
+	update_time = std::chrono::duration<double, std::micro>(
+			      std::chrono::steady_clock::now() - begin)
+			      .count();
+	if (benchmark) {
+		std::cout << "Animation: " << instances.size()
+			  << " skeletons, " << bone_count << " bones in "
+			  << update_time << " us ("
+			  << get_time_per_skeleton() << " us per skeleton, "
+			  << get_time_per_bone() << " us per bone, "
+			  << workers.size() + 1 << " threads), "
+			  << evaluated_count << " evaluated, LOD "
+			  << lod_counts[FULL] << '/' << lod_counts[HALF] << '/'
+			  << lod_counts[QUARTER] << '/' << lod_counts[EIGHTH]
+			  << ", " << lod_counts[HIDDEN] << " hidden\n";
+	}
+}
+
+bool AnimationSystem::take_palette(SkinningShader::Mode mode,
+				   std::vector<float> &palette,
+				   std::map<const Skeleton *, int> &offsets)
+{
+	if (!palette_ready || mode != palette_mode)
+		return false;
+
+	// Swapped rather than copied, the old buffers are reused next update
+	std::swap(this->palette, palette);
+	std::swap(palette_offsets, offsets);
+	palette_ready = false;
+	return true;
+}
+
+void AnimationSystem::set_lod_distances(float half, float quarter,
+					float eighth) noexcept
+{
+	lod_distances[0] = half;
+	lod_distances[1] = quarter;
+	lod_distances[2] = eighth;
+}
+
+void AnimationSystem::set_view(const Vector3f &position,
+			       const Matrix4f &view_projection) noexcept
+{
+	view_position = position;
+	this->view_projection = view_projection;
+	has_view = true;
+}
+
+void AnimationSystem::set_benchmark(bool enable) noexcept
+{
+	benchmark = enable;
+}
+
+double AnimationSystem::get_update_time() const noexcept
+{
+	return update_time;
+}
+
+double AnimationSystem::get_time_per_skeleton() const noexcept
+{
+	return instances.empty() ? 0 : update_time / instances.size();
+}
+
+double AnimationSystem::get_time_per_bone() const noexcept
+{
+	return bone_count == 0 ? 0 : update_time / bone_count;
+}
+
+int AnimationSystem::get_skeleton_count() const noexcept
+{
+	return instances.size();
+}
+
+int AnimationSystem::get_bone_count() const noexcept
+{
+	return bone_count;
+}
+
+int AnimationSystem::get_lod_count(LOD lod) const noexcept
+{
+	return lod_counts[lod];
+}
+
+int AnimationSystem::get_evaluated_count() const noexcept
+{
+	return evaluated_count;
+}
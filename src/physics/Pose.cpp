@@ -0,0 +1,376 @@
+#include <physics/Pose.h>
+
+#include <math/Matrix4f.h>
+
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <iostream>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+
+// Four nodes per operation
+struct Lanes {
+	__m128 v;
+};
+
+static inline Lanes load(const float *p)
+{
+	return { _mm_loadu_ps(p) };
+}
+
+static inline void store(float *p, Lanes a)
+{
+	_mm_storeu_ps(p, a.v);
+}
+
+static inline Lanes splat(float v)
+{
+	return { _mm_set1_ps(v) };
+}
+
+static inline Lanes operator+(Lanes a, Lanes b)
+{
+	return { _mm_add_ps(a.v, b.v) };
+}
+
+static inline Lanes operator-(Lanes a, Lanes b)
+{
+	return { _mm_sub_ps(a.v, b.v) };
+}
+
+static inline Lanes operator*(Lanes a, Lanes b)
+{
+	return { _mm_mul_ps(a.v, b.v) };
+}
+
+static inline Lanes operator/(Lanes a, Lanes b)
+{
+	return { _mm_div_ps(a.v, b.v) };
+}
+
+static inline Lanes sqrt(Lanes a)
+{
+	return { _mm_sqrt_ps(a.v) };
+}
+
+// a with its sign flipped wherever s is negative
+static inline Lanes flip_sign(Lanes a, Lanes s)
+{
+	return { _mm_xor_ps(a.v, _mm_and_ps(s.v, _mm_set1_ps(-0.0f))) };
+}
+#else
+// Same operations one float at a time where SSE2 isn't available
+struct Lanes {
+	float v[Pose::LANES];
+};
+
+static inline Lanes load(const float *p)
+{
+	Lanes r;
+	for (int i = 0; i < Pose::LANES; i++) {
+		r.v[i] = p[i];
+	}
+	return r;
+}
+
+static inline void store(float *p, Lanes a)
+{
+	for (int i = 0; i < Pose::LANES; i++) {
+		p[i] = a.v[i];
+	}
+}
+
+static inline Lanes splat(float v)
+{
+	Lanes r;
+	for (int i = 0; i < Pose::LANES; i++) {
+		r.v[i] = v;
+	}
+	return r;
+}
+
+#define LANES_OPERATOR(op)                                     \
+	static inline Lanes operator op(Lanes a, Lanes b)      \
+	{                                                      \
+		for (int i = 0; i < Pose::LANES; i++) {        \
+			a.v[i] = a.v[i] op b.v[i];             \
+		}                                              \
+		return a;                                      \
+	}
+
+LANES_OPERATOR(+)
+LANES_OPERATOR(-)
+LANES_OPERATOR(*)
+LANES_OPERATOR(/)
+
+#undef LANES_OPERATOR
+
+static inline Lanes sqrt(Lanes a)
+{
+	for (int i = 0; i < Pose::LANES; i++) {
+		a.v[i] = std::sqrt(a.v[i]);
+	}
+	return a;
+}
+
+static inline Lanes flip_sign(Lanes a, Lanes s)
+{
+	for (int i = 0; i < Pose::LANES; i++) {
+		a.v[i] = std::signbit(s.v[i]) ? -a.v[i] : a.v[i];
+	}
+	return a;
+}
+#endif
+
+struct QuaternionLanes {
+	Lanes x, y, z, w;
+};
+
+static inline QuaternionLanes load_rotation(const Pose &pose, int i)
+{
+	return { load(pose.get(Pose::RX) + i), load(pose.get(Pose::RY) + i),
+		 load(pose.get(Pose::RZ) + i), load(pose.get(Pose::RW) + i) };
+}
+
+static inline void store_rotation(Pose &pose, int i, const QuaternionLanes &q)
+{
+	store(pose.get(Pose::RX) + i, q.x);
+	store(pose.get(Pose::RY) + i, q.y);
+	store(pose.get(Pose::RZ) + i, q.z);
+	store(pose.get(Pose::RW) + i, q.w);
+}
+
+static inline QuaternionLanes normalize(const QuaternionLanes &q)
+{
+	Lanes length =
+		sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+	return { q.x / length, q.y / length, q.z / length, q.w / length };
+}
+
+// Normalized lerp from a to b along the shorter arc
+static inline QuaternionLanes nlerp(const QuaternionLanes &a,
+				    const QuaternionLanes &b, Lanes t)
+{
+	Lanes dot = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+	Lanes tb = flip_sign(t, dot);
+	Lanes ta = splat(1.0f) - t;
+	return normalize({ a.x * ta + b.x * tb, a.y * ta + b.y * tb,
+			   a.z * ta + b.z * tb, a.w * ta + b.w * tb });
+}
+
+static inline QuaternionLanes multiply(const QuaternionLanes &a,
+				       const QuaternionLanes &b)
+{
+	return { a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+		 a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+		 a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+		 a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z };
+}
+
+Pose::Pose()
+	: count(0)
+	, stride(0)
+{
+}
+
+Pose::Pose(int count)
+	: Pose()
+{
+	resize(count);
+}
+
+int Pose::get_stride(int count) noexcept
+{
+	return (count + LANES - 1) / LANES * LANES;
+}
+
+void Pose::resize(int count)
+{
+	if (count == this->count)
+		return;
+
+	Pose resized;
+	resized.count = count;
+	resized.stride = get_stride(count);
+	resized.data.assign(resized.stride * COMPONENTS, 0);
+	for (Component c : { RW, SX, SY, SZ }) {
+		std::fill(resized.get(c), resized.get(c) + resized.stride, 1);
+	}
+
+	int kept = std::min(count, this->count);
+	for (int c = 0; c < COMPONENTS; c++) {
+		std::copy(get(Component(c)), get(Component(c)) + kept,
+			  resized.get(Component(c)));
+	}
+	*this = std::move(resized);
+}
+
+int Pose::get_count() const noexcept
+{
+	return count;
+}
+
+float *Pose::get(Component component) noexcept
+{
+	return data.data() + component * stride;
+}
+
+const float *Pose::get(Component component) const noexcept
+{
+	return data.data() + component * stride;
+}
+
+void Pose::set(int index, const Matrix4f &transform)
+{
+	float scale[3], r[3][3];
+	for (int column = 0; column < 3; column++) {
+		float length = 0;
+		for (int row = 0; row < 3; row++) {
+			length += transform.get(row, column) *
+				  transform.get(row, column);
+		}
+		scale[column] = std::sqrt(length);
+		for (int row = 0; row < 3; row++) {
+			r[row][column] = scale[column] > 0 ?
+						 transform.get(row, column) /
+							 scale[column] :
+						 (row == column);
+		}
+	}
+
+	float x, y, z, w;
+	float trace = r[0][0] + r[1][1] + r[2][2];
+	if (trace > 0) {
+		float s = 0.5f / std::sqrt(trace + 1);
+		w = 0.25f / s;
+		x = (r[2][1] - r[1][2]) * s;
+		y = (r[0][2] - r[2][0]) * s;
+		z = (r[1][0] - r[0][1]) * s;
+	} else if (r[0][0] > r[1][1] && r[0][0] > r[2][2]) {
+		float s = 2 * std::sqrt(1 + r[0][0] - r[1][1] - r[2][2]);
+		w = (r[2][1] - r[1][2]) / s;
+		x = 0.25f * s;
+		y = (r[0][1] + r[1][0]) / s;
+		z = (r[0][2] + r[2][0]) / s;
+	} else if (r[1][1] > r[2][2]) {
+		float s = 2 * std::sqrt(1 + r[1][1] - r[0][0] - r[2][2]);
+		w = (r[0][2] - r[2][0]) / s;
+		x = (r[0][1] + r[1][0]) / s;
+		y = 0.25f * s;
+		z = (r[1][2] + r[2][1]) / s;
+	} else {
+		float s = 2 * std::sqrt(1 + r[2][2] - r[0][0] - r[1][1]);
+		w = (r[1][0] - r[0][1]) / s;
+		x = (r[0][2] + r[2][0]) / s;
+		y = (r[1][2] + r[2][1]) / s;
+		z = 0.25f * s;
+	}
+
+	float values[COMPONENTS] = { transform.get(0, 3),
+				     transform.get(1, 3),
+				     transform.get(2, 3),
+				     x,
+				     y,
+				     z,
+				     w,
+				     scale[0],
+				     scale[1],
+				     scale[2] };
+	for (int c = 0; c < COMPONENTS; c++) {
+		get(Component(c))[index] = values[c];
+	}
+}
+
+Matrix4f Pose::get_transform(int index) const
+{
+	float x = get(RX)[index], y = get(RY)[index], z = get(RZ)[index],
+	      w = get(RW)[index];
+	float sx = get(SX)[index], sy = get(SY)[index], sz = get(SZ)[index];
+
+	float m[4][4] = {
+		{ (1 - 2 * (y * y + z * z)) * sx, 2 * (x * y - w * z) * sy,
+		  2 * (x * z + w * y) * sz, get(TX)[index] },
+		{ 2 * (x * y + w * z) * sx, (1 - 2 * (x * x + z * z)) * sy,
+		  2 * (y * z - w * x) * sz, get(TY)[index] },
+		{ 2 * (x * z - w * y) * sx, 2 * (y * z + w * x) * sy,
+		  (1 - 2 * (x * x + y * y)) * sz, get(TZ)[index] },
+		{ 0, 0, 0, 1 }
+	};
+	return Matrix4f(m);
+}
+
+static void check(const Pose &pose, const Pose &other,
+		  const std::vector<float> *mask)
+{
+	if (other.get_count() != pose.get_count() ||
+	    (mask && int(mask->size()) < Pose::get_stride(pose.get_count()))) {
+		std::cerr << "Error: Blending poses of different skeletons\n";
+		throw std::runtime_error("Mismatched pose blend");
+	}
+}
+
+void Pose::blend(const Pose &other, float weight,
+		 const std::vector<float> *mask)
+{
+	check(*this, other, mask);
+
+	for (int i = 0; i < stride; i += LANES) {
+		Lanes t = splat(weight);
+		if (mask) {
+			t = t * load(mask->data() + i);
+		}
+
+		for (Component c : { TX, TY, TZ, SX, SY, SZ }) {
+			Lanes a = load(get(c) + i);
+			Lanes b = load(other.get(c) + i);
+			store(get(c) + i, a + (b - a) * t);
+		}
+
+		store_rotation(*this, i,
+			       nlerp(load_rotation(*this, i),
+				     load_rotation(other, i), t));
+	}
+}
+
+void Pose::add(const Pose &other, const Pose &reference, float weight,
+	       const std::vector<float> *mask)
+{
+	check(*this, other, mask);
+	check(*this, reference, nullptr);
+
+	const QuaternionLanes identity = { splat(0), splat(0), splat(0),
+					   splat(1) };
+	for (int i = 0; i < stride; i += LANES) {
+		Lanes t = splat(weight);
+		if (mask) {
+			t = t * load(mask->data() + i);
+		}
+
+		for (Component c : { TX, TY, TZ }) {
+			Lanes delta = load(other.get(c) + i) -
+				      load(reference.get(c) + i);
+			store(get(c) + i, load(get(c) + i) + delta * t);
+		}
+		for (Component c : { SX, SY, SZ }) {
+			Lanes ratio = load(other.get(c) + i) /
+				      load(reference.get(c) + i);
+			Lanes factor = splat(1.0f) + (ratio - splat(1.0f)) * t;
+			store(get(c) + i, load(get(c) + i) * factor);
+		}
+
+		// Rotation taking reference to other, applied on top
+		QuaternionLanes inverse = load_rotation(reference, i);
+		inverse.x = splat(0) - inverse.x;
+		inverse.y = splat(0) - inverse.y;
+		inverse.z = splat(0) - inverse.z;
+		QuaternionLanes delta =
+			nlerp(identity,
+			      multiply(load_rotation(other, i), inverse), t);
+		store_rotation(*this, i,
+			       normalize(multiply(delta,
+						  load_rotation(*this, i))));
+	}
+}
@@ -1,11 +1,18 @@
 #include <physics/Skeleton.h>
 
 #include <math/Matrix4f.h>
-#include <math/Quaternion.h>
+#include <physics/Pose.h>
+#include <physics/AnimationClip.h>
 
 #include <assimp/scene.h>
 #include <assimp/anim.h>
 
+#include <string>
+#include <vector>
+#include <utility>
+#include <iostream>
+#include <stdexcept>
+
 Matrix4f from_aiMatrix4x4(const aiMatrix4x4 &am)
 {
 	float m[4][4];
@@ -17,7 +24,7 @@ Matrix4f from_aiMatrix4x4(const aiMatrix4x4 &am)
 	return Matrix4f(m);
 }
 
-inline constexpr float determinant(float **m)
+inline constexpr float determinant(const float m[4][4])
 {
 	return m[0][3] * m[1][2] * m[2][1] * m[3][0] -
 	       m[0][2] * m[1][3] * m[2][1] * m[3][0] -
@@ -45,40 +52,50 @@ inline constexpr float determinant(float **m)
 	       m[0][0] * m[1][1] * m[2][2] * m[3][3];
 }
 
-void cofactor(float **m, float **temp, int p, int q, int n)
+// Determinant of the 3x3 matrix left after removing row p and column q
+inline constexpr float minor(const float m[4][4], int p, int q)
 {
-	int i = 0, j = 0;
-	for (int row = 0; row < n; row++) {
-		for (int col = 0; col < n; col++) {
-			if (row != p && col != q) {
+	float temp[3][3] = {};
+	int i = 0;
+	for (int row = 0; row < 4; row++) {
+		if (row == p)
+			continue;
+		int j = 0;
+		for (int col = 0; col < 4; col++) {
+			if (col != q) {
 				temp[i][j++] = m[row][col];
-				if (j == n - 1) {
-					j = 0;
-					i++;
-				}
 			}
 		}
+		i++;
 	}
+	return temp[0][0] *
+		       (temp[1][1] * temp[2][2] - temp[1][2] * temp[2][1]) -
+	       temp[0][1] *
+		       (temp[1][0] * temp[2][2] - temp[1][2] * temp[2][0]) +
+	       temp[0][2] *
+		       (temp[1][0] * temp[2][1] - temp[1][1] * temp[2][0]);
 }
 
 // Function to compute the adjugate of a matrix
-void adjugate(float **m, float adj[4][4])
+void adjugate(const float m[4][4], float adj[4][4])
 {
-	float temp[4][4];
-	int sign = 1;
 	for (int i = 0; i < 4; i++) {
 		for (int j = 0; j < 4; j++) {
-			cofactor(m, (float **)((void *)temp), i, j, 4);
-			sign = ((i + j) % 2 == 0) ? 1 : -1;
-			adj[j][i] =
-				sign * determinant((float **)((void *)temp));
+			int sign = ((i + j) % 2 == 0) ? 1 : -1;
+			adj[j][i] = sign * minor(m, i, j);
 		}
 	}
 }
 
 Matrix4f inverse(const Matrix4f &mat)
 {
-	float **m = (float **)((void *)mat.get_matrix());
+	float m[4][4];
+	for (int i = 0; i < 4; i++) {
+		for (int j = 0; j < 4; j++) {
+			m[i][j] = mat.get(i, j);
+		}
+	}
+
 	float inv[4][4];
 	float det = determinant(m);
 	if (det == 0) {
@@ -102,6 +119,61 @@ Skeleton::Skeleton(const aiScene *scene)
 {
 	globalInverseTransform =
 		inverse(from_aiMatrix4x4(scene->mRootNode->mTransformation));
+	if (scene->mNumAnimations > 0) {
+		// Assume first animation
+		clip = AnimationClip::bake(scene->mAnimations[0]);
+	}
+	flatten();
+}
+
+void Skeleton::flatten()
+{
+	// Depth first, so a node's parent is always evaluated before it
+	std::vector<std::pair<const aiNode *, int> > stack = {
+		{ scene->mRootNode, -1 }
+	};
+	while (!stack.empty()) {
+		auto [node, parent] = stack.back();
+		stack.pop_back();
+
+		std::string nodeName(node->mName.data);
+		int index = nodes.size();
+		nodes.push_back({ parent, -1,
+				  from_aiMatrix4x4(node->mTransformation) });
+		node_names.push_back(nodeName);
+
+		for (int i = node->mNumChildren - 1; i >= 0; i--) {
+			stack.push_back({ node->mChildren[i], index });
+		}
+	}
+	global_transforms.resize(nodes.size());
+
+	bind_pose.resize(nodes.size());
+	for (int i = 0; i < nodes.size(); i++) {
+		bind_pose.set(i, nodes[i].transformation);
+	}
+	channels = bind(clip);
+	find_animated();
+}
+
+std::vector<int> Skeleton::bind(const AnimationClip &clip) const
+{
+	std::vector<int> channels(nodes.size());
+	for (int i = 0; i < nodes.size(); i++) {
+		channels[i] = clip.find_channel(node_names[i]);
+	}
+	return channels;
+}
+
+void Skeleton::find_animated()
+{
+	animated.assign(nodes.size(), false);
+	for (int i = 0; i < nodes.size(); i++) {
+		animated[i] = channels[i] != -1;
+		for (const AnimationLayer &layer : layers) {
+			animated[i] = animated[i] || layer.channels[i] != -1;
+		}
+	}
 }
 
 void Skeleton::read_bones(const aiMesh *mesh)
@@ -115,191 +187,143 @@ void Skeleton::read_bones(const aiMesh *mesh)
 		bones[i].name = boneName;
 		bones[i].offsetMatrix = from_aiMatrix4x4(bone->mOffsetMatrix);
 	}
-}
 
-void Skeleton::update_bone_transform(float time, const aiNode *node,
-				     const Matrix4f &parentTransform)
-{
-	std::string nodeName(node->mName.data);
-	Matrix4f nodeTransformation = from_aiMatrix4x4(node->mTransformation);
-
-	const aiAnimation *animation =
-		scene->mAnimations[0]; // Assume first animation
-
-	// Retrieve the bone's transformation based on the animation data
-	const aiNodeAnim *nodeAnim = nullptr;
-	for (unsigned int i = 0; i < animation->mNumChannels; i++) {
-		if (std::string(animation->mChannels[i]->mNodeName.data) ==
-		    nodeName) {
-			nodeAnim = animation->mChannels[i];
-			break;
-		}
+	for (int i = 0; i < nodes.size(); i++) {
+		auto it = boneMapping.find(node_names[i]);
+		nodes[i].bone = it != boneMapping.end() ? it->second : -1;
 	}
+}
 
-	if (nodeAnim) {
-		// Interpolate scaling
-		aiVector3D scaling;
-		aiQuaternion rotation;
-		aiVector3D translation;
-
-		// Compute transformations (implement Interpolate functions)
-		translation = InterpolatePosition(time, nodeAnim);
-		rotation = InterpolateRotation(time, nodeAnim);
-		scaling = InterpolateScaling(time, nodeAnim);
-
-		Matrix4f scalingMatrix =
-			Matrix4f::Scale_Matrix(scaling.x, scaling.y, scaling.z);
-		Matrix4f rotationMatrix = Quaternion(rotation.x, rotation.w,
-						     rotation.z, rotation.w)
-						  .to_rotation_matrix();
-		Matrix4f translationMatrix = Matrix4f::Translation_Matrix(
-			translation.x, translation.y, translation.z);
-
-		nodeTransformation =
-			translationMatrix * rotationMatrix * scalingMatrix;
-	}
+void Skeleton::set_clip(const AnimationClip &clip)
+{
+	this->clip = clip;
+	channels = bind(clip);
+	find_animated();
+}
 
-	Matrix4f globalTransformation = parentTransform * nodeTransformation;
+const AnimationClip &Skeleton::get_clip() const noexcept
+{
+	return clip;
+}
 
-	if (boneMapping.find(nodeName) != boneMapping.end()) {
-		int boneIndex = boneMapping[nodeName];
-		bones[boneIndex].finalTransformation =
-			globalInverseTransform * globalTransformation *
-			bones[boneIndex].offsetMatrix;
+int Skeleton::add_layer(const AnimationClip &clip, float weight,
+			bool additive, std::vector<float> mask)
+{
+	if (!mask.empty() && mask.size() < nodes.size()) {
+		std::cerr << "Error: Layer mask covers " << mask.size()
+			  << " of " << nodes.size() << " nodes\n";
+		throw std::runtime_error("Layer mask too small");
+	}
+	if (!mask.empty()) {
+		mask.resize(Pose::get_stride(nodes.size()), 0);
 	}
 
-	for (unsigned int i = 0; i < node->mNumChildren; i++) {
-		update_bone_transform(time, node->mChildren[i],
-				      globalTransformation);
+	AnimationLayer layer{ clip, bind(clip), weight, additive,
+			      std::move(mask), Pose{} };
+	if (additive) {
+		sample(layer.clip, layer.channels, 0, layer.reference);
 	}
+	layers.push_back(std::move(layer));
+	find_animated();
+	return layers.size() - 1;
 }
 
-int FindPositionKey(float time, const aiNodeAnim *nodeAnim)
+void Skeleton::set_layer_weight(int layer, float weight)
 {
-	for (int i = 0; i < nodeAnim->mNumPositionKeys - 1; ++i) {
-		if (time < nodeAnim->mPositionKeys[i + 1].mTime) {
-			return i;
-		}
-	}
-	return 0;
+	layers.at(layer).weight = weight;
 }
 
-int FindRotationKey(float time, const aiNodeAnim *nodeAnim)
+void Skeleton::clear_layers()
 {
-	for (int i = 0; i < nodeAnim->mNumRotationKeys - 1; ++i) {
-		if (time < nodeAnim->mRotationKeys[i + 1].mTime) {
-			return i;
-		}
-	}
-	return 0;
+	layers.clear();
+	find_animated();
 }
 
-int FindScalingKey(float time, const aiNodeAnim *nodeAnim)
+std::vector<float> Skeleton::make_mask(const std::string &node_name) const
 {
-	for (int i = 0; i < nodeAnim->mNumScalingKeys - 1; ++i) {
-		if (time < nodeAnim->mScalingKeys[i + 1].mTime) {
-			return i;
+	std::vector<float> mask(Pose::get_stride(nodes.size()), 0);
+	for (int i = 0; i < nodes.size(); i++) {
+		// Parents come first, so their flag is already set
+		int parent = nodes[i].parent;
+		if (node_names[i] == node_name ||
+		    (parent != -1 && mask[parent] > 0)) {
+			mask[i] = 1;
 		}
 	}
-	return 0;
+	return mask;
 }
 
-float InterpolateValue(float a, float b, float factor)
+void Skeleton::sample(const AnimationClip &clip,
+		      const std::vector<int> &channels, float time, Pose &pose)
 {
-	return a + (b - a) * factor;
-}
+	clip.sample(time, translations, rotations, scales);
 
-aiVector3D Skeleton::InterpolatePosition(float time, const aiNodeAnim *nodeAnim)
-{
-	if (nodeAnim->mNumPositionKeys == 1) {
-		return nodeAnim->mPositionKeys[0].mValue;
+	pose = bind_pose;
+	float *components[Pose::COMPONENTS];
+	for (int c = 0; c < Pose::COMPONENTS; c++) {
+		components[c] = pose.get(Pose::Component(c));
+	}
+	for (int i = 0; i < nodes.size(); i++) {
+		int channel = channels[i];
+		if (channel == -1)
+			continue;
+
+		for (int c = 0; c < 3; c++) {
+			components[Pose::TX + c][i] =
+				translations[channel * 3 + c];
+			components[Pose::SX + c][i] = scales[channel * 3 + c];
+		}
+		for (int c = 0; c < 4; c++) {
+			components[Pose::RX + c][i] =
+				rotations[channel * 4 + c];
+		}
 	}
-
-	// Find position keyframes surrounding the current time
-	int positionIndex = FindPositionKey(time, nodeAnim);
-	int nextPositionIndex =
-		(positionIndex + 1) % nodeAnim->mNumPositionKeys;
-
-	// Get the position keys
-	const aiVectorKey &positionKey = nodeAnim->mPositionKeys[positionIndex];
-	const aiVectorKey &nextPositionKey =
-		nodeAnim->mPositionKeys[nextPositionIndex];
-
-	// Calculate interpolation factor
-	float deltaTime = nextPositionKey.mTime - positionKey.mTime;
-	float factor = (time - positionKey.mTime) / deltaTime;
-
-	// Interpolate position
-	aiVector3D interpolatedPosition;
-	interpolatedPosition.x = InterpolateValue(
-		positionKey.mValue.x, nextPositionKey.mValue.x, factor);
-	interpolatedPosition.y = InterpolateValue(
-		positionKey.mValue.y, nextPositionKey.mValue.y, factor);
-	interpolatedPosition.z = InterpolateValue(
-		positionKey.mValue.z, nextPositionKey.mValue.z, factor);
-
-	return interpolatedPosition;
 }
 
-aiQuaternion Skeleton::InterpolateRotation(float time,
-					   const aiNodeAnim *nodeAnim)
+void Skeleton::update_bone_transforms(float time)
 {
-	if (nodeAnim->mNumRotationKeys == 1) {
-		return nodeAnim->mRotationKeys[0].mValue;
+	sample(clip, channels, time, pose);
+
+	// Every layer is blended before the one pass over the hierarchy
+	for (const AnimationLayer &layer : layers) {
+		if (layer.weight <= 0)
+			continue;
+
+		sample(layer.clip, layer.channels, time, layer_pose);
+		const std::vector<float> *mask =
+			layer.mask.empty() ? nullptr : &layer.mask;
+		if (layer.additive) {
+			pose.add(layer_pose, layer.reference, layer.weight,
+				 mask);
+		} else {
+			pose.blend(layer_pose, layer.weight, mask);
+		}
 	}
 
-	// Find rotation keyframes surrounding the current time
-	int rotationIndex = FindRotationKey(time, nodeAnim);
-	int nextRotationIndex =
-		(rotationIndex + 1) % nodeAnim->mNumRotationKeys;
-
-	// Get the rotation keys
-	const aiQuatKey &rotationKey = nodeAnim->mRotationKeys[rotationIndex];
-	const aiQuatKey &nextRotationKey =
-		nodeAnim->mRotationKeys[nextRotationIndex];
-
-	// Calculate interpolation factor
-	float deltaTime = nextRotationKey.mTime - rotationKey.mTime;
-	float factor = (time - rotationKey.mTime) / deltaTime;
-
-	// Interpolate rotation using spherical linear interpolation (slerp)
-	aiQuaternion interpolatedRotation;
-	aiQuaternion::Interpolate(interpolatedRotation, rotationKey.mValue,
-				  nextRotationKey.mValue, factor);
-
-	// Normalize interpolated quaternion
-	interpolatedRotation.Normalize();
+	for (int i = 0; i < nodes.size(); i++) {
+		const SkeletonNode &node = nodes[i];
+		// Bind transforms are used as is, they may not split into TRS
+		Matrix4f nodeTransformation =
+			animated[i] ? pose.get_transform(i) :
+				      node.transformation;
+
+		if (node.parent == -1) {
+			global_transforms[i] = nodeTransformation;
+		} else {
+			global_transforms[i] =
+				global_transforms[node.parent] *
+				nodeTransformation;
+		}
 
-	return interpolatedRotation;
+		if (node.bone != -1) {
+			bones[node.bone].finalTransformation =
+				globalInverseTransform * global_transforms[i] *
+				bones[node.bone].offsetMatrix;
+		}
+	}
 }
 
-aiVector3D Skeleton::InterpolateScaling(float time, const aiNodeAnim *nodeAnim)
+const std::vector<SkeletonNode> &Skeleton::get_nodes() const noexcept
 {
-	if (nodeAnim->mNumScalingKeys == 1) {
-		return nodeAnim->mScalingKeys[0].mValue;
-	}
-
-	// Find scaling keyframes surrounding the current time
-	int scalingIndex = FindScalingKey(time, nodeAnim);
-	int nextScalingIndex = (scalingIndex + 1) % nodeAnim->mNumScalingKeys;
-
-	// Get the scaling keys
-	const aiVectorKey &scalingKey = nodeAnim->mScalingKeys[scalingIndex];
-	const aiVectorKey &nextScalingKey =
-		nodeAnim->mScalingKeys[nextScalingIndex];
-
-	// Calculate interpolation factor
-	float deltaTime = nextScalingKey.mTime - scalingKey.mTime;
-	float factor = (time - scalingKey.mTime) / deltaTime;
-
-	// Interpolate scaling
-	aiVector3D interpolatedScaling;
-	interpolatedScaling.x = InterpolateValue(
-		scalingKey.mValue.x, nextScalingKey.mValue.x, factor);
-	interpolatedScaling.y = InterpolateValue(
-		scalingKey.mValue.y, nextScalingKey.mValue.y, factor);
-	interpolatedScaling.z = InterpolateValue(
-		scalingKey.mValue.z, nextScalingKey.mValue.z, factor);
-
-	return interpolatedScaling;
+	return nodes;
 }
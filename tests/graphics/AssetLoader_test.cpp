@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include <graphics/AssetLoader.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <stdexcept>
+
+// Updates until every load is through, errors are counted not thrown
+static int drain(AssetLoader &loader)
+{
+	int errors = 0;
+	auto deadline = std::chrono::steady_clock::now() +
+			std::chrono::seconds(10);
+	while (loader.get_pending_count() > 0 &&
+	       std::chrono::steady_clock::now() < deadline) {
+		try {
+			loader.update();
+		} catch (const std::runtime_error &) {
+			errors++;
+		}
+		std::this_thread::yield();
+	}
+	return errors;
+}
+
+TEST(AssetLoaderTest, DecodesOnWorkersAndFinishesOnUpdate)
+{
+	AssetLoader &loader = AssetLoader::get_instance();
+	loader.set_thread_count(2);
+
+	std::thread::id main = std::this_thread::get_id();
+	std::atomic<int> off_thread{ 0 };
+	int ready = 0;
+	bool ready_on_main = true;
+	for (int i = 0; i < 16; i++) {
+		loader.load(
+			[&] {
+				if (std::this_thread::get_id() != main) {
+					off_thread++;
+				}
+			},
+			[&] {
+				ready++;
+				ready_on_main = ready_on_main &&
+						std::this_thread::get_id() ==
+							main;
+			});
+	}
+
+	EXPECT_EQ(drain(loader), 0);
+	EXPECT_EQ(off_thread, 16);
+	EXPECT_EQ(ready, 16);
+	EXPECT_TRUE(ready_on_main);
+	EXPECT_EQ(loader.get_uploaded_bytes(), 0);
+}
+
+TEST(AssetLoaderTest, RethrowsFailedLoadsFromUpdate)
+{
+	AssetLoader &loader = AssetLoader::get_instance();
+	loader.set_thread_count(1);
+
+	int ready = 0;
+	int failed = 0;
+	loader.load([] { throw std::runtime_error("Missing file"); },
+		    [&] { ready += 100; }, [&] { failed++; });
+	loader.load([] {}, [&] { ready++; }, [&] { failed += 100; });
+
+	EXPECT_EQ(drain(loader), 1);
+	EXPECT_EQ(ready, 1);
+	EXPECT_EQ(failed, 1);
+}
+
+TEST(AssetLoaderTest, DecodesInUpdateWithoutWorkers)
+{
+	AssetLoader &loader = AssetLoader::get_instance();
+	loader.set_thread_count(0);
+	EXPECT_EQ(loader.get_thread_count(), 0);
+
+	int ready = 0;
+	loader.load([] {}, [&] { ready++; });
+	loader.load([] {}, [&] { ready++; });
+	EXPECT_EQ(loader.get_pending_count(), 2);
+
+	// One decode per frame
+	loader.update();
+	EXPECT_EQ(ready, 1);
+	loader.update();
+	EXPECT_EQ(ready, 2);
+	EXPECT_EQ(loader.get_pending_count(), 0);
+}
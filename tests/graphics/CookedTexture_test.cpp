@@ -0,0 +1,220 @@
+#include <gtest/gtest.h>
+#include <graphics/CookedTexture.h>
+
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <vector>
+
+static unsigned read_le(const unsigned char *in, int bytes)
+{
+	unsigned value = 0;
+	for (int i = 0; i < bytes; i++) {
+		value |= in[i] << (8 * i);
+	}
+	return value;
+}
+
+// Reference decoders for the 4x4 blocks, texels in row order
+static void decode_bc4(const unsigned char *block, int values[16])
+{
+	int e0 = block[0], e1 = block[1];
+	int palette[8] = { e0, e1 };
+	for (int i = 2; i < 8; i++) {
+		palette[i] = e0 > e1 ? ((8 - i) * e0 + (i - 1) * e1) / 7 :
+			     i < 6   ? ((6 - i) * e0 + (i - 1) * e1) / 5 :
+			     i == 6  ? 0 :
+				       255;
+	}
+	unsigned long long indices = 0;
+	for (int i = 0; i < 6; i++) {
+		indices |= static_cast<unsigned long long>(block[2 + i])
+			   << (8 * i);
+	}
+	for (int i = 0; i < 16; i++) {
+		values[i] = palette[(indices >> (3 * i)) & 7];
+	}
+}
+
+static void decode_bc1(const unsigned char *block, int rgb[16][3])
+{
+	unsigned colors[2] = { read_le(block, 2), read_le(block + 2, 2) };
+	int palette[4][3];
+	for (int e = 0; e < 2; e++) {
+		int r = colors[e] >> 11, g = (colors[e] >> 5) & 63,
+		    b = colors[e] & 31;
+		palette[e][0] = r << 3 | r >> 2;
+		palette[e][1] = g << 2 | g >> 4;
+		palette[e][2] = b << 3 | b >> 2;
+	}
+	for (int c = 0; c < 3; c++) {
+		if (colors[0] > colors[1]) {
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		} else {
+			palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+			palette[3][c] = 0;
+		}
+	}
+	unsigned indices = read_le(block + 4, 4);
+	for (int i = 0; i < 16; i++) {
+		for (int c = 0; c < 3; c++) {
+			rgb[i][c] = palette[(indices >> (2 * i)) & 3][c];
+		}
+	}
+}
+
+TEST(CookedTextureTest, BuildsTheFullMipChain)
+{
+	std::vector<unsigned char> pixels(8 * 4 * 3, 200);
+	CookedTexture texture = CookedTexture::cook(pixels.data(), 8, 4, 3);
+
+	EXPECT_EQ(texture.get_format(), CookedTexture::Format::BC1);
+	ASSERT_EQ(texture.get_level_count(), 4);
+	int widths[] = { 8, 4, 2, 1 };
+	int heights[] = { 4, 2, 1, 1 };
+	for (int i = 0; i < 4; i++) {
+		EXPECT_EQ(texture.get_level_width(i), widths[i]);
+		EXPECT_EQ(texture.get_level_height(i), heights[i]);
+		EXPECT_EQ(texture.get_level(i).size(),
+			  texture.get_level_size(i));
+	}
+	// Two blocks, then a single (partly repeated) block per level
+	EXPECT_EQ(texture.get_level(0).size(), 16u);
+	EXPECT_EQ(texture.get_level(3).size(), 8u);
+}
+
+TEST(CookedTextureTest, PicksTheFormatFromTheChannels)
+{
+	std::vector<unsigned char> pixels(4 * 4 * 4, 255);
+	EXPECT_EQ(CookedTexture::cook(pixels.data(), 4, 4, 1).get_format(),
+		  CookedTexture::Format::BC4);
+	EXPECT_EQ(CookedTexture::cook(pixels.data(), 4, 4, 2).get_format(),
+		  CookedTexture::Format::BC5);
+	EXPECT_EQ(CookedTexture::cook(pixels.data(), 4, 4, 4).get_format(),
+		  CookedTexture::Format::BC1);
+
+	pixels[7] = 128;
+	CookedTexture translucent = CookedTexture::cook(pixels.data(), 4, 4, 4);
+	EXPECT_EQ(translucent.get_format(), CookedTexture::Format::BC3);
+	EXPECT_EQ(translucent.get_internal_format(),
+		  static_cast<GLenum>(GL_COMPRESSED_RGBA_S3TC_DXT5_EXT));
+
+	std::vector<std::uint16_t> halves(4 * 4 * 4, 0x3C00);
+	CookedTexture hdr = CookedTexture::cook_hdr(halves.data(), 4, 4);
+	EXPECT_EQ(hdr.get_format(), CookedTexture::Format::RGBA16F);
+	EXPECT_FALSE(hdr.is_compressed());
+	EXPECT_EQ(hdr.get_level(0).size(), 4u * 4 * 8);
+	// 1.0 stays 1.0 all the way down
+	EXPECT_EQ(hdr.get_level(2)[0], 0x00);
+	EXPECT_EQ(hdr.get_level(2)[1], 0x3C);
+}
+
+TEST(CookedTextureTest, BlocksDecodeCloseToTheSource)
+{
+	std::vector<unsigned char> gradient(16), colors(16 * 3);
+	for (int i = 0; i < 16; i++) {
+		gradient[i] = 10 + i * 13;
+		colors[i * 3] = 40 + i * 8;
+		colors[i * 3 + 1] = 200 - i * 6;
+		colors[i * 3 + 2] = 90;
+	}
+
+	CookedTexture bc4 = CookedTexture::cook(gradient.data(), 4, 4, 1);
+	int values[16];
+	decode_bc4(bc4.get_level(0).data(), values);
+	// Within half a step of the eight value palette
+	for (int i = 0; i < 16; i++) {
+		EXPECT_NEAR(values[i], gradient[i], (205 - 10) / 14 + 1);
+	}
+
+	CookedTexture bc1 = CookedTexture::cook(colors.data(), 4, 4, 3);
+	int rgb[16][3];
+	decode_bc1(bc1.get_level(0).data(), rgb);
+	for (int i = 0; i < 16; i++) {
+		for (int c = 0; c < 3; c++) {
+			EXPECT_NEAR(rgb[i][c], colors[i * 3 + c], 16);
+		}
+	}
+}
+
+TEST(CookedTextureTest, FiltersColourInLinearLight)
+{
+	// A black and white checker averages to 188 in sRGB, not 128
+	unsigned char checker[] = { 0, 0, 0, 255, 255, 255,
+				    255, 255, 255, 0, 0, 0 };
+	CookedTexture colour = CookedTexture::cook(checker, 2, 2, 3);
+	ASSERT_EQ(colour.get_level_count(), 2);
+	int rgb[16][3];
+	decode_bc1(colour.get_level(1).data(), rgb);
+	for (int c = 0; c < 3; c++) {
+		EXPECT_NEAR(rgb[0][c], 188, 4);
+	}
+
+	// Data channels are averaged as they are
+	unsigned char data[] = { 0, 255, 255, 0 };
+	CookedTexture single = CookedTexture::cook(data, 2, 2, 1);
+	int values[16];
+	decode_bc4(single.get_level(1).data(), values);
+	EXPECT_NEAR(values[0], 128, 1);
+}
+
+TEST(CookedTextureTest, SavesAndLoads)
+{
+	std::vector<unsigned char> pixels(5 * 3 * 2);
+	for (std::size_t i = 0; i < pixels.size(); i++) {
+		pixels[i] = std::rand() % 256;
+	}
+	CookedTexture texture = CookedTexture::cook(pixels.data(), 5, 3, 2);
+
+	std::string path = testing::TempDir() + "texture.getc";
+	ASSERT_TRUE(texture.save(path));
+
+	CookedTexture loaded;
+	ASSERT_TRUE(loaded.load(path));
+	EXPECT_EQ(loaded.get_format(), CookedTexture::Format::BC5);
+	EXPECT_EQ(loaded.get_width(), 5);
+	EXPECT_EQ(loaded.get_height(), 3);
+	ASSERT_EQ(loaded.get_level_count(), texture.get_level_count());
+	for (int i = 0; i < loaded.get_level_count(); i++) {
+		EXPECT_EQ(loaded.get_level(i), texture.get_level(i));
+	}
+
+	// Anything else leaves the texture as it was
+	{
+		std::ofstream file(path, std::ios::binary);
+		file << "GEAC not a texture";
+	}
+	EXPECT_FALSE(loaded.load(path));
+	EXPECT_FALSE(loaded.load(path + ".missing"));
+	EXPECT_EQ(loaded.get_width(), 5);
+	std::remove(path.c_str());
+}
+
+TEST(CookedTextureTest, RejectsMoreLevelsThanTheSizeHas)
+{
+	std::vector<unsigned char> pixels(5 * 3 * 2, 64);
+	CookedTexture texture = CookedTexture::cook(pixels.data(), 5, 3, 2);
+	ASSERT_EQ(texture.get_level_count(), 3);
+
+	std::string path = testing::TempDir() + "levels.getc";
+	ASSERT_TRUE(texture.save(path));
+
+	// One more 1x1 level, present in the file but not in the chain
+	{
+		std::fstream file(path, std::ios::binary | std::ios::in |
+						std::ios::out);
+		std::uint32_t levels = 4;
+		file.seekp(4 + 4 + 3 * sizeof(levels));
+		file.write(reinterpret_cast<const char *>(&levels),
+			   sizeof(levels));
+		file.seekp(0, std::ios::end);
+		std::vector<char> block(texture.get_level_size(2));
+		file.write(block.data(), block.size());
+	}
+
+	CookedTexture loaded;
+	EXPECT_FALSE(loaded.load(path));
+	std::remove(path.c_str());
+}
@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+#include <graphics/DynamicResolution.h>
+
+class DynamicResolutionTest : public ::testing::Test {
+    protected:
+	static constexpr double TARGET = 1.0 / 60.0;
+
+	DynamicResolution &controller = DynamicResolution::get_instance();
+
+	void SetUp() override
+	{
+		controller.set_bounds(0.5f, 1.0f);
+		controller.set_target_frame_time(TARGET);
+	}
+
+	void feed(double frame_time, int frames)
+	{
+		for (int i = 0; i < frames; i++) {
+			controller.report_frame_time(frame_time);
+		}
+	}
+};
+
+TEST_F(DynamicResolutionTest, OverBudgetLowersScale)
+{
+	feed(TARGET * 0.1, 200);
+	float before = controller.get_scale();
+	feed(TARGET * 1.5, 20);
+	EXPECT_LT(controller.get_scale(), before);
+}
+
+TEST_F(DynamicResolutionTest, ScaleStaysWithinBounds)
+{
+	feed(TARGET * 10, 500);
+	EXPECT_FLOAT_EQ(controller.get_scale(), 0.5f);
+
+	feed(TARGET * 0.1, 1000);
+	EXPECT_FLOAT_EQ(controller.get_scale(), 1.0f);
+}
+
+TEST_F(DynamicResolutionTest, OnBudgetHoldsScale)
+{
+	feed(TARGET * 10, 500);
+	feed(TARGET, 200);
+	float settled = controller.get_scale();
+	feed(TARGET, 200);
+	EXPECT_FLOAT_EQ(controller.get_scale(), settled);
+}
+
+TEST_F(DynamicResolutionTest, BoundsClampScale)
+{
+	feed(TARGET * 0.1, 1000);
+	controller.set_bounds(0.25f, 0.75f);
+	EXPECT_FLOAT_EQ(controller.get_scale(), 0.75f);
+}
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include <graphics/FrameGraph.h>
+
+#include <exception>
+
+class FrameGraphTest : public ::testing::Test {
+    protected:
+	FrameGraph graph;
+	FrameGraph::TextureDesc color_desc{ GL_RGBA8, 64, 64 };
+	FrameGraph::TextureDesc depth_desc{ GL_DEPTH24_STENCIL8, 64, 64 };
+	FrameGraph::Handle backbuffer;
+
+	void SetUp() override
+	{
+		backbuffer = graph.import_target("backbuffer", 0, 64, 64);
+	}
+};
+
+TEST_F(FrameGraphTest, CullsPassesWithUnusedOutputs)
+{
+	FrameGraph::Handle scene = graph.create_texture("scene", color_desc);
+	FrameGraph::Handle unused =
+		graph.create_texture("unused", color_desc);
+
+	graph.add_pass("scene", [] {}).write(scene).clear();
+	graph.add_pass("unused", [] {}).write(unused).clear();
+	graph.add_pass("present", [] {}).read(scene).write(backbuffer);
+	graph.compile();
+
+	EXPECT_FALSE(graph.is_culled("scene"));
+	EXPECT_TRUE(graph.is_culled("unused"));
+	EXPECT_FALSE(graph.is_culled("present"));
+	EXPECT_EQ(graph.get_live_pass_count(), 2);
+}
+
+TEST_F(FrameGraphTest, ClearCullsEarlierWriters)
+{
+	FrameGraph::Handle scene = graph.create_texture("scene", color_desc);
+
+	graph.add_pass("overwritten", [] {}).write(scene).clear();
+	graph.add_pass("scene", [] {}).write(scene).clear();
+	graph.add_pass("blend", [] {}).write(scene);
+	graph.add_pass("present", [] {}).read(scene).write(backbuffer);
+	graph.compile();
+
+	EXPECT_TRUE(graph.is_culled("overwritten"));
+	EXPECT_FALSE(graph.is_culled("scene"));
+	EXPECT_FALSE(graph.is_culled("blend"));
+}
+
+TEST_F(FrameGraphTest, AliasesDisjointLifetimes)
+{
+	FrameGraph::Handle first = graph.create_texture("first", color_desc);
+	FrameGraph::Handle second =
+		graph.create_texture("second", color_desc);
+	FrameGraph::Handle third = graph.create_texture("third", color_desc);
+
+	// first dies when second is written, so third can take its slot
+	graph.add_pass("a", [] {}).write(first).clear();
+	graph.add_pass("b", [] {}).read(first).write(second).clear();
+	graph.add_pass("c", [] {}).read(second).write(third).clear();
+	graph.add_pass("present", [] {}).read(third).write(backbuffer);
+	graph.compile();
+
+	EXPECT_EQ(graph.get_slot_count(), 2);
+}
+
+TEST_F(FrameGraphTest, KeepsFormatsApart)
+{
+	FrameGraph::Handle color = graph.create_texture("color", color_desc);
+	FrameGraph::Handle depth = graph.create_texture("depth", depth_desc);
+
+	graph.add_pass("scene", [] {}).write(color).write(depth).clear();
+	graph.add_pass("present", [] {}).read(color).write(backbuffer);
+	graph.compile();
+
+	EXPECT_EQ(graph.get_slot_count(), 2);
+}
+
+TEST_F(FrameGraphTest, ReadBeforeWriteThrows)
+{
+	FrameGraph::Handle scene = graph.create_texture("scene", color_desc);
+
+	graph.add_pass("present", [] {}).read(scene).write(backbuffer);
+	EXPECT_THROW(graph.compile(), std::runtime_error);
+}
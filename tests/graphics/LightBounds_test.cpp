@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include <graphics/LightBounds.h>
+#include <graphics/LightStorage.h>
+#include <components/DirectionalLight.h>
+#include <components/PointLight.h>
+#include <math/Transform.h>
+#include <math/Matrix4f.h>
+#include <math/Vector3f.h>
+
+#include <cmath>
+
+// Camera at the origin looking down +z
+static Matrix4f projection()
+{
+	return Matrix4f::Perspective_Matrix(std::acos(0.0f), 1.0f, 0.1f,
+					    100.0f);
+}
+
+TEST(LightBoundsTest, SphereInFrontIsScissored)
+{
+	LightBounds::Rect rect = LightBounds::project_sphere(
+		Vector3f(0, 0, 10), 1.0f, projection(), 800, 800);
+
+	EXPECT_FALSE(rect.empty);
+	EXPECT_FALSE(rect.full);
+	EXPECT_GT(rect.x, 0);
+	EXPECT_GT(rect.y, 0);
+	EXPECT_LT(rect.x + rect.width, 800);
+	EXPECT_LT(rect.y + rect.height, 800);
+	EXPECT_NEAR(rect.x + rect.width / 2.0f, 400.0f, 1.0f);
+	EXPECT_NEAR(rect.y + rect.height / 2.0f, 400.0f, 1.0f);
+	EXPECT_GT(rect.min_depth, 0.0f);
+	EXPECT_LT(rect.min_depth, rect.max_depth);
+	EXPECT_LE(rect.max_depth, 1.0f);
+}
+
+TEST(LightBoundsTest, SphereAroundCameraCoversScreen)
+{
+	LightBounds::Rect rect = LightBounds::project_sphere(
+		Vector3f(0, 0, 1), 5.0f, projection(), 800, 600);
+
+	EXPECT_TRUE(rect.full);
+	EXPECT_EQ(rect.width, 800);
+	EXPECT_EQ(rect.height, 600);
+}
+
+TEST(LightBoundsTest, SphereOutsideFrustumIsEmpty)
+{
+	EXPECT_TRUE(LightBounds::project_sphere(Vector3f(0, 0, -10), 1.0f,
+						projection(), 800, 600)
+			    .empty);
+	EXPECT_TRUE(LightBounds::project_sphere(Vector3f(50, 0, 10), 1.0f,
+						projection(), 800, 600)
+			    .empty);
+}
+
+TEST(LightBoundsTest, SpotSphereContainsCone)
+{
+	Vector3f position(1, 2, 3);
+	Vector3f direction(0, 0, 1);
+	for (float cutoff : { 0.95f, 0.7f, 0.3f }) {
+		Vector3f center;
+		float radius;
+		LightBounds::spot_sphere(position, direction, 10.0f, cutoff,
+					 center, radius);
+
+		float sine = std::sqrt(1.0f - cutoff * cutoff);
+		Vector3f tip = position + direction * 10.0f;
+		Vector3f rim = position + Vector3f(sine, 0, cutoff) * 10.0f;
+		EXPECT_LE((center - position).length(), radius + 1e-4f);
+		EXPECT_LE((center - tip).length(), radius + 1e-4f);
+		EXPECT_LE((center - rim).length(), radius + 1e-4f);
+		EXPECT_LE(radius, 10.0f);
+	}
+}
+
+TEST(LightBoundsTest, MergeCoversBoth)
+{
+	LightBounds::Rect a{ 10, 20, 30, 40, 0.2f, 0.4f, false, false };
+	LightBounds::Rect b{ 50, 0, 10, 10, 0.3f, 0.6f, false, false };
+	LightBounds::Rect merged = LightBounds::merge(a, b);
+
+	EXPECT_EQ(merged.x, 10);
+	EXPECT_EQ(merged.y, 0);
+	EXPECT_EQ(merged.width, 50);
+	EXPECT_EQ(merged.height, 60);
+	EXPECT_FLOAT_EQ(merged.min_depth, 0.2f);
+	EXPECT_FLOAT_EQ(merged.max_depth, 0.6f);
+
+	LightBounds::Rect empty = LightBounds::empty_rect();
+	EXPECT_EQ(LightBounds::merge(empty, b).x, 50);
+	EXPECT_TRUE(LightBounds::merge(empty, empty).empty);
+}
+
+TEST(LightBoundsTest, GroupWithDirectionalCoversScreen)
+{
+	LightStorage &storage = LightStorage::get_instance();
+	storage.clear();
+
+	Transform transform;
+	DirectionalLight directional(Vector3f(1, 1, 1), 0.5f);
+	PointLight near_point(Vector3f(1, 0, 0), 1.0f, { 0, 0, 1 });
+	PointLight far_point(Vector3f(1, 0, 0), 1.0f, { 0, 0, 1 });
+	directional.set_parent_transform(&transform);
+	static_cast<GameComponent &>(directional).add_to_rendering_engine();
+	for (PointLight *point : { &near_point, &far_point }) {
+		point->set_parent_transform(&transform);
+		static_cast<GameComponent &>(*point).add_to_rendering_engine();
+	}
+	storage.update();
+
+	EXPECT_TRUE(LightBounds::group_bounds(storage, 0, 1, projection(),
+					      800, 600)
+			    .full);
+	// Point lights past the end of the group are ignored
+	EXPECT_TRUE(LightBounds::group_bounds(storage, 2, 1, projection(),
+					      800, 600)
+			    .empty);
+
+	storage.clear();
+}
@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+#include <graphics/LightStorage.h>
+#include <components/DirectionalLight.h>
+#include <components/PointLight.h>
+#include <components/SpotLight.h>
+#include <math/Transform.h>
+#include <math/Vector3f.h>
+
+class LightStorageTest : public ::testing::Test {
+    protected:
+	LightStorage &storage = LightStorage::get_instance();
+	Transform transform;
+
+	void SetUp() override
+	{
+		storage.clear();
+	}
+
+	void TearDown() override
+	{
+		storage.clear();
+	}
+};
+
+TEST_F(LightStorageTest, SplitsLightsByType)
+{
+	DirectionalLight directional(Vector3f(1, 1, 1), 0.5f);
+	PointLight point(Vector3f(1, 0, 0), 1.0f, { 0, 0, 1 });
+	SpotLight spot(Vector3f(0, 1, 0), 1.0f, { 0, 0, 1 }, 0.7f);
+	for (GameComponent *light : { (GameComponent *)&directional,
+				       (GameComponent *)&point,
+				       (GameComponent *)&spot }) {
+		light->set_parent_transform(&transform);
+		light->add_to_rendering_engine();
+	}
+
+	EXPECT_EQ(storage.get_directional().sources.size(), 1);
+	EXPECT_EQ(storage.get_point().sources.size(), 1);
+	EXPECT_EQ(storage.get_spot().sources.size(), 1);
+	EXPECT_EQ(storage.size(), 3);
+}
+
+TEST_F(LightStorageTest, KeepsRegistrationOrder)
+{
+	PointLight first(Vector3f(1, 0, 0), 1.0f, { 0, 0, 1 });
+	PointLight second(Vector3f(0, 1, 0), 1.0f, { 0, 0, 1 });
+	first.set_parent_transform(&transform);
+	second.set_parent_transform(&transform);
+
+	// Registering twice keeps the first position
+	static_cast<GameComponent &>(second).add_to_rendering_engine();
+	static_cast<GameComponent &>(first).add_to_rendering_engine();
+	static_cast<GameComponent &>(second).add_to_rendering_engine();
+
+	ASSERT_EQ(storage.get_point().sources.size(), 2);
+	EXPECT_EQ(storage.get_point().sources[0], &second);
+	EXPECT_EQ(storage.get_point().sources[1], &first);
+}
+
+TEST_F(LightStorageTest, UpdateComputesWorldPositions)
+{
+	PointLight point(Vector3f(1, 1, 1), 2.0f, { 0, 0, 1 });
+	point.set_parent_transform(&transform);
+	static_cast<GameComponent &>(point).add_to_rendering_engine();
+
+	transform.set_translation(1, 2, 3);
+	storage.update();
+
+	const LightStorage::PointLights &lights = storage.get_point();
+	EXPECT_EQ(lights.position[0], Vector3f(1, 2, 3));
+	EXPECT_FLOAT_EQ(lights.intensity[0], 2.0f);
+	EXPECT_FLOAT_EQ(lights.range[0], point.range);
+}
@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+#include <graphics/Material.h>
+#include <graphics/MaterialTable.h>
+#include <math/Vector3f.h>
+
+#include <memory>
+
+class MaterialTest : public ::testing::Test {
+    protected:
+	std::shared_ptr<void> property = std::make_shared<int>(42);
+};
+
+TEST_F(MaterialTest, InternIsStable)
+{
+	Material::PropertyID normal = Material::intern("normal");
+	EXPECT_EQ(Material::intern("normal"), normal);
+	EXPECT_NE(Material::intern("roughness"), normal);
+}
+
+TEST_F(MaterialTest, TypedFieldsSetFlags)
+{
+	Material material;
+	EXPECT_EQ(material.get_data().flags, 0u);
+
+	material.set_ambient({ 1, 1, 1 }).set_specular({ 2, 32 });
+	const MaterialData &data = material.get_data();
+	EXPECT_TRUE(data.flags & MaterialData::HAS_AMBIENT);
+	EXPECT_FALSE(data.flags & MaterialData::HAS_DIFFUSE);
+	EXPECT_FLOAT_EQ(data.specular.intensity, 2);
+	EXPECT_FLOAT_EQ(data.specular.exponent, 32);
+	EXPECT_EQ(data.ambient, Vector3f(1, 1, 1));
+}
+
+TEST_F(MaterialTest, ExtrasByInternedId)
+{
+	Material material;
+	Material::PropertyID normal = Material::intern("normal");
+	Material::PropertyID height = Material::intern("height");
+
+	EXPECT_EQ(material.get_property(normal), nullptr);
+	material.add_property(height, property).add_property(normal, property);
+	EXPECT_EQ(material.get_property(normal), property.get());
+	EXPECT_EQ(material.get_property(height), property.get());
+
+	material.delete_property(normal);
+	EXPECT_EQ(material.get_property(normal), nullptr);
+	EXPECT_EQ(material.get_property(height), property.get());
+}
+
+TEST_F(MaterialTest, CopiesAreIndependent)
+{
+	Material material;
+	material.set_specular({ 1, 8 });
+
+	Material copy(material);
+	EXPECT_NE(copy.get_index(), material.get_index());
+	EXPECT_TRUE(copy == material);
+
+	copy.set_specular({ 4, 8 });
+	EXPECT_FALSE(copy == material);
+	EXPECT_FLOAT_EQ(material.get_data().specular.intensity, 1);
+}
+
+TEST_F(MaterialTest, SlotsAreReused)
+{
+	int index;
+	{
+		Material material;
+		index = material.get_index();
+	}
+	Material material;
+	EXPECT_EQ(material.get_index(), index);
+}
@@ -0,0 +1,232 @@
+#include <gtest/gtest.h>
+#include <graphics/MeshOptimizer.h>
+#include <graphics/Vertex.h>
+#include <math/Vector2f.h>
+#include <math/Vector3f.h>
+
+#include <set>
+#include <array>
+#include <utility>
+#include <vector>
+#include <algorithm>
+
+class MeshOptimizerTest : public ::testing::Test {
+    protected:
+	static constexpr int GRID = 32;
+
+	std::vector<Vertex> vertices;
+	std::vector<int> indices;
+
+	void SetUp() override
+	{
+		for (int y = 0; y <= GRID; y++) {
+			for (int x = 0; x <= GRID; x++) {
+				vertices.emplace_back(Vector3f(x, y, 0));
+			}
+		}
+
+		// Column-major triangle order thrashes a small vertex cache
+		for (int x = 0; x < GRID; x++) {
+			for (int y = 0; y < GRID; y++) {
+				int i = y * (GRID + 1) + x;
+				indices.insert(indices.end(),
+					       { i, i + 1, i + GRID + 1 });
+				indices.insert(indices.end(),
+					       { i + 1, i + GRID + 2,
+						 i + GRID + 1 });
+			}
+		}
+	}
+
+	void TearDown() override
+	{
+		// Code here will run after each test
+	}
+
+	// Splits the UVs along x = GRID / 2, the right half gets its own
+	// copies of the seam vertices. Returns the copies by row
+	std::vector<int> split_seam()
+	{
+		int seam_start = vertices.size();
+		std::vector<int> seam(GRID + 1);
+		for (int y = 0; y <= GRID; y++) {
+			seam[y] = vertices.size();
+			vertices.emplace_back(Vector3f(GRID / 2, y, 0),
+					      Vector2f(1, 0));
+		}
+		for (int t = 0; t < indices.size() / 3; t++) {
+			bool right = false;
+			for (int k = 0; k < 3; k++) {
+				right |= indices[t * 3 + k] % (GRID + 1) >
+					 GRID / 2;
+			}
+			for (int k = 0; right && k < 3; k++) {
+				int &index = indices[t * 3 + k];
+				if (index < seam_start &&
+				    index % (GRID + 1) == GRID / 2) {
+					index = seam[index / (GRID + 1)];
+				}
+			}
+		}
+		return seam;
+	}
+
+	// Rows of the seam used on its left and right side. Checks that no
+	// triangle crosses the seam, it stays where it was
+	std::pair<std::set<int>, std::set<int> >
+	seam_rows(const std::vector<int> &lod, const std::vector<int> &seam)
+	{
+		std::pair<std::set<int>, std::set<int> > rows;
+		for (int t = 0; t < lod.size() / 3; t++) {
+			bool left = false, right = false;
+			for (int k = 0; k < 3; k++) {
+				int index = lod[t * 3 + k];
+				float x = vertices[index].get_pos().getX();
+				left |= x < GRID / 2;
+				right |= x > GRID / 2 || index >= seam[0];
+				if (index >= seam[0]) {
+					rows.second.insert(index - seam[0]);
+				} else if (x == GRID / 2) {
+					rows.first.insert(index / (GRID + 1));
+				}
+			}
+			EXPECT_FALSE(left && right);
+		}
+		return rows;
+	}
+
+	// Triangles as sorted position triples, independent of order
+	static std::multiset<std::array<float, 9> >
+	triangles(const std::vector<Vertex> &vertices,
+		  const std::vector<int> &indices)
+	{
+		std::multiset<std::array<float, 9> > result;
+		for (int t = 0; t < indices.size() / 3; t++) {
+			std::array<std::array<float, 3>, 3> corners;
+			for (int k = 0; k < 3; k++) {
+				corners[k] =
+					vertices[indices[t * 3 + k]].get_pos().get();
+			}
+			std::rotate(corners.begin(),
+				    std::min_element(corners.begin(),
+						     corners.end()),
+				    corners.end());
+			std::array<float, 9> key;
+			for (int k = 0; k < 9; k++) {
+				key[k] = corners[k / 3][k % 3];
+			}
+			result.insert(key);
+		}
+		return result;
+	}
+};
+
+TEST_F(MeshOptimizerTest, VertexCacheLowersAcmr)
+{
+	float before = MeshOptimizer::compute_acmr(indices, vertices.size());
+	MeshOptimizer::optimize_vertex_cache(indices, vertices.size());
+	float after = MeshOptimizer::compute_acmr(indices, vertices.size());
+
+	EXPECT_LT(after, before);
+	EXPECT_LT(after, 0.8f);
+}
+
+TEST_F(MeshOptimizerTest, PipelinePreservesTriangles)
+{
+	auto expected = triangles(vertices, indices);
+
+	MeshOptimizer::optimize_vertex_cache(indices, vertices.size());
+	MeshOptimizer::optimize_overdraw(indices, vertices);
+	MeshOptimizer::optimize_vertex_fetch(vertices, indices);
+
+	EXPECT_EQ(triangles(vertices, indices), expected);
+}
+
+TEST_F(MeshOptimizerTest, VertexFetchOrdersByFirstUse)
+{
+	vertices.emplace_back(Vector3f(-1, -1, -1)); // Unreferenced
+	MeshOptimizer::optimize_vertex_cache(indices, vertices.size());
+	MeshOptimizer::optimize_vertex_fetch(vertices, indices);
+
+	EXPECT_EQ(vertices.size(), (GRID + 1) * (GRID + 1));
+
+	int next = 0;
+	for (int index : indices) {
+		EXPECT_LE(index, next);
+		next = std::max(next, index + 1);
+	}
+}
+
+TEST_F(MeshOptimizerTest, SimplifyFlatGridKeepsBorder)
+{
+	float error = -1.0f;
+	std::vector<int> simplified = MeshOptimizer::simplify(
+		indices, vertices, indices.size() / 2, 0.01f, &error);
+
+	EXPECT_LE(simplified.size(), indices.size() / 2);
+	EXPECT_GT(simplified.size(), 0);
+	EXPECT_FLOAT_EQ(error, 0.0f);
+
+	std::set<int> used(simplified.begin(), simplified.end());
+	for (int i = 0; i <= GRID; i++) {
+		EXPECT_TRUE(used.count(i)); // Bottom edge
+		EXPECT_TRUE(used.count(GRID * (GRID + 1) + i)); // Top edge
+		EXPECT_TRUE(used.count(i * (GRID + 1))); // Left edge
+	}
+}
+
+TEST_F(MeshOptimizerTest, SimplifyKeepsSeams)
+{
+	std::vector<int> seam = split_seam();
+	std::vector<int> simplified = MeshOptimizer::simplify(
+		indices, vertices, indices.size() / 4, 0.01f);
+	EXPECT_LE(simplified.size(), indices.size() / 4);
+
+	// Both sides keep the same seam vertices, so no crack opens, and
+	// its ends stay. In between it may thin out along its own line
+	auto [left, right] = seam_rows(simplified, seam);
+	EXPECT_EQ(left, right);
+	EXPECT_TRUE(left.count(0));
+	EXPECT_TRUE(left.count(GRID));
+	EXPECT_LT(left.size(), GRID + 1);
+}
+
+TEST_F(MeshOptimizerTest, GenerateLodsAcrossUvSeam)
+{
+	std::vector<int> seam = split_seam();
+	auto lods = MeshOptimizer::generate_lods(indices, vertices);
+	ASSERT_FALSE(lods.empty());
+
+	for (const std::vector<int> &lod : lods) {
+		auto [left, right] = seam_rows(lod, seam);
+		EXPECT_EQ(left, right);
+		EXPECT_TRUE(left.count(0));
+		EXPECT_TRUE(left.count(GRID));
+	}
+}
+
+TEST_F(MeshOptimizerTest, GenerateLodsOnUnweldedMesh)
+{
+	// One vertex per triangle corner, as an importer may write them
+	std::vector<Vertex> corners;
+	for (int &index : indices) {
+		corners.push_back(vertices[index]);
+		index = corners.size() - 1;
+	}
+
+	auto lods = MeshOptimizer::generate_lods(indices, corners);
+	ASSERT_FALSE(lods.empty());
+	EXPECT_LE(lods[0].size(), indices.size() * 4 / 5);
+}
+
+TEST_F(MeshOptimizerTest, GenerateLodsHalvesEachLevel)
+{
+	auto lods = MeshOptimizer::generate_lods(indices, vertices);
+	ASSERT_FALSE(lods.empty());
+
+	int previous = indices.size();
+	for (const std::vector<int> &lod : lods) {
+		EXPECT_LE(lod.size(), previous * 4 / 5);
+		previous = lod.size();
+	}
+}
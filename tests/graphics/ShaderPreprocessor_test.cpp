@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include <graphics/ShaderPreprocessor.h>
+
+#include <string>
+#include <fstream>
+#include <stdexcept>
+#include <filesystem>
+
+class ShaderPreprocessorTest : public ::testing::Test {
+    protected:
+	std::filesystem::path directory =
+		std::filesystem::temp_directory_path() /
+		"shader_preprocessor_test";
+
+	void SetUp() override
+	{
+		std::filesystem::create_directories(directory / "include");
+	}
+
+	void TearDown() override
+	{
+		std::filesystem::remove_all(directory);
+	}
+
+	std::string write(const std::string &name, const std::string &source)
+	{
+		std::filesystem::path path = directory / name;
+		std::ofstream(path) << source;
+		return path.string();
+	}
+};
+
+static int count(const std::string &text, const std::string &pattern)
+{
+	int found = 0;
+	for (std::size_t i = text.find(pattern); i != std::string::npos;
+	     i = text.find(pattern, i + 1)) {
+		found++;
+	}
+	return found;
+}
+
+TEST_F(ShaderPreprocessorTest, ExpandsIncludesOnce)
+{
+	write("include/common.glsl", "#version 330 core\nfloat common;\n");
+	write("include/light.glsl",
+	      "#include \"common.glsl\"\nfloat light;\n");
+	std::string root = write("root.frag",
+				 "#version 460 core\n"
+				 "#include \"include/common.glsl\"\n"
+				 "#include \"include/light.glsl\"\n"
+				 "void main() {}\n");
+
+	std::string source = ShaderPreprocessor::process(root);
+
+	EXPECT_EQ(count(source, "float common;"), 1);
+	EXPECT_EQ(count(source, "float light;"), 1);
+	EXPECT_EQ(count(source, "#version"), 1);
+	EXPECT_EQ(source.rfind("#version 460 core\n", 0), 0);
+	EXPECT_LT(source.find("float common;"), source.find("float light;"));
+	EXPECT_LT(source.find("float light;"), source.find("void main()"));
+}
+
+TEST_F(ShaderPreprocessorTest, DefinesFollowVersion)
+{
+	std::string root = write("root.vert", "#version 460 core\n"
+					      "#ifdef INDIRECT\n"
+					      "#endif\n");
+
+	std::string source = ShaderPreprocessor::process(
+		root, { { "MAX_LIGHTS", "4" }, { "INDIRECT", "" } });
+
+	EXPECT_EQ(source, "#version 460 core\n"
+			  "#define INDIRECT\n"
+			  "#define MAX_LIGHTS 4\n"
+			  "#ifdef INDIRECT\n"
+			  "#endif\n");
+}
+
+TEST_F(ShaderPreprocessorTest, HashIgnoresInsertionOrder)
+{
+	ShaderPreprocessor::Defines a;
+	a["SKINNED"] = "";
+	a["MAX_LIGHTS"] = "4";
+	ShaderPreprocessor::Defines b;
+	b["MAX_LIGHTS"] = "4";
+	b["SKINNED"] = "";
+
+	EXPECT_EQ(ShaderPreprocessor::hash(a), ShaderPreprocessor::hash(b));
+	b["MAX_LIGHTS"] = "8";
+	EXPECT_NE(ShaderPreprocessor::hash(a), ShaderPreprocessor::hash(b));
+}
+
+TEST_F(ShaderPreprocessorTest, MissingIncludeThrows)
+{
+	std::string root = write("root.frag", "#version 460 core\n"
+					      "#include \"missing.glsl\"\n");
+
+	EXPECT_THROW(ShaderPreprocessor::process(root), std::runtime_error);
+}
@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+#include <graphics/SkinningShader.h>
+#include <math/Matrix4f.h>
+#include <math/Vector3f.h>
+
+#include <array>
+#include <cmath>
+#include <vector>
+
+// Rotation of angle radians around a unit axis, then a translation
+static Matrix4f rigid(const Vector3f &axis, float angle,
+		      const Vector3f &translation)
+{
+	float c = std::cos(angle), s = std::sin(angle), t = 1 - c;
+	float x = axis.getX(), y = axis.getY(), z = axis.getZ();
+	float m[4][4] = {
+		{ t * x * x + c, t * x * y - s * z, t * x * z + s * y,
+		  translation.getX() },
+		{ t * x * y + s * z, t * y * y + c, t * y * z - s * x,
+		  translation.getY() },
+		{ t * x * z - s * y, t * y * z + s * x, t * z * z + c,
+		  translation.getZ() },
+		{ 0, 0, 0, 1 }
+	};
+	return Matrix4f(m);
+}
+
+static Vector3f transform(const Matrix4f &m, const Vector3f &v)
+{
+	return { m.get(0, 0) * v.getX() + m.get(0, 1) * v.getY() +
+			 m.get(0, 2) * v.getZ() + m.get(0, 3),
+		 m.get(1, 0) * v.getX() + m.get(1, 1) * v.getY() +
+			 m.get(1, 2) * v.getZ() + m.get(1, 3),
+		 m.get(2, 0) * v.getX() + m.get(2, 1) * v.getY() +
+			 m.get(2, 2) * v.getZ() + m.get(2, 3) };
+}
+
+// Same as the DUAL_QUATERNION path of shaders/skinning.vert
+static Vector3f transform(const std::array<float, 8> &dq, const Vector3f &p)
+{
+	Vector3f real(dq[0], dq[1], dq[2]), dual(dq[4], dq[5], dq[6]);
+	float real_w = dq[3], dual_w = dq[7];
+
+	Vector3f translation =
+		(dual * real_w - real * dual_w + real.cross(dual)) * 2.0f;
+	return p + real.cross(real.cross(p) + p * real_w) * 2.0f + translation;
+}
+
+static void expect_near(const Vector3f &a, const Vector3f &b)
+{
+	EXPECT_NEAR(a.getX(), b.getX(), 1e-4f);
+	EXPECT_NEAR(a.getY(), b.getY(), 1e-4f);
+	EXPECT_NEAR(a.getZ(), b.getZ(), 1e-4f);
+}
+
+TEST(SkinningShaderTest, DualQuaternionMatchesRigidMatrix)
+{
+	Vector3f axes[] = { Vector3f(0, 0, 1), Vector3f(1, 0, 0),
+			    Vector3f(1, 2, 3).normalize() };
+	float angles[] = { 0.0f, 0.5f, 2.0f, 3.1f };
+	Vector3f point(0.3f, -1.2f, 2.5f);
+
+	for (const Vector3f &axis : axes) {
+		for (float angle : angles) {
+			Matrix4f bone =
+				rigid(axis, angle, Vector3f(4, -2, 0.5f));
+			std::array<float, 8> dq =
+				SkinningShader::dual_quaternion(bone);
+
+			expect_near(transform(dq, point),
+				    transform(bone, point));
+		}
+	}
+}
+
+TEST(SkinningShaderTest, NormalMatrixKeepsNormalsPerpendicular)
+{
+	float m[4][4] = { { 2, 0, 0, 0 },
+			  { 0, 1, 0, 0 },
+			  { 0, 0, 0.5f, 0 },
+			  { 0, 0, 0, 1 } };
+	Matrix4f bone = Matrix4f(m) *
+			rigid(Vector3f(0, 1, 0), 0.7f, Vector3f(0, 0, 0));
+	std::array<float, 9> n = SkinningShader::normal_matrix(bone);
+
+	// A tangent and the normal of the plane it lies in
+	Vector3f tangent(1, 1, 0), normal(1, -1, 0);
+	Vector3f skinned_tangent = transform(bone, tangent);
+	Vector3f skinned_normal(
+		n[0] * normal.getX() + n[1] * normal.getY() +
+			n[2] * normal.getZ(),
+		n[3] * normal.getX() + n[4] * normal.getY() +
+			n[5] * normal.getZ(),
+		n[6] * normal.getX() + n[7] * normal.getY() +
+			n[8] * normal.getZ());
+
+	EXPECT_NEAR(skinned_tangent.dot(skinned_normal), 0.0f, 1e-4f);
+}
+
+TEST(SkinningShaderTest, PaletteSizePerMode)
+{
+	Matrix4f bone = Matrix4f::Identity_Matrix();
+	SkinningShader::Mode modes[] = { SkinningShader::Mode::LINEAR,
+					 SkinningShader::Mode::DUAL_QUATERNION };
+	for (SkinningShader::Mode mode : modes) {
+		std::vector<float> palette;
+		SkinningShader::pack_bone(mode, bone, palette);
+		EXPECT_EQ(palette.size(),
+			  SkinningShader::get_bone_texels(mode) * 4);
+	}
+	EXPECT_EQ(SkinningShader::get_bone_texels(
+			  SkinningShader::Mode::DUAL_QUATERNION),
+		  2);
+}
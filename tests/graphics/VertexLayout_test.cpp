@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include <graphics/VertexLayout.h>
+#include <graphics/Vertex.h>
+#include <math/Vector3f.h>
+#include <math/Vector2f.h>
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+class VertexLayoutTest : public ::testing::Test {
+    protected:
+	Vertex vertex{ { 1.0f, 2.0f, 3.0f },
+		       { 0.5f, 0.25f },
+		       { 0.0f, 1.0f, 0.0f } };
+
+	void SetUp() override
+	{
+		// Code here will run before each test
+	}
+
+	void TearDown() override
+	{
+		// Code here will run after each test
+	}
+};
+
+TEST_F(VertexLayoutTest, Strides)
+{
+	EXPECT_EQ(VertexLayout::STATIC.get_stride(), 20);
+	EXPECT_EQ(VertexLayout::SKINNED.get_stride(), 32);
+}
+
+TEST_F(VertexLayoutTest, SelectStatic)
+{
+	std::vector<Vertex> vertices{ vertex, vertex };
+	EXPECT_EQ(VertexLayout::select(vertices).get_type(),
+		  VertexLayout::Type::STATIC);
+}
+
+TEST_F(VertexLayoutTest, SelectSkinned)
+{
+	Vertex skinned = vertex;
+	skinned.boneIndices = { 3, 0, 0, 0 };
+	skinned.boneWeights = { 1.0f, 0.0f, 0.0f, 0.0f };
+	std::vector<Vertex> vertices{ vertex, skinned };
+	EXPECT_EQ(VertexLayout::select(vertices).get_type(),
+		  VertexLayout::Type::SKINNED);
+}
+
+TEST_F(VertexLayoutTest, HalfConversion)
+{
+	EXPECT_EQ(VertexLayout::to_half(0.0f), 0x0000);
+	EXPECT_EQ(VertexLayout::to_half(1.0f), 0x3C00);
+	EXPECT_EQ(VertexLayout::to_half(-2.0f), 0xC000);
+	EXPECT_EQ(VertexLayout::to_half(0.5f), 0x3800);
+	EXPECT_EQ(VertexLayout::to_half(1e10f), 0x7C00);
+}
+
+TEST_F(VertexLayoutTest, NormalPacking)
+{
+	EXPECT_EQ(VertexLayout::pack_normal({ 1.0f, 0.0f, 0.0f }), 0x1FFu);
+	EXPECT_EQ(VertexLayout::pack_normal({ 0.0f, -1.0f, 0.0f }),
+		  0x201u << 10);
+	EXPECT_EQ(VertexLayout::pack_normal({ 0.0f, 0.0f, 2.0f }),
+		  0x1FFu << 20);
+}
+
+TEST_F(VertexLayoutTest, PackStatic)
+{
+	std::vector<unsigned char> buffer = VertexLayout::STATIC.pack({ vertex });
+	ASSERT_EQ(buffer.size(), 20);
+
+	float position[3];
+	std::uint32_t normal;
+	std::uint16_t uv[2];
+	std::memcpy(position, buffer.data(), sizeof(position));
+	std::memcpy(&normal, buffer.data() + 12, sizeof(normal));
+	std::memcpy(uv, buffer.data() + 16, sizeof(uv));
+
+	EXPECT_EQ(position[0], 1.0f);
+	EXPECT_EQ(position[1], 2.0f);
+	EXPECT_EQ(position[2], 3.0f);
+	EXPECT_EQ(normal, 0x1FFu << 10);
+	EXPECT_EQ(uv[0], 0x3800);
+	EXPECT_EQ(uv[1], 0x3400);
+}
+
+TEST_F(VertexLayoutTest, PackSkinned)
+{
+	Vertex skinned = vertex;
+	skinned.boneIndices = { 7, 2, 0, 0 };
+	skinned.boneWeights = { 0.75f, 0.25f, 0.0f, 0.0f };
+
+	std::vector<unsigned char> buffer =
+		VertexLayout::SKINNED.pack({ skinned });
+	ASSERT_EQ(buffer.size(), 32);
+
+	std::uint16_t weights[4];
+	std::memcpy(weights, buffer.data() + 24, sizeof(weights));
+
+	EXPECT_EQ(buffer[20], 7);
+	EXPECT_EQ(buffer[21], 2);
+	EXPECT_EQ(weights[0], 49151);
+	EXPECT_EQ(weights[1], 16384);
+	EXPECT_EQ(weights[2], 0);
+}
+
+TEST_F(VertexLayoutTest, BoneIndexOutOfRange)
+{
+	Vertex skinned = vertex;
+	skinned.boneIndices = { 300, 0, 0, 0 };
+	skinned.boneWeights = { 1.0f, 0.0f, 0.0f, 0.0f };
+	EXPECT_THROW(VertexLayout::SKINNED.pack({ skinned }),
+		     std::runtime_error);
+}
@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+#include <physics/AnimationClip.h>
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <fstream>
+#include <filesystem>
+
+// Two channels over five frames: the first slides along x while turning
+// around y, the second grows while holding a rotation near -w
+static AnimationClip make_clip()
+{
+	std::vector<float> translations, rotations, scales;
+	for (int f = 0; f < 5; f++) {
+		float angle = f * 0.4f;
+		translations.insert(translations.end(),
+				    { f * 2.0f, 1, -3, 0.5f, 0.5f, 0.5f });
+		rotations.insert(rotations.end(),
+				 { 0, std::sin(angle / 2), 0,
+				   std::cos(angle / 2), 0.1f, 0.2f, 0.3f,
+				   -0.927f });
+		scales.insert(scales.end(),
+			      { 1, 1, 1, 1 + f * 0.25f, 1, 1 + f * 0.25f });
+	}
+	return AnimationClip({ "hip", "hand" }, 10.0f, translations,
+			     rotations, scales);
+}
+
+// Rotations are equal if they match up to sign
+static void expect_same_rotation(const float *a, const float *b)
+{
+	float dot = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+	EXPECT_NEAR(std::abs(dot), 1.0f, 1e-5f);
+}
+
+TEST(AnimationClipTest, SamplesFramesWithinQuantizationError)
+{
+	AnimationClip clip = make_clip();
+	EXPECT_EQ(clip.get_channel_count(), 2);
+	EXPECT_EQ(clip.get_frame_count(), 5);
+	EXPECT_FLOAT_EQ(clip.get_duration(), 0.4f);
+
+	std::vector<float> translations, rotations, scales;
+	clip.sample(0.2f, translations, rotations, scales);
+
+	EXPECT_NEAR(translations[0], 4.0f, 8.0f / 65535);
+	EXPECT_FLOAT_EQ(translations[1], 1.0f);
+	EXPECT_FLOAT_EQ(translations[3], 0.5f);
+	EXPECT_NEAR(scales[3], 1.5f, 1.0f / 65535);
+	EXPECT_FLOAT_EQ(scales[4], 1.0f);
+
+	float hip[4] = { 0, std::sin(0.4f), 0, std::cos(0.4f) };
+	float length = std::sqrt(0.01f + 0.04f + 0.09f + 0.927f * 0.927f);
+	float hand[4] = { 0.1f / length, 0.2f / length, 0.3f / length,
+			  -0.927f / length };
+	expect_same_rotation(&rotations[0], hip);
+	expect_same_rotation(&rotations[4], hand);
+}
+
+TEST(AnimationClipTest, InterpolatesBetweenFrames)
+{
+	AnimationClip clip = make_clip();
+	std::vector<float> translations, rotations, scales;
+	clip.sample(0.25f, translations, rotations, scales);
+
+	EXPECT_NEAR(translations[0], 5.0f, 1e-3f);
+	EXPECT_NEAR(scales[5], 1.625f, 1e-3f);
+
+	// Halfway between 0.8 and 1.2 radians lands on 1.0
+	float expected[4] = { 0, std::sin(0.5f), 0, std::cos(0.5f) };
+	expect_same_rotation(&rotations[0], expected);
+}
+
+TEST(AnimationClipTest, WrapsAroundDuration)
+{
+	AnimationClip clip = make_clip();
+	std::vector<float> a_translations, a_rotations, a_scales;
+	std::vector<float> b_translations, b_rotations, b_scales;
+	clip.sample(0.1f, a_translations, a_rotations, a_scales);
+	clip.sample(0.5f, b_translations, b_rotations, b_scales);
+
+	EXPECT_NEAR(a_translations[0], b_translations[0], 1e-3f);
+	EXPECT_NEAR(a_scales[3], b_scales[3], 1e-3f);
+}
+
+TEST(AnimationClipTest, SaveLoadRoundTrip)
+{
+	std::filesystem::path path = std::filesystem::temp_directory_path() /
+				     "animation_clip_test.anim";
+	AnimationClip clip = make_clip();
+	ASSERT_TRUE(clip.save(path.string()));
+
+	AnimationClip loaded;
+	ASSERT_TRUE(loaded.load(path.string()));
+	std::filesystem::remove(path);
+
+	EXPECT_EQ(loaded.get_frame_count(), clip.get_frame_count());
+	EXPECT_EQ(loaded.find_channel("hand"), 1);
+	EXPECT_EQ(loaded.find_channel("foot"), -1);
+
+	std::vector<float> a_translations, a_rotations, a_scales;
+	std::vector<float> b_translations, b_rotations, b_scales;
+	clip.sample(0.13f, a_translations, a_rotations, a_scales);
+	loaded.sample(0.13f, b_translations, b_rotations, b_scales);
+	EXPECT_EQ(a_translations, b_translations);
+	EXPECT_EQ(a_rotations, b_rotations);
+	EXPECT_EQ(a_scales, b_scales);
+
+	EXPECT_FALSE(loaded.load(path.string()));
+	EXPECT_EQ(loaded.get_channel_count(), 2);
+}
+
+TEST(AnimationClipTest, RejectsCorruptFiles)
+{
+	std::filesystem::path path = std::filesystem::temp_directory_path() /
+				     "animation_clip_corrupt.anim";
+	AnimationClip loaded = make_clip();
+
+	// Cut short in the keys
+	ASSERT_TRUE(make_clip().save(path.string()));
+	std::filesystem::resize_file(path,
+				     std::filesystem::file_size(path) - 4);
+	EXPECT_FALSE(loaded.load(path.string()));
+
+	// A channel count far beyond the file, and beyond any skeleton
+	for (std::uint32_t channels : { 1000u, 0xFFFFFFFFu }) {
+		ASSERT_TRUE(make_clip().save(path.string()));
+		std::fstream file(path, std::ios::binary | std::ios::in |
+						std::ios::out);
+		file.seekp(16);
+		file.write(reinterpret_cast<const char *>(&channels),
+			   sizeof(channels));
+		file.close();
+		EXPECT_FALSE(loaded.load(path.string()));
+	}
+	std::filesystem::remove(path);
+
+	EXPECT_EQ(loaded.get_channel_count(), 2);
+	EXPECT_EQ(loaded.get_frame_count(), 5);
+}
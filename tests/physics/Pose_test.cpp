@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include <physics/Pose.h>
+
+#include <math/Matrix4f.h>
+#include <math/Quaternion.h>
+
+#include <cmath>
+#include <vector>
+#include <stdexcept>
+
+static Matrix4f make_transform(float tx, float angle, float scale)
+{
+	Quaternion rotation(0, std::sin(angle / 2), 0, std::cos(angle / 2));
+	return Matrix4f::Translation_Matrix(tx, 2, -1) *
+	       rotation.to_rotation_matrix() *
+	       Matrix4f::Scale_Matrix(scale, scale, scale);
+}
+
+static void expect_matrix_near(const Matrix4f &a, const Matrix4f &b)
+{
+	for (int row = 0; row < 4; row++) {
+		for (int col = 0; col < 4; col++) {
+			EXPECT_NEAR(a.get(row, col), b.get(row, col), 1e-4f)
+				<< "at " << row << ", " << col;
+		}
+	}
+}
+
+// Six nodes, so the last lanes run over padding
+static Pose make_pose(float tx, float angle, float scale)
+{
+	Pose pose(6);
+	for (int i = 0; i < 6; i++) {
+		pose.set(i, make_transform(tx + i, angle + i * 0.1f, scale));
+	}
+	return pose;
+}
+
+TEST(PoseTest, SplitsAndRebuildsTransforms)
+{
+	Pose pose(6);
+	EXPECT_EQ(Pose::get_stride(6), 8);
+	expect_matrix_near(pose.get_transform(5), Matrix4f::Identity_Matrix());
+
+	// Angles on both sides of the trace switch
+	float angles[] = { 0, 0.5f, 2.0f, 3.1f, -2.5f, 1.0f };
+	for (int i = 0; i < 6; i++) {
+		Matrix4f transform = make_transform(i, angles[i], 1 + i * 0.5f);
+		pose.set(i, transform);
+		expect_matrix_near(pose.get_transform(i), transform);
+	}
+}
+
+TEST(PoseTest, CrossfadesEveryComponent)
+{
+	Pose a = make_pose(0, 0, 1);
+	Pose b = make_pose(4, 1, 3);
+
+	Pose start = a;
+	start.blend(b, 0);
+	Pose end = a;
+	end.blend(b, 1);
+	Pose half = a;
+	half.blend(b, 0.5f);
+	for (int i = 0; i < 6; i++) {
+		expect_matrix_near(start.get_transform(i), a.get_transform(i));
+		expect_matrix_near(end.get_transform(i), b.get_transform(i));
+		expect_matrix_near(half.get_transform(i),
+				   make_transform(2 + i, 0.5f + i * 0.1f, 2));
+	}
+}
+
+TEST(PoseTest, MaskLimitsTheBlend)
+{
+	Pose a = make_pose(0, 0, 1);
+	Pose b = make_pose(4, 1, 3);
+
+	std::vector<float> mask = { 0, 1, 0, 1, 0, 1, 0, 0 };
+	Pose masked = a;
+	masked.blend(b, 1, &mask);
+	for (int i = 0; i < 6; i++) {
+		expect_matrix_near(masked.get_transform(i),
+				   (i % 2 ? b : a).get_transform(i));
+	}
+
+	std::vector<float> short_mask(6, 1);
+	EXPECT_THROW(masked.blend(b, 1, &short_mask), std::runtime_error);
+	EXPECT_THROW(masked.blend(Pose(3), 1), std::runtime_error);
+}
+
+TEST(PoseTest, AddsTheDifferenceFromTheReference)
+{
+	Pose base = make_pose(1, 0.2f, 2);
+	Pose reference = make_pose(0, 0, 1);
+
+	// Nothing is added while the layer sits on its reference
+	Pose same = base;
+	same.add(reference, reference, 1);
+	for (int i = 0; i < 6; i++) {
+		expect_matrix_near(same.get_transform(i),
+				   base.get_transform(i));
+	}
+
+	// Moved 3 along x, turned 0.5 around y and scaled by 2
+	Pose other = make_pose(3, 0.5f, 2);
+	Pose added = base;
+	added.add(other, reference, 1);
+	Pose half = base;
+	half.add(other, reference, 0.5f);
+	for (int i = 0; i < 6; i++) {
+		expect_matrix_near(added.get_transform(i),
+				   make_transform(4 + i, 0.7f + i * 0.1f, 4));
+		expect_matrix_near(half.get_transform(i),
+				   make_transform(2.5f + i, 0.45f + i * 0.1f,
+						  3));
+	}
+}